@@ -0,0 +1,31 @@
+/*
+ * alloc-counter.h - Count heap allocations in a benchmark
+ *
+ * Replaces the global operator new/delete so a benchmark can read
+ * allocation_count before and after the code it measures. Defines the
+ * replacements, so include it from the benchmark's one source file only.
+ */
+
+#ifndef LOGILINUX_BENCH_ALLOC_COUNTER_H
+#define LOGILINUX_BENCH_ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocation_count(0);
+
+void *operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+#endif // LOGILINUX_BENCH_ALLOC_COUNTER_H
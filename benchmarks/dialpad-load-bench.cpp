@@ -0,0 +1,336 @@
+/*
+ * dialpad-load-bench - Drive a virtual MX Dialpad through /dev/uinput
+ *
+ * Creates a uinput device with the MX Dialpad's VID/PID and event codes, so
+ * the library discovers it as a regular DialpadDevice, then injects rotation
+ * frames at each requested rate and reports delivered events/sec, lost
+ * events and kernel-to-callback latency percentiles.
+ *
+ * Needs write access to /dev/uinput and read access to the new event node
+ * (usually root).
+ *
+ * Usage:
+ *   dialpad-load-bench [--rates R1,R2,...] [--duration SECONDS]
+ *                      [--queue CAPACITY]
+ */
+
+#include <logilinux/logilinux.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <linux/uinput.h>
+#include <sstream>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+constexpr uint16_t DIALPAD_VENDOR_ID = 0x046d;
+constexpr uint16_t DIALPAD_PRODUCT_ID = 0xbc00;
+constexpr const char *DEVICE_NAME = "Logitech MX Dialpad (load generator)";
+
+// Frames written per write(); bounds how far ahead of schedule we get
+constexpr size_t MAX_BATCH_FRAMES = 64;
+
+// Rotation events per frame: REL_HWHEEL and REL_HWHEEL_HI_RES
+constexpr uint64_t EVENTS_PER_FRAME = 2;
+
+class VirtualDialpad {
+public:
+  VirtualDialpad() : fd_(-1) {}
+  ~VirtualDialpad() {
+    if (fd_ >= 0) {
+      ioctl(fd_, UI_DEV_DESTROY);
+      close(fd_);
+    }
+  }
+
+  bool create() {
+    fd_ = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      return false;
+    }
+
+    ioctl(fd_, UI_SET_EVBIT, EV_REL);
+    ioctl(fd_, UI_SET_RELBIT, REL_HWHEEL);
+    ioctl(fd_, UI_SET_RELBIT, REL_HWHEEL_HI_RES);
+    ioctl(fd_, UI_SET_EVBIT, EV_KEY);
+    for (int code = BTN_SIDE; code <= BTN_BACK; code++) {
+      ioctl(fd_, UI_SET_KEYBIT, code);
+    }
+
+    struct uinput_setup setup = {};
+    setup.id.bustype = BUS_USB;
+    setup.id.vendor = DIALPAD_VENDOR_ID;
+    setup.id.product = DIALPAD_PRODUCT_ID;
+    strncpy(setup.name, DEVICE_NAME, UINPUT_MAX_NAME_SIZE - 1);
+
+    return ioctl(fd_, UI_DEV_SETUP, &setup) == 0 &&
+           ioctl(fd_, UI_DEV_CREATE) == 0;
+  }
+
+  /**
+   * /dev/input/eventN node of the device, once the kernel has created it
+   */
+  std::string eventNode() const {
+    char sysname[64] = {};
+    if (ioctl(fd_, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+      return "";
+    }
+
+    std::string sys_dir = std::string("/sys/devices/virtual/input/") + sysname;
+    DIR *dir = opendir(sys_dir.c_str());
+    if (!dir) {
+      return "";
+    }
+
+    std::string node;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      if (strncmp(entry->d_name, "event", 5) == 0) {
+        node = std::string("/dev/input/") + entry->d_name;
+        break;
+      }
+    }
+    closedir(dir);
+    return node;
+  }
+
+  /**
+   * Inject frames one detent each; a button toggles every 256 frames
+   */
+  bool writeFrames(size_t frames, uint64_t &sequence) {
+    struct input_event events[MAX_BATCH_FRAMES * 4];
+    size_t count = 0;
+
+    auto push = [&](uint16_t type, uint16_t code, int32_t value) {
+      memset(&events[count], 0, sizeof(events[count]));
+      events[count].type = type;
+      events[count].code = code;
+      events[count].value = value;
+      count++;
+    };
+
+    for (size_t i = 0; i < frames; i++, sequence++) {
+      push(EV_REL, REL_HWHEEL, 1);
+      push(EV_REL, REL_HWHEEL_HI_RES, 120);
+      if (sequence % 256 == 255) {
+        push(EV_KEY, BTN_SIDE, (sequence / 256) % 2 ? 0 : 1);
+      }
+      push(EV_SYN, SYN_REPORT, 0);
+    }
+
+    size_t bytes = count * sizeof(struct input_event);
+    return write(fd_, events, bytes) == static_cast<ssize_t>(bytes);
+  }
+
+private:
+  int fd_;
+};
+
+struct RunResult {
+  uint64_t sent;
+  uint64_t delivered;
+  double seconds;
+  LogiLinux::LatencyHistogram latency;
+};
+
+static std::vector<uint64_t> parseRates(const std::string &list) {
+  std::vector<uint64_t> rates;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    uint64_t rate = std::strtoull(item.c_str(), nullptr, 10);
+    if (rate > 0) {
+      rates.push_back(rate);
+    }
+  }
+  return rates;
+}
+
+static RunResult runRate(VirtualDialpad &generator,
+                         LogiLinux::DevicePtr &device,
+                         std::atomic<uint64_t> &delivered, uint64_t rate,
+                         double duration) {
+  uint64_t total_frames =
+      static_cast<uint64_t>(rate * duration) / EVENTS_PER_FRAME;
+  uint64_t frames_sent = 0;
+  uint64_t sequence = 0;
+
+  device->resetLatencyHistogram();
+  uint64_t delivered_before = delivered.load();
+
+  auto start = std::chrono::steady_clock::now();
+  while (frames_sent < total_frames) {
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    uint64_t due = std::min<uint64_t>(
+        total_frames,
+        static_cast<uint64_t>(elapsed * rate / EVENTS_PER_FRAME) + 1);
+
+    if (due > frames_sent) {
+      size_t frames = static_cast<size_t>(
+          std::min<uint64_t>(due - frames_sent, MAX_BATCH_FRAMES));
+      if (!generator.writeFrames(frames, sequence)) {
+        break;
+      }
+      frames_sent += frames;
+    } else {
+      // Sleep until the next frame is due
+      double next = static_cast<double>(frames_sent) * EVENTS_PER_FRAME / rate;
+      std::this_thread::sleep_for(
+          std::chrono::duration<double>(next - elapsed));
+    }
+  }
+
+  // Let the reactor catch up before counting
+  uint64_t last = delivered.load();
+  for (int idle = 0; idle < 5;) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t now = delivered.load();
+    idle = now == last ? idle + 1 : 0;
+    last = now;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  RunResult result;
+  result.sent = frames_sent * EVENTS_PER_FRAME;
+  result.delivered = delivered.load() - delivered_before;
+  result.seconds = seconds;
+  result.latency = device->getLatencyHistogram();
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<uint64_t> rates = {1000, 10000, 100000, 1000000};
+  double duration = 2.0;
+  size_t queue_capacity = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--rates" && i + 1 < argc) {
+      rates = parseRates(argv[++i]);
+    } else if (arg == "--duration" && i + 1 < argc) {
+      duration = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--queue" && i + 1 < argc) {
+      queue_capacity = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--rates R1,R2,...] [--duration SECONDS]"
+                << " [--queue CAPACITY]" << std::endl;
+      return 1;
+    }
+  }
+
+  VirtualDialpad generator;
+  if (!generator.create()) {
+    std::cerr << "Error: Failed to create uinput device: " << strerror(errno)
+              << std::endl;
+    return 1;
+  }
+
+  // udev may need a moment to create the node and apply permissions
+  std::string node;
+  LogiLinux::Library lib;
+  LogiLinux::DevicePtr device;
+  for (int attempt = 0; attempt < 50 && !device; attempt++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    node = generator.eventNode();
+    for (const auto &candidate : lib.discoverDevices()) {
+      if (candidate->getInfo().device_path == node &&
+          candidate->getType() == LogiLinux::DeviceType::DIALPAD) {
+        device = candidate;
+      }
+    }
+  }
+
+  if (!device) {
+    std::cerr << "Error: Virtual dialpad " << node << " was not discovered"
+              << std::endl;
+    return 1;
+  }
+
+  std::atomic<uint64_t> delivered(0);
+  std::atomic<bool> draining(true);
+  std::thread drain_thread;
+
+  auto count = [&delivered](const LogiLinux::EventRecord &event) {
+    if (event.type == LogiLinux::EventType::ROTATION) {
+      delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  if (queue_capacity > 0) {
+    device->enableEventQueue(queue_capacity,
+                             LogiLinux::OverflowPolicy::DROP_OLDEST);
+    drain_thread = std::thread([&]() {
+      LogiLinux::EventRecord events[256];
+      while (draining) {
+        size_t n = device->pollEvents(events);
+        for (size_t i = 0; i < n; i++) {
+          count(events[i]);
+        }
+        if (n == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+    });
+  } else {
+    device->setEventRecordCallback(count);
+  }
+
+  device->startMonitoring();
+  if (!device->isMonitoring()) {
+    std::cerr << "Error: Failed to monitor " << node << std::endl;
+    return 1;
+  }
+
+  std::cout << "Virtual dialpad: " << node << " ("
+            << (queue_capacity ? "event queue" : "record callback") << ")"
+            << std::endl;
+  std::cout << std::setw(10) << "rate/s" << std::setw(12) << "sent"
+            << std::setw(12) << "delivered" << std::setw(10) << "lost"
+            << std::setw(14) << "events/s" << std::setw(10) << "p50 us"
+            << std::setw(10) << "p99 us" << std::setw(10) << "p99.9 us"
+            << std::setw(10) << "max us" << std::endl;
+
+  for (uint64_t rate : rates) {
+    RunResult result = runRate(generator, device, delivered, rate, duration);
+    uint64_t lost =
+        result.sent > result.delivered ? result.sent - result.delivered : 0;
+
+    std::cout << std::fixed << std::setprecision(1) << std::setw(10) << rate
+              << std::setw(12) << result.sent << std::setw(12)
+              << result.delivered << std::setw(10) << lost << std::setw(14)
+              << static_cast<uint64_t>(result.delivered / result.seconds)
+              << std::setw(10) << result.latency.percentile(50) / 1000.0
+              << std::setw(10) << result.latency.percentile(99) / 1000.0
+              << std::setw(10) << result.latency.percentile(99.9) / 1000.0
+              << std::setw(10) << result.latency.max_ns / 1000.0 << std::endl;
+  }
+
+  device->stopMonitoring();
+  draining = false;
+  if (drain_thread.joinable()) {
+    drain_thread.join();
+  }
+
+  if (queue_capacity > 0) {
+    auto stats = device->getEventQueueStats();
+    std::cout << "Queue: " << stats.dropped << " dropped, high water "
+              << stats.high_water << "/" << stats.capacity << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * discovery-bench - Time device discovery against a fake sysfs tree
+ *
+ * Builds a temporary sysfs/dev tree laid out like the kernel's, with many
+ * unrelated input and hidraw nodes, one MX Dialpad and two MX Keypads whose
+ * hidraw nodes sit on another USB interface (and above hidraw20). It times
+ * the first DeviceRegistry scan and repeated rescans over the tree, and
+ * checks that every keypad event node was paired with its own hidraw node
+ * and that rescans keep the existing device objects. A third keypad whose
+ * hidraw node only appears between two rescans must be paired in place.
+ *
+ * Usage:
+ *   discovery-bench [--inputs N] [--hidraws N] [--iterations N]
+ */
+
+#include "../lib/src/core/device_registry.h"
+#include "fake-sysfs.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+  int inputs = 256;
+  int hidraws = 48;
+  int iterations = 200;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--inputs" && i + 1 < argc) {
+      inputs = std::atoi(argv[++i]);
+    } else if (arg == "--hidraws" && i + 1 < argc) {
+      hidraws = std::atoi(argv[++i]);
+    } else if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--inputs N] [--hidraws N] [--iterations N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (iterations < 1) {
+    std::cerr << "Error: need at least 1 iteration" << std::endl;
+    return 1;
+  }
+
+  FakeTree tree = createFakeTree();
+
+  // Unrelated devices first so ours land on high node numbers
+  addUnrelatedDevices(tree, inputs, hidraws);
+
+  fs::path dialpad = addHidDevice(tree, "1-1", 0, 0x046d, 0xbc00);
+  addInputNode(tree, dialpad, 0x046d, 0xbc00, "Logitech MX Dialpad",
+               "usb-0000:00:14.0-1/input0");
+
+  Keypad first;
+  Keypad second;
+  addKeypad(tree, "1-2", first);
+  addKeypad(tree, "1-3", second);
+
+  LogiLinux::DeviceRegistry registry(
+      std::make_unique<LogiLinux::DeviceManager>(
+          (tree.root / "sys").string(), (tree.root / "dev").string()));
+
+  auto first_start = std::chrono::steady_clock::now();
+  auto devices = registry.scan();
+  double first_seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - first_start)
+                             .count();
+
+  // Rescans of an unchanged tree must hand back the same objects
+  size_t found = 0;
+  bool preserved = true;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    auto rescanned = registry.scan();
+    found = rescanned.size();
+    preserved = preserved && rescanned == devices;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::cout << "Tree: " << tree.next_input << " input nodes, "
+            << tree.next_hidraw << " hidraw nodes" << std::endl;
+  std::cout << "First scan: " << first_seconds * 1e6 << " us, "
+            << devices.size() << " devices" << std::endl;
+  std::cout << "Rescan:     " << (seconds / iterations) * 1e6
+            << " us per scan, " << found << " devices"
+            << (preserved ? ", all kept" : ", objects replaced") << std::endl;
+
+  bool paired = true;
+  for (const auto &device : devices) {
+    const auto &info = device->getInfo();
+    std::cout << "  " << fs::path(info.device_path).filename().string()
+              << " -> "
+              << (info.hidraw_path.empty()
+                      ? "-"
+                      : fs::path(info.hidraw_path).filename().string())
+              << "  " << info.identity << std::endl;
+
+    for (const Keypad *keypad : {&first, &second}) {
+      if (info.device_path == keypad->event_path &&
+          info.hidraw_path != keypad->hidraw_path) {
+        paired = false;
+      }
+    }
+  }
+
+  // A keypad scanned before its hidraw node exists, without hotplug
+  std::string phys = "usb-0000:00:14.0-4";
+  writeFile(tree.root / "sys/devices/pci0000:00/usb1/1-4/serial", "KP1-4\n");
+  fs::path keys = addHidDevice(tree, "1-4", 0, 0x046d, 0xc354);
+  std::string late_event =
+      addInputNode(tree, keys, 0x046d, 0xc354, "Logitech MX Creative Keypad",
+                   phys + "/input0");
+  LogiLinux::DevicePtr late;
+  for (const auto &device : registry.scan()) {
+    if (device->getInfo().device_path == late_event) {
+      late = device;
+    }
+  }
+
+  fs::path hidpp = addHidDevice(tree, "1-4", 2, 0x046d, 0xc354);
+  std::string late_hidraw =
+      addHidrawNode(tree, hidpp, 0x046d, 0xc354, "Logitech MX Creative Keypad",
+                    phys + "/input2", "");
+  size_t connected = 0;
+  size_t disconnected = 0;
+  registry.scan([&](LogiLinux::DeviceEventPtr event, LogiLinux::DevicePtr) {
+    if (event->type == LogiLinux::EventType::DEVICE_CONNECTED) {
+      connected++;
+    } else {
+      disconnected++;
+    }
+  });
+
+  // The hidraw node's own device, and the event node's again once paired
+  bool paired_late = late && connected == 2 && disconnected == 0 &&
+                     late->getInfo().hidraw_path == late_hidraw;
+  std::cout << "Late hidraw: "
+            << (paired_late ? "paired in place" : "device replaced")
+            << std::endl;
+
+  fs::remove_all(tree.root);
+
+  // Dialpad, two keypad event nodes and two keypad hidraw nodes
+  if (found != 5 || !paired || !preserved) {
+    std::cerr << "Error: expected the same 5 devices on every scan with each "
+                 "keypad paired to its own hidraw node"
+              << std::endl;
+    return 1;
+  }
+  if (!paired_late) {
+    std::cerr << "Error: a keypad whose hidraw node appeared later was not "
+                 "paired in place by a rescan"
+              << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
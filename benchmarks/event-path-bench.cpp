@@ -0,0 +1,143 @@
+/*
+ * event-path-bench - Compare event delivery paths
+ *
+ * Feeds synthetic dialpad traffic through the real evdev decoder and
+ * measures events/sec and heap allocations per event for the legacy
+ * shared_ptr<Event> callback and the EventRecord callback.
+ *
+ * Usage:
+ *   event-path-bench [--frames N]
+ */
+
+#include "../lib/src/core/event_dispatcher.h"
+#include "../lib/src/core/input_monitor.h"
+#include "alloc-counter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One dial detent followed by a button press/release every 16 frames
+static std::vector<struct input_event> buildTraffic(size_t frames) {
+  std::vector<struct input_event> traffic;
+  traffic.reserve(frames * 3);
+
+  auto push = [&traffic](uint16_t type, uint16_t code, int32_t value) {
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    traffic.push_back(ev);
+  };
+
+  for (size_t i = 0; i < frames; i++) {
+    if (i % 16 == 15) {
+      push(EV_KEY, 275, (i / 16) % 2 ? 0 : 1);
+    } else {
+      push(EV_REL, REL_HWHEEL, 1);
+      push(EV_REL, REL_HWHEEL_HI_RES, 120);
+    }
+    push(EV_SYN, SYN_REPORT, 0);
+  }
+
+  return traffic;
+}
+
+struct Result {
+  uint64_t events;
+  double seconds;
+  uint64_t allocations;
+};
+
+static Result run(LogiLinux::EventDispatcher &dispatcher,
+                  const std::vector<struct input_event> &traffic) {
+  LogiLinux::InputMonitor monitor("", dispatcher);
+
+  uint64_t allocs_before = allocation_count.load();
+  auto start = std::chrono::steady_clock::now();
+
+  monitor.processEvents(traffic.data(), traffic.size());
+
+  auto end = std::chrono::steady_clock::now();
+  uint64_t allocs_after = allocation_count.load();
+
+  return {0, std::chrono::duration<double>(end - start).count(),
+          allocs_after - allocs_before};
+}
+
+static void report(const char *name, const Result &result) {
+  std::cout << std::left << std::setw(22) << name << std::right
+            << std::setw(14) << std::fixed << std::setprecision(0)
+            << (result.events / result.seconds) << " events/s"
+            << std::setw(10) << std::setprecision(2)
+            << (result.events ? static_cast<double>(result.allocations) /
+                                    result.events
+                              : 0.0)
+            << " allocs/event" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t frames = 2000000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--frames N]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto traffic = buildTraffic(frames);
+
+  int64_t checksum = 0;
+
+  // Legacy path: one shared_ptr per event plus a dynamic_pointer_cast
+  uint64_t legacy_events = 0;
+  LogiLinux::EventDispatcher legacy;
+  legacy.setEventCallback([&](LogiLinux::EventPtr event) {
+    legacy_events++;
+    if (auto rotation =
+            std::dynamic_pointer_cast<LogiLinux::RotationEvent>(event)) {
+      checksum += rotation->delta_high_res;
+    } else if (auto button =
+                   std::dynamic_pointer_cast<LogiLinux::ButtonEvent>(event)) {
+      checksum += button->pressed;
+    }
+  });
+  Result legacy_result = run(legacy, traffic);
+  legacy_result.events = legacy_events;
+
+  // Record path: const reference to a trivially copyable record
+  uint64_t record_events = 0;
+  LogiLinux::EventDispatcher records;
+  records.setRecordCallback([&](const LogiLinux::EventRecord &event) {
+    record_events++;
+    if (event.type == LogiLinux::EventType::ROTATION) {
+      checksum -= event.rotation.delta_high_res;
+    } else {
+      checksum -= event.button.pressed;
+    }
+  });
+  Result record_result = run(records, traffic);
+  record_result.events = record_events;
+
+  std::cout << "Frames: " << frames << ", events per path: " << record_events
+            << std::endl;
+  report("EventCallback", legacy_result);
+  report("EventRecordCallback", record_result);
+
+  if (checksum != 0 || legacy_events != record_events) {
+    std::cerr << "Error: paths delivered different events" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * executor-bench - Measure handing slow work to an ActionExecutor
+ *
+ * Simulates a dial spun fast while its handler drives something as slow as
+ * pactl: detents arrive every --interval microseconds and each queues a
+ * "volume" step whose action sleeps for --action-ms. Reports what the
+ * handler pays per submission, how many actions actually ran and their
+ * queue latency, and checks that coalescing lost no steps.
+ *
+ * Usage:
+ *   executor-bench [--detents N] [--interval US] [--action-ms N]
+ */
+
+#include <logilinux/action_executor.h>
+#include <logilinux/events.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  int detents = 2000;
+  int interval_us = 1000;
+  int action_ms = 20;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--detents" && i + 1 < argc) {
+      detents = std::atoi(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval_us = std::atoi(argv[++i]);
+    } else if (arg == "--action-ms" && i + 1 < argc) {
+      action_ms = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--detents N] [--interval US] [--action-ms N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (detents < 1) {
+    std::cerr << "Error: need at least 1 detent" << std::endl;
+    return 1;
+  }
+
+  std::atomic<int64_t> applied(0);
+  auto slowAction = [&applied, action_ms](int64_t steps) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(action_ms));
+    applied.fetch_add(steps);
+  };
+
+  LogiLinux::ActionExecutor executor(1);
+  std::vector<uint64_t> submit_ns;
+  submit_ns.reserve(detents);
+  int rejected = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < detents; i++) {
+    uint64_t before = LogiLinux::getMonotonicTimestamp();
+    if (!executor.submit("volume", 1, slowAction)) {
+      rejected++;
+    }
+    submit_ns.push_back(LogiLinux::getMonotonicTimestamp() - before);
+
+    std::this_thread::sleep_until(start +
+                                  std::chrono::microseconds(interval_us) *
+                                      (i + 1));
+  }
+  executor.wait();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::sort(submit_ns.begin(), submit_ns.end());
+  auto stats = executor.getStats();
+
+  std::cout << "Detents: " << detents << " in " << seconds << " s, "
+            << stats.executed << " actions run, " << stats.coalesced
+            << " coalesced" << std::endl;
+  std::cout << "Submit: p50 " << submit_ns[submit_ns.size() / 2]
+            << " ns, p99 " << submit_ns[submit_ns.size() * 99 / 100]
+            << " ns, max " << submit_ns.back() << " ns" << std::endl;
+  std::cout << "Queue latency: p50 "
+            << stats.queue_latency.percentile(50) / 1000 << " us, p99 "
+            << stats.queue_latency.percentile(99) / 1000 << " us" << std::endl;
+  std::cout << "Execution: p50 "
+            << stats.execution_latency.percentile(50) / 1000 << " us"
+            << std::endl;
+
+  if (rejected > 0 || applied.load() != detents ||
+      stats.submitted != static_cast<uint64_t>(detents)) {
+    std::cerr << "Error: applied " << applied.load() << " of " << detents
+              << " steps, " << rejected << " rejected" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
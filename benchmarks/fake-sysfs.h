@@ -0,0 +1,157 @@
+/*
+ * fake-sysfs.h - Kernel-shaped sysfs and /dev trees for the benchmarks
+ *
+ * Lays out HID devices below USB interfaces with input and hidraw children,
+ * class/input and class/hidraw symlinks and empty /dev nodes, so discovery
+ * and hotplug can run against a temporary directory.
+ */
+
+#ifndef LOGILINUX_BENCH_FAKE_SYSFS_H
+#define LOGILINUX_BENCH_FAKE_SYSFS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+struct FakeTree {
+  fs::path root;
+  int next_input = 0;
+  int next_hidraw = 0;
+  int next_hid = 1;
+};
+
+inline void writeFile(const fs::path &path, const std::string &contents) {
+  fs::create_directories(path.parent_path());
+  std::ofstream(path) << contents;
+}
+
+inline std::string hex4(unsigned value) {
+  char text[8];
+  snprintf(text, sizeof(text), "%04x", value);
+  return text;
+}
+
+// A HID device below a USB interface, as
+// /sys/devices/.../<usb>/<usb>:1.<interface>/0003:VVVV:PPPP.NNNN
+inline fs::path addHidDevice(FakeTree &tree, const std::string &usb_device,
+                             int interface, unsigned vendor,
+                             unsigned product) {
+  char hid_name[32];
+  snprintf(hid_name, sizeof(hid_name), "0003:%04X:%04X.%04X", vendor, product,
+           tree.next_hid++);
+  fs::path hid = tree.root / "sys/devices/pci0000:00/usb1" / usb_device /
+                 (usb_device + ":1." + std::to_string(interface)) / hid_name;
+  fs::create_directories(hid);
+  return hid;
+}
+
+inline std::string addInputNode(FakeTree &tree, const fs::path &hid,
+                                unsigned vendor, unsigned product,
+                                const std::string &name,
+                                const std::string &phys) {
+  int index = tree.next_input++;
+  std::string event = "event" + std::to_string(index);
+  fs::path input = hid / "input" / ("input" + std::to_string(index));
+
+  writeFile(input / "id/vendor", hex4(vendor) + "\n");
+  writeFile(input / "id/product", hex4(product) + "\n");
+  writeFile(input / "name", name + "\n");
+  writeFile(input / "phys", phys + "\n");
+  writeFile(input / "uniq", "\n");
+  fs::create_symlink("../..", input / "device");
+  fs::create_directories(input / event);
+  fs::create_symlink("..", input / event / "device");
+
+  fs::create_directories(tree.root / "sys/class/input");
+  fs::create_symlink(input / event, tree.root / "sys/class/input" / event);
+  writeFile(tree.root / "dev/input" / event, "");
+  return (tree.root / "dev/input" / event).string();
+}
+
+// Another handler's node (mouseN, jsN) on the input device of an event
+// node made by addInputNode(), as mousedev adds for anything with a wheel
+inline std::string addHandlerNode(FakeTree &tree, const std::string &event_path,
+                                  const std::string &node) {
+  fs::path event = fs::path(event_path).filename();
+  fs::path input =
+      fs::canonical(tree.root / "sys/class/input" / event).parent_path();
+  fs::create_directories(input / node);
+  fs::create_symlink("..", input / node / "device");
+  fs::create_symlink(input / node, tree.root / "sys/class/input" / node);
+  writeFile(tree.root / "dev/input" / node, "");
+  return (tree.root / "dev/input" / node).string();
+}
+
+inline std::string addHidrawNode(FakeTree &tree, const fs::path &hid,
+                                 unsigned vendor, unsigned product,
+                                 const std::string &name,
+                                 const std::string &phys,
+                                 const std::string &uniq) {
+  std::string node = "hidraw" + std::to_string(tree.next_hidraw++);
+  char hid_id[32];
+  snprintf(hid_id, sizeof(hid_id), "0003:%08X:%08X", vendor, product);
+
+  writeFile(hid / "uevent", "DRIVER=hid-generic\nHID_ID=" +
+                                std::string(hid_id) + "\nHID_NAME=" + name +
+                                "\nHID_PHYS=" + phys + "\nHID_UNIQ=" + uniq +
+                                "\n");
+  fs::create_directories(hid / "hidraw" / node);
+  fs::create_symlink("../..", hid / "hidraw" / node / "device");
+
+  fs::create_directories(tree.root / "sys/class/hidraw");
+  fs::create_symlink(hid / "hidraw" / node,
+                     tree.root / "sys/class/hidraw" / node);
+  writeFile(tree.root / "dev" / node, "");
+  return (tree.root / "dev" / node).string();
+}
+
+struct Keypad {
+  std::string event_path;
+  std::string hidraw_path;
+};
+
+inline void addKeypad(FakeTree &tree, const std::string &usb_device,
+                      Keypad &keypad) {
+  std::string phys = "usb-0000:00:14.0-" + usb_device.substr(2);
+  fs::path keys = addHidDevice(tree, usb_device, 0, 0x046d, 0xc354);
+  keypad.event_path = addInputNode(tree, keys, 0x046d, 0xc354,
+                                   "Logitech MX Creative Keypad",
+                                   phys + "/input0");
+  fs::path hidpp = addHidDevice(tree, usb_device, 2, 0x046d, 0xc354);
+  keypad.hidraw_path =
+      addHidrawNode(tree, hidpp, 0x046d, 0xc354, "Logitech MX Creative Keypad",
+                    phys + "/input2", "");
+  writeFile(tree.root / "sys/devices/pci0000:00/usb1" / usb_device / "serial",
+            "KP" + usb_device + "\n");
+}
+
+// Empty tree in a fresh temporary directory
+inline FakeTree createFakeTree() {
+  char dir_template[] = "/tmp/logilinux-sysfs-XXXXXX";
+  FakeTree tree;
+  tree.root = mkdtemp(dir_template);
+  return tree;
+}
+
+// Input devices from other vendors (and other Logitech products), the
+// first hidraws of them with a hidraw node as well
+inline void addUnrelatedDevices(FakeTree &tree, int inputs, int hidraws) {
+  for (int i = 0; i < inputs; i++) {
+    std::string usb_device = "1-" + std::to_string(100 + i);
+    std::string phys = "usb-0000:00:14.0-" + std::to_string(100 + i);
+    unsigned vendor = i % 3 ? 0x04f3 : 0x046d;
+
+    fs::path hid = addHidDevice(tree, usb_device, 0, vendor, 0x0c4b);
+    addInputNode(tree, hid, vendor, 0x0c4b, "Input device", phys + "/input0");
+    if (i < hidraws) {
+      addHidrawNode(tree, hid, vendor, 0x0c4b, "HID device", phys + "/input0",
+                    "");
+    }
+  }
+}
+
+#endif // LOGILINUX_BENCH_FAKE_SYSFS_H
@@ -0,0 +1,279 @@
+/*
+ * hotplug-bench - Time hotplug handling against a fake sysfs tree
+ *
+ * Builds the same kind of tree as discovery-bench, then repeatedly "plugs
+ * in" an MX Keypad by creating its nodes and feeding add uevents through a
+ * fake UeventSource into HotplugMonitor and DeviceRegistry, exactly as the
+ * netlink source would. It reports how long it takes until the keypad's
+ * event node is registered and paired with its hidraw node, and until both
+ * are gone again after the remove uevents, next to the cost of a full scan.
+ * Checks that pairing keeps the event node's device object, also across a
+ * hidraw node going away and coming back on its own, and that the
+ * mouseN/jsN nodes the kernel adds next to event nodes register nothing.
+ *
+ * Usage:
+ *   hotplug-bench [--inputs N] [--hidraws N] [--iterations N]
+ */
+
+#include "../lib/src/core/device_registry.h"
+#include "../lib/src/core/hotplug_monitor.h"
+#include "fake-sysfs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Messages pushed by the benchmark, signalled through a pipe
+class FakeUeventSource : public LogiLinux::UeventSource {
+public:
+  FakeUeventSource() {
+    if (pipe(pipe_fds_) < 0) {
+      pipe_fds_[0] = pipe_fds_[1] = -1;
+    }
+  }
+
+  ~FakeUeventSource() override {
+    close(pipe_fds_[0]);
+    close(pipe_fds_[1]);
+  }
+
+  void push(const std::string &action, const std::string &subsystem,
+            const std::string &devname) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back({action, subsystem, devname});
+    }
+    char byte = 0;
+    ssize_t ret = write(pipe_fds_[1], &byte, 1);
+    (void)ret;
+  }
+
+  int fd() const override { return pipe_fds_[0]; }
+
+  bool read(std::vector<LogiLinux::UeventMessage> &messages) override {
+    char byte;
+    ssize_t ret = ::read(pipe_fds_[0], &byte, 1);
+    (void)ret;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_.empty()) {
+      messages.push_back(pending_.front());
+      pending_.pop_front();
+    }
+    return true;
+  }
+
+private:
+  int pipe_fds_[2];
+  std::mutex mutex_;
+  std::deque<LogiLinux::UeventMessage> pending_;
+};
+
+struct ChangeLog {
+  std::mutex mutex;
+  std::condition_variable changed;
+  size_t connected = 0;
+  size_t disconnected = 0;
+  LogiLinux::DevicePtr first; // First device connected since the last reset
+};
+
+static double percentile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(p * (values.size() - 1));
+  return values[index];
+}
+
+static std::string devname(const FakeTree &tree, const std::string &path) {
+  return path.substr((tree.root / "dev").string().size() + 1);
+}
+
+int main(int argc, char *argv[]) {
+  int inputs = 256;
+  int hidraws = 48;
+  int iterations = 100;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--inputs" && i + 1 < argc) {
+      inputs = std::atoi(argv[++i]);
+    } else if (arg == "--hidraws" && i + 1 < argc) {
+      hidraws = std::atoi(argv[++i]);
+    } else if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--inputs N] [--hidraws N] [--iterations N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (iterations < 1) {
+    std::cerr << "Error: need at least 1 iteration" << std::endl;
+    return 1;
+  }
+
+  FakeTree tree = createFakeTree();
+  addUnrelatedDevices(tree, inputs, hidraws);
+
+  fs::path dialpad = addHidDevice(tree, "1-1", 0, 0x046d, 0xbc00);
+  std::string dialpad_event =
+      addInputNode(tree, dialpad, 0x046d, 0xbc00, "Logitech MX Dialpad",
+                   "usb-0000:00:14.0-1/input0");
+  std::string dialpad_mouse = addHandlerNode(tree, dialpad_event, "mouse0");
+
+  LogiLinux::DeviceRegistry registry(
+      std::make_unique<LogiLinux::DeviceManager>(
+          (tree.root / "sys").string(), (tree.root / "dev").string()));
+
+  auto scan_start = std::chrono::steady_clock::now();
+  size_t baseline = registry.scan().size();
+  double scan_us = std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - scan_start)
+                       .count();
+
+  auto owned_source = std::make_unique<FakeUeventSource>();
+  FakeUeventSource *source = owned_source.get();
+  LogiLinux::HotplugMonitor monitor(std::move(owned_source));
+
+  ChangeLog log;
+  bool started = monitor.start([&](const LogiLinux::UeventMessage &message) {
+    registry.handleUevent(message, [&](LogiLinux::DeviceEventPtr event,
+                                       LogiLinux::DevicePtr device) {
+      std::lock_guard<std::mutex> lock(log.mutex);
+      if (event->type == LogiLinux::EventType::DEVICE_CONNECTED) {
+        if (log.connected++ == 0) {
+          log.first = device;
+        }
+      } else {
+        log.disconnected++;
+      }
+      log.changed.notify_all();
+    });
+  });
+  if (!started) {
+    std::cerr << "Error: could not start the hotplug monitor" << std::endl;
+    fs::remove_all(tree.root);
+    return 1;
+  }
+
+  std::vector<double> add_us;
+  std::vector<double> remove_us;
+  bool paired = true;
+  bool handlers_registered = false;
+
+  // Straight into the registry as well, past the monitor's own filter
+  registry.handleUevent({"add", "input", devname(tree, dialpad_mouse)},
+                        [&](LogiLinux::DeviceEventPtr,
+                            LogiLinux::DevicePtr) {
+                          handlers_registered = true;
+                        });
+
+  for (int i = 0; i < iterations; i++) {
+    Keypad keypad;
+    addKeypad(tree, "1-" + std::to_string(10 + i), keypad);
+    std::string keypad_js =
+        addHandlerNode(tree, keypad.event_path, "js" + std::to_string(i));
+
+    // Kernel order: the keys' event node and its other handlers, then the
+    // hidraw node on the later interface, which is attached to the event
+    // node's device and reports it connected again
+    auto start = std::chrono::steady_clock::now();
+    source->push("add", "input", devname(tree, keypad.event_path));
+    source->push("add", "input", devname(tree, keypad_js));
+    source->push("add", "hidraw", devname(tree, keypad.hidraw_path));
+    {
+      std::unique_lock<std::mutex> lock(log.mutex);
+      log.changed.wait(lock, [&log] { return log.connected >= 3; });
+    }
+    add_us.push_back(std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start)
+                         .count());
+
+    LogiLinux::DevicePtr keypad_device;
+    for (const auto &device : registry.devices()) {
+      const auto &info = device->getInfo();
+      if (info.device_path == keypad.event_path) {
+        keypad_device = device;
+        if (info.hidraw_path != keypad.hidraw_path || device != log.first) {
+          paired = false;
+        }
+      }
+      if (info.device_path == keypad_js) {
+        handlers_registered = true;
+      }
+    }
+
+    // Driver rebind: the hidraw node goes away on its own and comes back.
+    // The event node's device drops the pairing, then takes it up again.
+    source->push("remove", "hidraw", devname(tree, keypad.hidraw_path));
+    {
+      std::unique_lock<std::mutex> lock(log.mutex);
+      log.changed.wait(lock, [&log] {
+        return log.disconnected >= 1 && log.connected >= 4;
+      });
+    }
+    if (!keypad_device || !keypad_device->getInfo().hidraw_path.empty()) {
+      paired = false;
+    }
+    source->push("add", "hidraw", devname(tree, keypad.hidraw_path));
+    {
+      std::unique_lock<std::mutex> lock(log.mutex);
+      log.changed.wait(lock, [&log] { return log.connected >= 6; });
+      log.connected = 0;
+      log.disconnected = 0;
+    }
+    if (!keypad_device ||
+        keypad_device->getInfo().hidraw_path != keypad.hidraw_path) {
+      paired = false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    source->push("remove", "input", devname(tree, keypad.event_path));
+    source->push("remove", "hidraw", devname(tree, keypad.hidraw_path));
+    {
+      std::unique_lock<std::mutex> lock(log.mutex);
+      log.changed.wait(lock, [&log] { return log.disconnected >= 2; });
+      log.connected = 0;
+      log.disconnected = 0;
+      log.first.reset();
+    }
+    remove_us.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+
+  monitor.stop();
+  size_t remaining = registry.devices().size();
+  fs::remove_all(tree.root);
+
+  std::cout << "Tree: " << tree.next_input << " input nodes, "
+            << tree.next_hidraw << " hidraw nodes" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "Full scan:      " << scan_us << " us" << std::endl;
+  std::cout << "Keypad plug:    p50 " << percentile(add_us, 0.5) << " us, max "
+            << percentile(add_us, 1.0) << " us" << std::endl;
+  std::cout << "Keypad unplug:  p50 " << percentile(remove_us, 0.5)
+            << " us, max " << percentile(remove_us, 1.0) << " us"
+            << std::endl;
+
+  if (!paired || remaining != baseline) {
+    std::cerr << "Error: keypads were not paired in place and removed cleanly"
+              << std::endl;
+    return 1;
+  }
+  if (handlers_registered) {
+    std::cerr << "Error: a mouseN/jsN node was registered as a device"
+              << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
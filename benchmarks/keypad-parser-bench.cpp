@@ -0,0 +1,247 @@
+/*
+ * keypad-parser-bench - Check and time the MX Keypad report parser
+ *
+ * Decodes a corpus of keypad HID reports with MXKeypadReportParser and with
+ * the original std::set based decoder, fails if they disagree on any event,
+ * then reports reports/sec and heap allocations per report for both.
+ *
+ * Usage:
+ *   keypad-parser-bench [--corpus PATH] [--iterations N]
+ */
+
+#include "../lib/src/devices/mx_keypad_report_parser.h"
+#include "alloc-counter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef KEYPAD_CORPUS_PATH
+#define KEYPAD_CORPUS_PATH "mx-keypad-reports.txt"
+#endif
+
+using Report = std::vector<uint8_t>;
+
+// The decoder MXKeypadDevice used before MXKeypadReportParser, kept as the
+// reference the new parser must match event for event
+class LegacyParser {
+public:
+  void parse(const Report &report, std::vector<LogiLinux::EventRecord> &out) {
+    size_t bytes_read = report.size();
+    bool is_p_button_event = false;
+
+    if (bytes_read >= 6 && report[0] == 0x11 && report[1] == 0xff &&
+        report[2] == 0x0b && report[3] == 0x00) {
+      is_p_button_event = true;
+
+      if (report[4] == 0x01 && (report[5] == 0xa1 || report[5] == 0xa2)) {
+        last_p_button_ = report[5];
+        out.push_back(makeRecord(report[5], true));
+      } else if (report[4] == 0x00 && last_p_button_ != 0) {
+        out.push_back(makeRecord(last_p_button_, false));
+        last_p_button_ = 0;
+      }
+    }
+
+    if (!is_p_button_event && bytes_read >= 7 && report[0] == 0x13 &&
+        report[1] == 0xff && report[2] == 0x02 && report[3] == 0x00 &&
+        report[5] == 0x01) {
+      std::set<uint8_t> current_pressed;
+      for (size_t i = 6; i < bytes_read; i++) {
+        if (report[i] == 0) {
+          break;
+        }
+        if (report[i] >= 1 && report[i] <= 9) {
+          current_pressed.insert(report[i] - 1);
+        }
+      }
+
+      for (uint8_t code : current_pressed) {
+        if (pressed_buttons_.find(code) == pressed_buttons_.end()) {
+          out.push_back(makeRecord(code, true));
+        }
+      }
+
+      std::vector<uint8_t> to_release;
+      for (uint8_t code : pressed_buttons_) {
+        if (current_pressed.find(code) == current_pressed.end()) {
+          to_release.push_back(code);
+        }
+      }
+      for (uint8_t code : to_release) {
+        out.push_back(makeRecord(code, false));
+      }
+
+      pressed_buttons_ = current_pressed;
+    }
+  }
+
+private:
+  static LogiLinux::EventRecord makeRecord(uint32_t code, bool pressed) {
+    LogiLinux::EventRecord record = {};
+    record.type = pressed ? LogiLinux::EventType::BUTTON_PRESS
+                          : LogiLinux::EventType::BUTTON_RELEASE;
+    record.button.button_code = code;
+    record.button.pressed = pressed;
+    return record;
+  }
+
+  std::set<uint8_t> pressed_buttons_;
+  uint8_t last_p_button_ = 0;
+};
+
+static bool loadCorpus(const std::string &path, std::vector<Report> &corpus) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    Report report;
+    std::istringstream bytes(line);
+    unsigned value;
+    while (bytes >> std::hex >> value) {
+      report.push_back(static_cast<uint8_t>(value));
+    }
+    corpus.push_back(report);
+  }
+
+  return !corpus.empty();
+}
+
+static bool sameEvent(const LogiLinux::EventRecord &a,
+                      const LogiLinux::EventRecord &b) {
+  return a.type == b.type && a.button.button_code == b.button.button_code &&
+         a.button.pressed == b.button.pressed;
+}
+
+static bool validate(const std::vector<Report> &corpus) {
+  LogiLinux::MXKeypadReportParser parser;
+  LegacyParser legacy;
+  std::vector<LogiLinux::EventRecord> expected;
+  size_t total = 0;
+
+  for (size_t i = 0; i < corpus.size(); i++) {
+    LogiLinux::EventRecord events[LogiLinux::MXKeypadReportParser::MAX_EVENTS];
+    size_t count =
+        parser.parse(corpus[i].data(), corpus[i].size(), 0, events);
+
+    expected.clear();
+    legacy.parse(corpus[i], expected);
+
+    bool match = count == expected.size();
+    for (size_t e = 0; match && e < count; e++) {
+      match = sameEvent(events[e], expected[e]);
+    }
+    if (!match) {
+      std::cerr << "Error: report " << i << ": parser produced " << count
+                << " events, reference produced " << expected.size()
+                << std::endl;
+      return false;
+    }
+    total += count;
+  }
+
+  std::cout << "Corpus: " << corpus.size() << " reports, " << total
+            << " events, parser matches reference" << std::endl;
+  return true;
+}
+
+struct Result {
+  double seconds;
+  uint64_t allocations;
+  uint64_t events;
+};
+
+template <typename Decode>
+static Result run(const std::vector<Report> &corpus, size_t iterations,
+                  Decode decode) {
+  uint64_t events = 0;
+  uint64_t allocs_before = allocation_count.load();
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t n = 0; n < iterations; n++) {
+    for (const auto &report : corpus) {
+      events += decode(report);
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double>(end - start).count(),
+          allocation_count.load() - allocs_before, events};
+}
+
+static void report(const char *name, const Result &result, size_t reports) {
+  std::cout << std::left << std::setw(22) << name << std::right
+            << std::setw(14) << std::fixed << std::setprecision(0)
+            << (reports / result.seconds) << " reports/s" << std::setw(10)
+            << std::setprecision(2)
+            << static_cast<double>(result.allocations) / reports
+            << " allocs/report" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::string corpus_path = KEYPAD_CORPUS_PATH;
+  size_t iterations = 2000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--corpus" && i + 1 < argc) {
+      corpus_path = argv[++i];
+    } else if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--corpus PATH] [--iterations N]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<Report> corpus;
+  if (!loadCorpus(corpus_path, corpus)) {
+    std::cerr << "Error: Failed to load corpus " << corpus_path << std::endl;
+    return 1;
+  }
+
+  if (!validate(corpus)) {
+    return 1;
+  }
+
+  LogiLinux::MXKeypadReportParser parser;
+  Result parser_result = run(corpus, iterations, [&](const Report &report) {
+    LogiLinux::EventRecord events[LogiLinux::MXKeypadReportParser::MAX_EVENTS];
+    return parser.parse(report.data(), report.size(), 0, events);
+  });
+
+  LegacyParser legacy;
+  std::vector<LogiLinux::EventRecord> out;
+  Result legacy_result = run(corpus, iterations, [&](const Report &report) {
+    out.clear();
+    legacy.parse(report, out);
+    return out.size();
+  });
+
+  if (parser_result.events != legacy_result.events) {
+    std::cerr << "Error: decoders produced different event counts"
+              << std::endl;
+    return 1;
+  }
+
+  size_t reports = corpus.size() * iterations;
+  report("std::set decoder", legacy_result, reports);
+  report("MXKeypadReportParser", parser_result, reports);
+
+  return 0;
+}
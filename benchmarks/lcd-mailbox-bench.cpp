@@ -0,0 +1,186 @@
+/*
+ * lcd-mailbox-bench - A key updated faster than the LCD can take it
+ *
+ * Points an MXKeypadDevice's hidraw node at a pipe whose reader takes
+ * --rate packets per second, and has a "VU meter" post a new image for one
+ * key every --interval microseconds while a screen animation keeps the
+ * link busy, both in the background lane. Each image carries its sequence
+ * number and post time, so the reader can tell how old every image was
+ * when it reached the device. Checks that the age stays bounded, that
+ * every posted image was either sent or counted as superseded, and that
+ * the last image posted is the one the key ends up showing.
+ *
+ * Usage:
+ *   lcd-mailbox-bench [--seconds N] [--rate PACKETS] [--interval US]
+ */
+
+#include "synthetic-keypad.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using LogiLinux::LcdPriority;
+using LogiLinux::MXKeypadDevice;
+using LogiLinux::MXKeypadPacketizer;
+
+namespace {
+
+constexpr int METER_KEY = 4;
+
+struct Received {
+  uint64_t key_images = 0;
+  uint64_t last_sequence = 0;
+  std::vector<uint64_t> age_ns;
+};
+
+// First packets of the meter key carry its sequence number and post time
+// at the start of the JPEG
+void readStream(int fd, int rate, Received &received) {
+  readPacketsPaced(fd, rate, [&received](const std::vector<uint8_t> &packet) {
+    bool first = packet[4] & 0x80;
+    uint16_t width = packet[13] << 8 | packet[14];
+    if (first && width == MXKeypadDevice::KEY_SIZE) {
+      uint64_t sequence, posted_ns;
+      memcpy(&sequence, packet.data() + 20, sizeof(sequence));
+      memcpy(&posted_ns, packet.data() + 28, sizeof(posted_ns));
+      received.key_images++;
+      received.last_sequence = sequence;
+      received.age_ns.push_back(LogiLinux::getMonotonicTimestamp() -
+                                posted_ns);
+    }
+  });
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int seconds = 3;
+  int rate = 1000;
+  int interval_us = 2000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = std::atoi(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      rate = std::atoi(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval_us = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--seconds N] [--rate PACKETS] [--interval US]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (seconds < 1 || rate < 1 || interval_us < 1) {
+    std::cerr << "Error: arguments must be positive" << std::endl;
+    return 1;
+  }
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) < 0) {
+    std::cerr << "Error: cannot create a pipe" << std::endl;
+    return 1;
+  }
+  // As little buffering as possible, like a device taking reports in turn
+  fcntl(fds[1], F_SETPIPE_SZ, 4096);
+
+  Received received;
+  std::thread reader(readStream, fds[0], rate, std::ref(received));
+
+  uint64_t posts = 0;
+  LogiLinux::LcdWriterStats stats;
+  {
+    MXKeypadDevice keypad(
+        syntheticKeypadInfo("/dev/fd/" + std::to_string(fds[1])));
+    if (!keypad.initialize()) {
+      std::cerr << "Error: cannot open the pipe" << std::endl;
+      return 1;
+    }
+
+    std::atomic<bool> running(true);
+    std::thread screen([&]() {
+      const std::vector<uint8_t> screen_jpeg(48 * 1024, 0xa5);
+      while (running) {
+        keypad.postScreenImage(screen_jpeg, LcdPriority::BACKGROUND);
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+      }
+    });
+
+    std::vector<uint8_t> meter(6 * 1024, 0x5a);
+    auto end =
+        std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    auto next = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() < end) {
+      uint64_t sequence = ++posts;
+      uint64_t now = LogiLinux::getMonotonicTimestamp();
+      memcpy(meter.data(), &sequence, sizeof(sequence));
+      memcpy(meter.data() + 8, &now, sizeof(now));
+      if (!keypad.postKeyImage(METER_KEY, meter, LcdPriority::BACKGROUND)) {
+        std::cerr << "Error: post failed" << std::endl;
+        return 1;
+      }
+      next += std::chrono::microseconds(interval_us);
+      std::this_thread::sleep_until(next);
+    }
+
+    running = false;
+    screen.join();
+
+    // Let the writer finish what is still waiting
+    do {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      stats = keypad.getLcdStats();
+    } while (stats.depth > 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stats = keypad.getLcdStats();
+  }
+
+  close(fds[1]);
+  reader.join();
+  close(fds[0]);
+
+  std::vector<uint64_t> &ages = received.age_ns;
+  std::sort(ages.begin(), ages.end());
+  std::cout << "Meter: " << posts << " posted, " << received.key_images
+            << " shown";
+  if (!ages.empty()) {
+    std::cout << ", age p50 " << ages[ages.size() / 2] / 1000000.0
+              << " ms, p99 " << ages[(ages.size() - 1) * 99 / 100] / 1000000.0
+              << " ms, max " << ages.back() / 1000000.0 << " ms";
+  }
+  std::cout << "\nWriter: " << stats.posted << " posted, " << stats.superseded
+            << " superseded, " << stats.interactive << " interactive and "
+            << stats.background << " background sent, " << stats.failed
+            << " failed" << std::endl;
+
+  // Every post was sent or superseded, and the key shows the last one
+  bool ok = stats.failed == 0 &&
+            stats.posted == stats.superseded + stats.interactive +
+                                stats.background &&
+            received.last_sequence == posts;
+
+  // Both share the background lane, so at most a screen transfer and a key
+  // transfer stand between a post and the device, however fast it posts
+  const uint64_t screen_ns =
+      MXKeypadPacketizer::packetCount(48 * 1024) * 1000000000ull / rate;
+  ok = ok && !ages.empty() && ages.back() < 4 * screen_ns;
+
+  if (!ok) {
+    std::cerr << "Error: images were lost, left waiting or sent too late"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
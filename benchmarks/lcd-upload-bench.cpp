@@ -0,0 +1,115 @@
+/*
+ * lcd-upload-bench - Concurrent MX Keypad LCD uploads through one device
+ *
+ * Points an MXKeypadDevice's hidraw node at /dev/null and has nine "key
+ * animation" threads and one "screen animation" thread upload images
+ * through it at once, the way per-key GIFs and a screen GIF do. Reports
+ * uploads/s and checks that every upload succeeded, that the upload path
+ * allocated nothing (memory stays flat however long it runs), and that
+ * JPEGs are accepted up to MAX_JPEG_SIZE and rejected above it.
+ *
+ * Usage:
+ *   lcd-upload-bench [--uploads N]
+ */
+
+#include "alloc-counter.h"
+#include "synthetic-keypad.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using LogiLinux::MXKeypadDevice;
+
+int main(int argc, char *argv[]) {
+  int uploads = 2000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--uploads" && i + 1 < argc) {
+      uploads = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--uploads N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (uploads < 1) {
+    std::cerr << "Error: need at least 1 upload" << std::endl;
+    return 1;
+  }
+
+  MXKeypadDevice keypad(syntheticKeypadInfo("/dev/null"));
+  if (!keypad.initialize()) {
+    std::cerr << "Error: cannot open /dev/null" << std::endl;
+    return 1;
+  }
+
+  int failures = 0;
+
+  std::vector<uint8_t> largest(MXKeypadDevice::MAX_JPEG_SIZE, 0x5a);
+  std::vector<uint8_t> too_large(MXKeypadDevice::MAX_JPEG_SIZE + 1, 0x5a);
+  if (!keypad.setScreenImage(largest) || keypad.setScreenImage(too_large)) {
+    std::cerr << "Error: the JPEG size limit is not "
+              << MXKeypadDevice::MAX_JPEG_SIZE << " bytes" << std::endl;
+    failures++;
+  }
+
+  // Typical sizes: a 118x118 key and a 434x434 screen at quality 85
+  const std::vector<uint8_t> key_jpeg(6 * 1024, 0xa5);
+  const std::vector<uint8_t> screen_jpeg(48 * 1024, 0xa5);
+
+  const int threads = 10;
+  std::atomic<bool> go(false);
+  std::atomic<int> finished(0);
+  std::atomic<int> failed_uploads(0);
+  std::vector<std::thread> workers;
+
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < uploads; i++) {
+        bool ok = t < 9 ? keypad.setKeyImage(t, key_jpeg)
+                        : keypad.setScreenImage(screen_jpeg);
+        if (!ok) {
+          failed_uploads.fetch_add(1);
+        }
+      }
+      finished.fetch_add(1);
+    });
+  }
+
+  uint64_t allocations_before = allocation_count.load();
+  auto start = std::chrono::steady_clock::now();
+  go = true;
+  while (finished.load() < threads) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  uint64_t allocations = allocation_count.load() - allocations_before;
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  int total = threads * uploads;
+  std::cout << "Uploads: " << total << " from " << threads << " threads in "
+            << seconds << " s (" << total / seconds << " uploads/s)\n"
+            << "Failed uploads: " << failed_uploads.load() << "\n"
+            << "Allocations while uploading: " << allocations << std::endl;
+
+  if (failed_uploads.load() != 0 || allocations != 0) {
+    std::cerr << "Error: uploads failed or allocated memory" << std::endl;
+    failures++;
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * lcd-writer-bench - Interactive LCD updates behind busy animations
+ *
+ * Points an MXKeypadDevice's hidraw node at a pipe whose reader takes
+ * --rate packets per second, standing in for the keypad's USB link. Nine
+ * key animation threads and a screen animation thread keep the device
+ * busy with BACKGROUND uploads while another thread "highlights" a key
+ * with an INTERACTIVE upload every --interval milliseconds. Reports how
+ * long uploads of each lane took and the writer's own stats, and checks
+ * on the reader side that no two transfers ever interleaved.
+ *
+ * Usage:
+ *   lcd-writer-bench [--seconds N] [--rate PACKETS] [--interval MS]
+ */
+
+#include "synthetic-keypad.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using LogiLinux::LcdPriority;
+using LogiLinux::MXKeypadDevice;
+using LogiLinux::MXKeypadPacketizer;
+
+namespace {
+
+struct StreamCheck {
+  uint64_t transfers = 0;
+  uint64_t errors = 0; // Packet out of sequence: transfers interleaved
+};
+
+// Follows the packet index and first/last flags in byte 4
+void readStream(int fd, int rate, StreamCheck &check) {
+  int expected_index = 0; // 0: between transfers
+
+  readPacketsPaced(fd, rate, [&](const std::vector<uint8_t> &packet) {
+    uint8_t flags = packet[4];
+    int index = flags & 0x1f;
+    bool first = flags & 0x80;
+    bool last = flags & 0x40;
+    if (first != (expected_index == 0) ||
+        (!first && index != expected_index)) {
+      check.errors++;
+    }
+    expected_index = last ? 0 : index + 1;
+    if (last) {
+      check.transfers++;
+    }
+  });
+}
+
+struct Timings {
+  std::mutex mutex;
+  std::vector<uint64_t> ns[2]; // Indexed by LcdPriority
+  uint64_t failed = 0;
+
+  void add(LcdPriority priority, uint64_t ns_taken, bool ok) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ns[static_cast<int>(priority)].push_back(ns_taken);
+    failed += ok ? 0 : 1;
+  }
+};
+
+void printLane(const char *label, std::vector<uint64_t> &ns) {
+  if (ns.empty()) {
+    std::cout << label << ": none" << std::endl;
+    return;
+  }
+  std::sort(ns.begin(), ns.end());
+  std::cout << label << ": " << ns.size() << " uploads, p50 "
+            << ns[ns.size() / 2] / 1000000.0 << " ms, p99 "
+            << ns[(ns.size() - 1) * 99 / 100] / 1000000.0 << " ms, max "
+            << ns.back() / 1000000.0 << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int seconds = 3;
+  int rate = 1000;
+  int interval_ms = 50;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = std::atoi(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      rate = std::atoi(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval_ms = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--seconds N] [--rate PACKETS] [--interval MS]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (seconds < 1 || rate < 1 || interval_ms < 1) {
+    std::cerr << "Error: arguments must be positive" << std::endl;
+    return 1;
+  }
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) < 0) {
+    std::cerr << "Error: cannot create a pipe" << std::endl;
+    return 1;
+  }
+  // As little buffering as possible, like a device taking reports in turn
+  fcntl(fds[1], F_SETPIPE_SZ, 4096);
+
+  StreamCheck check;
+  std::thread reader(readStream, fds[0], rate, std::ref(check));
+
+  Timings timings;
+  {
+    MXKeypadDevice keypad(
+        syntheticKeypadInfo("/dev/fd/" + std::to_string(fds[1])));
+    if (!keypad.initialize()) {
+      std::cerr << "Error: cannot open the pipe" << std::endl;
+      return 1;
+    }
+
+    const std::vector<uint8_t> key_jpeg(6 * 1024, 0xa5);
+    const std::vector<uint8_t> screen_jpeg(48 * 1024, 0xa5);
+    std::atomic<bool> running(true);
+    std::vector<std::thread> threads;
+
+    auto upload = [&](LcdPriority priority, int key) {
+      uint64_t start = LogiLinux::getMonotonicTimestamp();
+      bool ok = key < 9 ? keypad.setKeyImage(key, key_jpeg, priority)
+                        : keypad.setScreenImage(screen_jpeg, priority);
+      timings.add(priority, LogiLinux::getMonotonicTimestamp() - start, ok);
+    };
+
+    for (int t = 0; t < 10; t++) {
+      threads.emplace_back([&, t]() {
+        while (running) {
+          upload(LcdPriority::BACKGROUND, t);
+        }
+      });
+    }
+    threads.emplace_back([&]() {
+      int key = 0;
+      while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        upload(LcdPriority::INTERACTIVE, key);
+        key = (key + 1) % 9;
+      }
+    });
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running = false;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    LogiLinux::LcdWriterStats stats = keypad.getLcdStats();
+    printLane("Interactive", timings.ns[0]);
+    printLane("Background", timings.ns[1]);
+    std::cout << "Writer: " << stats.interactive << " interactive, "
+              << stats.background << " background, " << stats.failed
+              << " failed, queue high water " << stats.high_water
+              << ", transfer p50 "
+              << stats.transfer_latency.percentile(50) / 1000000.0
+              << " ms, queue wait p99 "
+              << stats.queue_latency.percentile(99) / 1000000.0 << " ms"
+              << std::endl;
+  }
+
+  close(fds[1]);
+  reader.join();
+  close(fds[0]);
+
+  uint64_t uploads = timings.ns[0].size() + timings.ns[1].size();
+  std::cout << "Reader: " << check.transfers << " transfers, " << check.errors
+            << " out of sequence" << std::endl;
+
+  if (timings.failed != 0 || check.errors != 0 || check.transfers != uploads) {
+    std::cerr << "Error: transfers failed or interleaved" << std::endl;
+    return 1;
+  }
+  return 0;
+}
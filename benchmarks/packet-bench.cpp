@@ -0,0 +1,235 @@
+/*
+ * packet-bench - Check and time MX Keypad LCD packet assembly
+ *
+ * Builds the output reports for synthetic JPEGs of typical key and screen
+ * sizes with MXKeypadPacketizer and with the original pool-and-vector
+ * assembly, fails if they differ in any byte, then reports the time and the
+ * bytes copied and zeroed per frame for both, up to the iovec array handed
+ * to writev().
+ *
+ * Usage:
+ *   packet-bench [--iterations N]
+ */
+
+#include "../lib/src/devices/mx_keypad_packetizer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using LogiLinux::MXKeypadPacketizer;
+
+namespace {
+
+constexpr size_t PACKET_SIZE = 4095;
+
+struct Traffic {
+  uint64_t copied = 0;
+  uint64_t zeroed = 0;
+};
+
+// The assembly MXKeypadDevice used before MXKeypadPacketizer: every packet
+// is cleared in a pool buffer, filled, then copied into the result vector
+class LegacyPacketizer {
+public:
+  LegacyPacketizer() : next_(0) {
+    for (auto &buffer : pool_) {
+      buffer.resize(PACKET_SIZE);
+    }
+  }
+
+  std::vector<std::vector<uint8_t>>
+  generate(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+           const std::vector<uint8_t> &jpeg, Traffic &traffic) {
+    const size_t FIRST_HEADER = 20;
+    const size_t HEADER = 5;
+    static const uint8_t BASE[4] = {0x14, 0xff, 0x02, 0x2b};
+    static const uint8_t GEOMETRY[6] = {0x01, 0x00, 0x01, 0x00, 0x00, 0x00};
+
+    std::vector<std::vector<uint8_t>> result;
+
+    uint8_t header1[FIRST_HEADER] = {0};
+    memcpy(header1, BASE, 4);
+    header1[4] = writeByte(1, true, jpeg.size() <= PACKET_SIZE - FIRST_HEADER);
+    memcpy(header1 + 5, GEOMETRY, 6);
+    header1[9] = (x >> 8) & 0xff;
+    header1[10] = x & 0xff;
+    header1[11] = (y >> 8) & 0xff;
+    header1[12] = y & 0xff;
+    header1[13] = (width >> 8) & 0xff;
+    header1[14] = width & 0xff;
+    header1[15] = (height >> 8) & 0xff;
+    header1[16] = height & 0xff;
+    header1[18] = (jpeg.size() >> 8) & 0xff;
+    header1[19] = jpeg.size() & 0xff;
+
+    auto &packet1 = acquire();
+    memset(packet1.data(), 0, PACKET_SIZE);
+    memcpy(packet1.data(), header1, FIRST_HEADER);
+    size_t count1 = std::min(jpeg.size(), PACKET_SIZE - FIRST_HEADER);
+    if (count1 > 0) {
+      memcpy(packet1.data() + FIRST_HEADER, jpeg.data(), count1);
+    }
+    result.push_back(packet1);
+    traffic.zeroed += PACKET_SIZE;
+    traffic.copied += FIRST_HEADER + count1 + PACKET_SIZE;
+
+    uint8_t header[HEADER] = {0};
+    memcpy(header, BASE, 4);
+    size_t remaining = jpeg.size() - count1;
+    size_t offset = count1;
+    int part = 2;
+    while (remaining > 0) {
+      size_t count = std::min(remaining, PACKET_SIZE - HEADER);
+      auto &packet = acquire();
+      memset(packet.data(), 0, PACKET_SIZE);
+      header[4] = writeByte(part, false, remaining - count == 0);
+      memcpy(packet.data(), header, HEADER);
+      memcpy(packet.data() + HEADER, jpeg.data() + offset, count);
+      result.push_back(packet);
+      traffic.zeroed += PACKET_SIZE;
+      traffic.copied += HEADER + count + PACKET_SIZE;
+
+      remaining -= count;
+      offset += count;
+      part++;
+    }
+    return result;
+  }
+
+private:
+  static uint8_t writeByte(int index, bool first, bool last) {
+    uint8_t value = index | 0b00100000;
+    if (first)
+      value |= 0b10000000;
+    if (last)
+      value |= 0b01000000;
+    return value;
+  }
+
+  std::vector<uint8_t> &acquire() { return pool_[next_++ % pool_.size()]; }
+
+  std::array<std::vector<uint8_t>, 16> pool_;
+  size_t next_;
+};
+
+struct Case {
+  const char *label;
+  uint16_t x, y, width, height;
+  size_t jpeg_size;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int iterations = 20000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--iterations N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (iterations < 1) {
+    std::cerr << "Error: need at least 1 iteration" << std::endl;
+    return 1;
+  }
+
+  const Case cases[] = {
+      {"empty", 23, 6, 118, 118, 0},
+      {"first packet full", 23, 6, 118, 118, PACKET_SIZE - 20},
+      {"second packet", 23, 6, 118, 118, PACKET_SIZE - 19},
+      {"key 118x118", 181, 164, 118, 118, 6 * 1024},
+      {"screen 434x434", 23, 6, 434, 434, 48 * 1024},
+  };
+
+  LegacyPacketizer legacy;
+  std::vector<uint8_t> packets;
+  std::vector<struct iovec> iov;
+  int failures = 0;
+
+  for (const Case &c : cases) {
+    std::vector<uint8_t> jpeg(c.jpeg_size);
+    for (size_t i = 0; i < jpeg.size(); i++) {
+      jpeg[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+
+    size_t count = MXKeypadPacketizer::packetCount(jpeg.size());
+    packets.resize(count * MXKeypadPacketizer::PACKET_SIZE);
+    iov.resize(count);
+
+    // Same reports, byte for byte
+    Traffic legacy_traffic;
+    auto expected = legacy.generate(c.x, c.y, c.width, c.height, jpeg,
+                                    legacy_traffic);
+    size_t built = MXKeypadPacketizer::packetize(
+        c.x, c.y, c.width, c.height, jpeg.data(), jpeg.size(),
+        packets.data(), iov.data());
+    bool same = built == expected.size();
+    for (size_t i = 0; same && i < built; i++) {
+      same = iov[i].iov_len == PACKET_SIZE &&
+             memcmp(iov[i].iov_base, expected[i].data(), PACKET_SIZE) == 0;
+    }
+    if (!same) {
+      std::cerr << "Error: " << c.label << ": packets differ from the "
+                << "original assembly" << std::endl;
+      failures++;
+      continue;
+    }
+
+    Traffic traffic;
+    size_t headers = MXKeypadPacketizer::FIRST_HEADER_SIZE +
+                     (count - 1) * MXKeypadPacketizer::HEADER_SIZE;
+    traffic.copied = jpeg.size() + headers;
+    traffic.zeroed = count * PACKET_SIZE - traffic.copied;
+
+    // Legacy: packets plus the iovec array, as setKeyImage() built them
+    auto start = std::chrono::steady_clock::now();
+    size_t checksum = 0;
+    for (int i = 0; i < iterations; i++) {
+      Traffic ignored;
+      auto result = legacy.generate(c.x, c.y, c.width, c.height, jpeg,
+                                    ignored);
+      std::vector<struct iovec> legacy_iov(result.size());
+      for (size_t p = 0; p < result.size(); p++) {
+        legacy_iov[p] = {result[p].data(), result[p].size()};
+      }
+      checksum += static_cast<uint8_t *>(legacy_iov.back().iov_base)[4];
+    }
+    double legacy_us = std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      MXKeypadPacketizer::packetize(c.x, c.y, c.width, c.height, jpeg.data(),
+                                    jpeg.size(), packets.data(), iov.data());
+      checksum += static_cast<uint8_t *>(iov[count - 1].iov_base)[4];
+    }
+    double new_us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    iterations;
+
+    std::cout << c.label << " (" << jpeg.size() << " bytes, " << count
+              << " packets, checksum " << checksum % 256 << ")\n"
+              << "  original:    " << legacy_us << " us, "
+              << legacy_traffic.copied << " bytes copied, "
+              << legacy_traffic.zeroed << " zeroed\n"
+              << "  packetizer:  " << new_us << " us, " << traffic.copied
+              << " bytes copied, " << traffic.zeroed << " zeroed"
+              << std::endl;
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*
+ * page-flip-bench - Setting all nine MX Keypad keys at once
+ *
+ * Flips a page of nine key images --flips times, first with nine
+ * setKeyImage() calls and then with one setKeyImages() batch, through an
+ * MXKeypadDevice whose hidraw node is /dev/null. Reports the time per flip
+ * and the writer transfers each took. Also writes a page both ways to two
+ * files and checks that the batch produced exactly the same packets, for
+ * typical keys and for keys too large to share a single writev().
+ *
+ * Usage:
+ *   page-flip-bench [--flips N]
+ */
+
+#include "synthetic-keypad.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using LogiLinux::MXKeypadDevice;
+
+namespace {
+
+bool flipOneByOne(MXKeypadDevice &keypad,
+                  const std::vector<std::vector<uint8_t>> &page) {
+  for (int key = 0; key < 9; key++) {
+    if (!keypad.setKeyImage(key, page[key])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool flipBatched(MXKeypadDevice &keypad,
+                 const std::vector<std::vector<uint8_t>> &page) {
+  std::vector<MXKeypadDevice::KeyImage> images;
+  for (int key = 0; key < 9; key++) {
+    images.push_back({key, &page[key]});
+  }
+  return keypad.setKeyImages(images);
+}
+
+using FlipFunction = bool (*)(MXKeypadDevice &,
+                              const std::vector<std::vector<uint8_t>> &);
+
+// Times flips on a /dev/null keypad; returns false if any upload failed
+bool timeFlips(const char *label, FlipFunction flip, int flips,
+               const std::vector<std::vector<uint8_t>> &page) {
+  MXKeypadDevice keypad(syntheticKeypadInfo("/dev/null"));
+  if (!keypad.initialize()) {
+    std::cerr << "Error: cannot open /dev/null" << std::endl;
+    return false;
+  }
+
+  bool ok = true;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < flips && ok; i++) {
+    ok = flip(keypad, page);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  LogiLinux::LcdWriterStats stats = keypad.getLcdStats();
+  std::cout << label << ": " << seconds * 1000000.0 / flips
+            << " us per flip, "
+            << static_cast<double>(stats.interactive) / flips
+            << " transfers per flip, transfer p50 "
+            << stats.transfer_latency.percentile(50) / 1000.0 << " us"
+            << std::endl;
+  return ok && stats.failed == 0;
+}
+
+// Writes one page to a fresh file and returns what the keypad was sent
+std::vector<uint8_t>
+capturePage(FlipFunction flip, const std::vector<std::vector<uint8_t>> &page) {
+  char path[] = "/tmp/page-flip-bench-XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return {};
+  }
+  close(fd);
+
+  bool ok;
+  {
+    MXKeypadDevice keypad(syntheticKeypadInfo(path));
+    ok = keypad.initialize() && flip(keypad, page);
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+  unlink(path);
+  return ok ? bytes : std::vector<uint8_t>();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int flips = 2000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--flips" && i + 1 < argc) {
+      flips = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--flips N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (flips < 1) {
+    std::cerr << "Error: need at least 1 flip" << std::endl;
+    return 1;
+  }
+
+  // A typical 118x118 key at quality 85, different for every key, and keys
+  // large enough that a page needs more than one writev()
+  std::vector<std::vector<uint8_t>> page;
+  std::vector<std::vector<uint8_t>> large_page;
+  for (int key = 0; key < 9; key++) {
+    page.emplace_back(6 * 1024 + key * 100, static_cast<uint8_t>(0xa0 + key));
+    large_page.emplace_back(30 * 1024 + key * 100,
+                            static_cast<uint8_t>(0xb0 + key));
+  }
+
+  int failures = 0;
+  if (!timeFlips("One by one", flipOneByOne, flips, page) ||
+      !timeFlips("Batched", flipBatched, flips, page)) {
+    std::cerr << "Error: uploads failed" << std::endl;
+    failures++;
+  }
+
+  for (const auto *p : {&page, &large_page}) {
+    std::vector<uint8_t> one_by_one = capturePage(flipOneByOne, *p);
+    std::vector<uint8_t> batched = capturePage(flipBatched, *p);
+    std::cout << "Page: " << one_by_one.size() << " bytes one by one, "
+              << batched.size() << " bytes batched" << std::endl;
+    if (one_by_one.empty() || one_by_one != batched) {
+      std::cerr << "Error: the batch sent different packets" << std::endl;
+      failures++;
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+/*
+ * remap-bench - Measure the cost the uinput remapper adds per frame
+ *
+ * Feeds synthetic dialpad frames (each detent on both REL_HWHEEL and
+ * REL_HWHEEL_HI_RES, as the hardware reports it, plus a button every
+ * --button-every frames) through a RemapEngine and writes every output
+ * frame to /dev/null with one write(), the same call the remapper makes on
+ * /dev/uinput. Reports the per-frame cost for each output mode and checks
+ * that no detent, tap or button was lost or doubled.
+ *
+ * Then remaps --slow-frames frames through an EventDispatcher whose record
+ * callback takes --slow-us per event, writing to a pipe, and checks that
+ * every frame was written before a callback saw any of its events.
+ *
+ * Usage:
+ *   remap-bench [--frames N] [--interval US] [--button-every N]
+ *               [--slow-frames N] [--slow-us US]
+ */
+
+#include "../lib/src/core/event_dispatcher.h"
+#include "../lib/src/core/uinput_remapper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace LogiLinux;
+
+namespace {
+
+struct Totals {
+  int64_t high_res = 0;
+  int64_t low_res = 0;
+  int64_t key_taps = 0;
+  int64_t buttons = 0;
+  int64_t unterminated = 0; // Frames not ending in SYN_REPORT
+};
+
+EventRecord rotation(uint16_t code, int32_t delta, int32_t high_res,
+                     uint64_t timestamp) {
+  EventRecord record{};
+  record.type = EventType::ROTATION;
+  record.timestamp = timestamp;
+  record.rotation.rotation_type = RotationType::DIAL;
+  record.rotation.delta = delta;
+  record.rotation.delta_high_res = high_res;
+  record.rotation.raw_event_code = code;
+  return record;
+}
+
+EventRecord button(uint32_t code, bool pressed, uint64_t timestamp) {
+  EventRecord record{};
+  record.type = pressed ? EventType::BUTTON_PRESS : EventType::BUTTON_RELEASE;
+  record.timestamp = timestamp;
+  record.button.button_code = code;
+  record.button.pressed = pressed;
+  return record;
+}
+
+void count(const struct input_event *events, size_t n, Totals &totals) {
+  for (size_t i = 0; i < n; i++) {
+    const struct input_event &ev = events[i];
+    if (ev.type == EV_REL && ev.code == REL_WHEEL_HI_RES) {
+      totals.high_res += ev.value;
+    } else if (ev.type == EV_REL && ev.code == REL_WHEEL) {
+      totals.low_res += ev.value;
+    } else if (ev.type == EV_KEY && ev.code == KEY_VOLUMEUP && ev.value) {
+      totals.key_taps++;
+    } else if (ev.type == EV_KEY && ev.code == BTN_LEFT && ev.value) {
+      totals.buttons++;
+    }
+  }
+  if (n > 0 && events[n - 1].type != EV_SYN) {
+    totals.unterminated++;
+  }
+}
+
+uint64_t percentile(const std::vector<uint64_t> &sorted, double p) {
+  return sorted[static_cast<size_t>(p / 100.0 * (sorted.size() - 1))];
+}
+
+// Runs one mode; returns 1 if the output doesn't add up. The scroll total
+// must fall within [min_high_res, max_high_res].
+int run(const char *label, const RemapConfig &config, int frames,
+        int interval_us, int button_every, int fd, int64_t min_high_res,
+        int64_t max_high_res, int64_t expect_taps) {
+  RemapEngine engine(config);
+  Totals totals;
+  std::vector<uint64_t> frame_ns;
+  frame_ns.reserve(frames);
+  int expect_buttons = 0;
+  int write_errors = 0;
+
+  uint64_t timestamp = 1000000000ull;
+  for (int i = 0; i < frames; i++) {
+    timestamp += static_cast<uint64_t>(interval_us) * 1000;
+    bool press = button_every > 0 && i % button_every == 0;
+    expect_buttons += press ? 1 : 0;
+
+    uint64_t before = getMonotonicTimestamp();
+    engine.process(rotation(REL_HWHEEL, 1, 120, timestamp));
+    engine.process(rotation(0x0c, 120, 120, timestamp)); // REL_HWHEEL_HI_RES
+    if (press) {
+      engine.process(button(BTN_LEFT, true, timestamp));
+      engine.process(button(BTN_LEFT, false, timestamp));
+    }
+    size_t n = engine.finishFrame();
+    if (n > 0) {
+      size_t size = n * sizeof(struct input_event);
+      if (write(fd, engine.events(), size) != static_cast<ssize_t>(size)) {
+        write_errors++;
+      }
+    }
+    frame_ns.push_back(getMonotonicTimestamp() - before);
+
+    count(engine.events(), n, totals);
+  }
+
+  std::sort(frame_ns.begin(), frame_ns.end());
+  std::cout << label << ": p50 " << percentile(frame_ns, 50) << " ns, p99 "
+            << percentile(frame_ns, 99) << " ns, max " << frame_ns.back()
+            << " ns per frame; scroll " << totals.high_res << " ("
+            << totals.low_res << " steps), taps " << totals.key_taps
+            << ", buttons " << totals.buttons << std::endl;
+
+  bool ok = write_errors == 0 && totals.unterminated == 0 &&
+            totals.buttons == expect_buttons;
+  ok = ok && totals.high_res >= min_high_res &&
+       totals.high_res <= max_high_res &&
+       totals.low_res == totals.high_res / 120 && totals.key_taps == expect_taps;
+  if (!ok) {
+    std::cerr << "Error: " << label << " output does not match the input ("
+              << write_errors << " write errors, " << totals.unterminated
+              << " frames without SYN_REPORT)" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Returns 1 if a slow record callback ran before its frame was written
+int checkOrder(int frames, int slow_us) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) < 0) {
+    std::cerr << "Error: cannot create a pipe" << std::endl;
+    return 1;
+  }
+
+  RemapConfig config;
+  config.dial.output = RemapOutput::SCROLL;
+  auto remapper = std::make_unique<UinputRemapper>(config);
+  remapper->attach(fds[1]); // Closed by the remapper
+  EventDispatcher dispatcher;
+  dispatcher.enableRemapping(std::move(remapper));
+
+  int callbacks = 0;
+  int early = 0;   // Callbacks that found their frame not written yet
+  int written = 0; // Frames read back from the pipe
+  struct input_event events[RemapEngine::MAX_FRAME_EVENTS];
+  dispatcher.setRecordCallback([&](const EventRecord &) {
+    int readable = 0;
+    while (ioctl(fds[0], FIONREAD, &readable) == 0 && readable > 0) {
+      ssize_t n = read(fds[0], events, sizeof(events));
+      for (ssize_t i = 0; i < n / static_cast<ssize_t>(sizeof(events[0]));
+           i++) {
+        written += events[i].type == EV_SYN ? 1 : 0;
+      }
+    }
+    // Each frame has two events
+    if (written <= callbacks / 2) {
+      early++;
+    }
+    callbacks++;
+    std::this_thread::sleep_for(std::chrono::microseconds(slow_us));
+  });
+
+  uint64_t timestamp = 1000000000ull;
+  for (int i = 0; i < frames; i++) {
+    timestamp += 2000000;
+    dispatcher.dispatch(rotation(REL_HWHEEL, 1, 120, timestamp));
+    dispatcher.dispatch(rotation(0x0c, 120, 120, timestamp));
+    dispatcher.endFrame();
+  }
+
+  RemapStats stats = dispatcher.remapStats();
+  dispatcher.disableRemapping();
+  close(fds[0]);
+
+  std::cout << "slow callbacks: " << stats.frames << " frames written, "
+            << callbacks << " callbacks, " << early
+            << " ran before their frame was written" << std::endl;
+  if (early != 0 || callbacks != 2 * frames ||
+      stats.frames != static_cast<uint64_t>(frames)) {
+    std::cerr << "Error: slow callbacks delayed the remapped output"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int frames = 100000;
+  int interval_us = 2000;
+  int button_every = 50;
+  int slow_frames = 50;
+  int slow_us = 1000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval_us = std::atoi(argv[++i]);
+    } else if (arg == "--button-every" && i + 1 < argc) {
+      button_every = std::atoi(argv[++i]);
+    } else if (arg == "--slow-frames" && i + 1 < argc) {
+      slow_frames = std::atoi(argv[++i]);
+    } else if (arg == "--slow-us" && i + 1 < argc) {
+      slow_us = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--frames N] [--interval US] [--button-every N]"
+                << " [--slow-frames N] [--slow-us US]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (frames < 1 || interval_us < 1 || slow_frames < 1 || slow_us < 0) {
+    std::cerr << "Error: need at least 1 frame and a positive interval"
+              << std::endl;
+    return 1;
+  }
+
+  int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Error: cannot open /dev/null" << std::endl;
+    return 1;
+  }
+
+  int failures = 0;
+
+  RemapConfig scroll;
+  scroll.dial.output = RemapOutput::SCROLL;
+  int64_t detents_high_res = static_cast<int64_t>(frames) * 120;
+  failures += run("scroll", scroll, frames, interval_us, button_every, fd,
+                  detents_high_res, detents_high_res, 0);
+
+  RemapConfig volume;
+  volume.dial.output = RemapOutput::KEYS;
+  volume.dial.positive_key = KEY_VOLUMEUP;
+  volume.dial.negative_key = KEY_VOLUMEDOWN;
+  failures += run("volume keys", volume, frames, interval_us, button_every,
+                  fd, 0, 0, frames);
+
+  // Accelerated output depends on the speed; only check that it scrolled
+  // further than the detents alone, within max_gain. Each frame is one
+  // detent, so the dial turns at 1e6 / interval detents per second.
+  RemapConfig accelerated = scroll;
+  accelerated.dial.acceleration = 0.05;
+  bool faster = 1e6 / interval_us > accelerated.dial.threshold;
+  failures += run("scroll, accelerated", accelerated, frames, interval_us,
+                  button_every, fd,
+                  faster ? detents_high_res + 1 : detents_high_res,
+                  static_cast<int64_t>(detents_high_res *
+                                       accelerated.dial.max_gain),
+                  0);
+
+  close(fd);
+
+  failures += checkOrder(slow_frames, slow_us);
+  return failures == 0 ? 0 : 1;
+}
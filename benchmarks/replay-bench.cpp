@@ -0,0 +1,85 @@
+/*
+ * replay-bench - Measure the event pipeline by replaying a capture
+ *
+ * Plays a capture recorded with Device::startCapture() (or the
+ * dialpad-monitor/keypad-monitor --capture option) through the library and
+ * reports delivered events/sec and decode-to-callback latency. With
+ * --synthesize, a dialpad capture of the given number of detents is written
+ * first, so the benchmark also runs on machines without the hardware.
+ *
+ * Usage:
+ *   replay-bench [--synthesize DETENTS] [--original-speed] FILE
+ */
+
+#include "synthetic-capture.h"
+
+#include <logilinux/logilinux.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[]) {
+  std::string path;
+  size_t detents = 0;
+  auto speed = LogiLinux::ReplaySpeed::MAXIMUM;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--synthesize" && i + 1 < argc) {
+      detents = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--original-speed") {
+      speed = LogiLinux::ReplaySpeed::ORIGINAL;
+    } else if (path.empty() && arg[0] != '-') {
+      path = arg;
+    } else {
+      path.clear();
+      break;
+    }
+  }
+
+  if (path.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--synthesize DETENTS] [--original-speed] FILE"
+              << std::endl;
+    return 1;
+  }
+
+  if (detents > 0 && !writeSyntheticCapture(path, detents, dialDetentFrame)) {
+    std::cerr << "Error: Failed to write " << path << std::endl;
+    return 1;
+  }
+
+  LogiLinux::Library lib;
+  auto device = lib.openReplay(path, speed);
+  if (!device) {
+    std::cerr << "Error: " << path << " is not a capture file" << std::endl;
+    return 1;
+  }
+
+  uint64_t events = 0;
+  device->setEventRecordCallback(
+      [&events](const LogiLinux::EventRecord &) { events++; });
+
+  auto start = std::chrono::steady_clock::now();
+  device->startMonitoring();
+  while (device->isMonitoring()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  auto latency = device->getLatencyHistogram();
+  std::cout << "Device: " << device->getInfo().name << std::endl;
+  std::cout << "Events: " << events << " in " << seconds << " s ("
+            << static_cast<uint64_t>(events / seconds) << " events/s)"
+            << std::endl;
+  std::cout << "Latency (ns): p50 " << latency.percentile(50) << ", p99 "
+            << latency.percentile(99) << ", p99.9 " << latency.percentile(99.9)
+            << ", max " << latency.max_ns << std::endl;
+
+  return 0;
+}
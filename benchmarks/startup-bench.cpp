@@ -0,0 +1,137 @@
+/*
+ * startup-bench - Time discovery at process start with and without a cache
+ *
+ * Builds a fake sysfs tree like discovery-bench and measures what a
+ * short-lived tool pays to find its devices with a fresh DeviceRegistry:
+ * a plain sysfs scan, a scan answered from a valid discovery cache, and a
+ * scan whose cache was invalidated by a new node in /dev (which falls back
+ * to a full scan and rewrites the cache). Every mode must find the same
+ * devices with the same pairing.
+ *
+ * Usage:
+ *   startup-bench [--inputs N] [--hidraws N] [--iterations N]
+ */
+
+#include "../lib/src/core/device_registry.h"
+#include "fake-sysfs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Startup {
+  double microseconds;
+  std::vector<std::string> devices; // "node -> hidraw" per device
+};
+
+static Startup startOnce(const FakeTree &tree, const std::string &cache_path) {
+  auto start = std::chrono::steady_clock::now();
+
+  LogiLinux::DeviceRegistry registry(
+      std::make_unique<LogiLinux::DeviceManager>(
+          (tree.root / "sys").string(), (tree.root / "dev").string()));
+  registry.setCachePath(cache_path);
+  auto devices = registry.scan();
+
+  Startup result;
+  result.microseconds = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  for (const auto &device : devices) {
+    const auto &info = device->getInfo();
+    result.devices.push_back(info.device_path + " -> " + info.hidraw_path);
+  }
+  return result;
+}
+
+static double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+  int inputs = 256;
+  int hidraws = 48;
+  int iterations = 50;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--inputs" && i + 1 < argc) {
+      inputs = std::atoi(argv[++i]);
+    } else if (arg == "--hidraws" && i + 1 < argc) {
+      hidraws = std::atoi(argv[++i]);
+    } else if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--inputs N] [--hidraws N] [--iterations N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (iterations < 1) {
+    std::cerr << "Error: need at least 1 iteration" << std::endl;
+    return 1;
+  }
+
+  FakeTree tree = createFakeTree();
+  addUnrelatedDevices(tree, inputs, hidraws);
+
+  fs::path dialpad = addHidDevice(tree, "1-1", 0, 0x046d, 0xbc00);
+  addInputNode(tree, dialpad, 0x046d, 0xbc00, "Logitech MX Dialpad",
+               "usb-0000:00:14.0-1/input0");
+  Keypad keypad;
+  addKeypad(tree, "1-2", keypad);
+
+  std::string cache_path = (tree.root / "cache/devices.cache").string();
+
+  std::vector<double> uncached;
+  std::vector<double> warm;
+  std::vector<double> invalidated;
+  Startup reference = startOnce(tree, "");
+  bool consistent = !reference.devices.empty();
+
+  for (int i = 0; i < iterations; i++) {
+    Startup plain = startOnce(tree, "");
+    uncached.push_back(plain.microseconds);
+
+    // A node appearing in /dev changes its mtime, so the next start has to
+    // rescan; the one after that is warm again. Results aren't cached right
+    // after a change, so date it back as if it happened a while ago.
+    writeFile(tree.root / "dev" / ("tty" + std::to_string(i)), "");
+    fs::last_write_time(tree.root / "dev",
+                        fs::file_time_type::clock::now() -
+                            std::chrono::seconds(60 + i));
+    Startup rescan = startOnce(tree, cache_path);
+    invalidated.push_back(rescan.microseconds);
+
+    Startup cached = startOnce(tree, cache_path);
+    warm.push_back(cached.microseconds);
+
+    consistent = consistent && plain.devices == reference.devices &&
+                 rescan.devices == reference.devices &&
+                 cached.devices == reference.devices;
+  }
+
+  fs::remove_all(tree.root);
+
+  std::cout << "Tree: " << tree.next_input << " input nodes, "
+            << tree.next_hidraw << " hidraw nodes, "
+            << reference.devices.size() << " devices" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "No cache:           " << median(uncached) << " us" << std::endl;
+  std::cout << "Invalidated cache:  " << median(invalidated) << " us"
+            << std::endl;
+  std::cout << "Warm cache:         " << median(warm) << " us" << std::endl;
+
+  if (!consistent) {
+    std::cerr << "Error: cached and scanned device lists differ" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
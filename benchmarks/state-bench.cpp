@@ -0,0 +1,146 @@
+/*
+ * state-bench - Measure Device::getState() under a busy monitor
+ *
+ * Writes a synthetic dialpad capture where every frame turns the dial and
+ * the wheel by one detent each and toggles a button, replays it at maximum
+ * speed with no callbacks at all, and has several threads sample
+ * getState() as fast as they can meanwhile. Reports the cost of a snapshot
+ * and checks that none of them ever shows a half-applied frame (dial and
+ * wheel disagree, or the button doesn't match the frame count) and that
+ * the final totals are exact.
+ *
+ * Usage:
+ *   state-bench [--frames N] [--readers N]
+ */
+
+#include "synthetic-capture.h"
+
+#include <logilinux/logilinux.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+constexpr uint32_t TOGGLED_BUTTON = 275; // BTN_SIDE, top left on the dialpad
+
+// Dial and wheel one detent each; pressed after odd frames (counting from
+// 1), released after even ones
+static void toggleFrame(size_t index, std::vector<SyntheticEvent> &events) {
+  events = {{EV_REL, REL_HWHEEL, 1},
+            {EV_REL, REL_HWHEEL_HI_RES, 120},
+            {EV_REL, REL_WHEEL, 1},
+            {EV_REL, REL_WHEEL_HI_RES, 120},
+            {EV_KEY, TOGGLED_BUTTON, static_cast<int32_t>((index + 1) % 2)},
+            {EV_SYN, SYN_REPORT, 0}};
+}
+
+static bool consistent(const LogiLinux::DeviceState &state) {
+  if (state.dial_position != state.wheel_position ||
+      state.dial_position % 120 != 0) {
+    return false;
+  }
+  bool odd_frames = (state.dial_position / 120) % 2 == 1;
+  return state.isPressed(TOGGLED_BUTTON) == odd_frames;
+}
+
+int main(int argc, char *argv[]) {
+  size_t frames = 500000;
+  int readers = 3;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--frames" && i + 1 < argc) {
+      frames = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--readers" && i + 1 < argc) {
+      readers = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--frames N] [--readers N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (frames < 1 || readers < 1) {
+    std::cerr << "Error: need at least 1 frame and 1 reader" << std::endl;
+    return 1;
+  }
+
+  std::string path =
+      "/tmp/logilinux-state-bench-" + std::to_string(getpid()) + ".cap";
+  if (!writeSyntheticCapture(path, frames, toggleFrame)) {
+    std::cerr << "Error: Failed to write " << path << std::endl;
+    return 1;
+  }
+
+  LogiLinux::Library lib;
+  auto device = lib.openReplay(path, LogiLinux::ReplaySpeed::MAXIMUM);
+  if (!device) {
+    std::cerr << "Error: Failed to open " << path << std::endl;
+    unlink(path.c_str());
+    return 1;
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> reads(0);
+  std::atomic<uint64_t> torn(0);
+  std::vector<std::thread> threads;
+
+  auto start = std::chrono::steady_clock::now();
+  device->startMonitoring();
+
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t local_reads = 0;
+      uint64_t local_torn = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        if (!consistent(device->getState())) {
+          local_torn++;
+        }
+        local_reads++;
+      }
+      reads.fetch_add(local_reads);
+      torn.fetch_add(local_torn);
+    });
+  }
+
+  while (device->isMonitoring()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  device->stopMonitoring();
+  unlink(path.c_str());
+
+  LogiLinux::DeviceState final_state = device->getState();
+  int64_t expected = static_cast<int64_t>(frames) * 120;
+
+  std::cout << "Frames: " << frames << " in " << seconds << " s ("
+            << static_cast<uint64_t>(frames / seconds) << " frames/s)"
+            << std::endl;
+  std::cout << "Snapshots: " << reads.load() << " by " << readers
+            << " readers, " << (seconds * 1e9 * readers / reads.load())
+            << " ns each" << std::endl;
+  std::cout << "Final: dial " << final_state.dial_position << ", wheel "
+            << final_state.wheel_position << ", buttons 0x" << std::hex
+            << final_state.buttons << std::dec << std::endl;
+
+  if (torn.load() > 0 || final_state.dial_position != expected ||
+      !consistent(final_state) || final_state.last_event_ns == 0) {
+    std::cerr << "Error: " << torn.load()
+              << " inconsistent snapshots, expected dial and wheel at "
+              << expected << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
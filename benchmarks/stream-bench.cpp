@@ -0,0 +1,166 @@
+/*
+ * stream-bench - Measure the library-wide merged event stream
+ *
+ * Writes one synthetic dialpad capture per device, replays them all at
+ * maximum speed through Library::addToEventStream(), and drains the merged
+ * stream with Library::dispatchEvents() on the main thread. Reports merged
+ * events/sec and how many events arrived behind a newer one of another
+ * device (they were still being decoded when the newer one was drained;
+ * the merge is best-effort across devices), and checks that every event
+ * arrived exactly once with its device's handle and in its device's order.
+ *
+ * Usage:
+ *   stream-bench [--devices N] [--detents N]
+ */
+
+#include "synthetic-capture.h"
+
+#include <logilinux/logilinux.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  size_t device_count = 3;
+  size_t detents = 200000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--devices" && i + 1 < argc) {
+      device_count = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--detents" && i + 1 < argc) {
+      detents = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--devices N] [--detents N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (device_count < 1 || detents < 1) {
+    std::cerr << "Error: need at least 1 device and 1 detent" << std::endl;
+    return 1;
+  }
+
+  LogiLinux::Library lib;
+  std::vector<LogiLinux::DevicePtr> devices;
+  std::vector<std::string> paths;
+
+  // What each device decoded, counted on its own thread
+  std::vector<std::atomic<uint64_t>> decoded(device_count);
+
+  for (size_t i = 0; i < device_count; i++) {
+    std::string path = "/tmp/logilinux-stream-bench-" +
+                       std::to_string(getpid()) + "-" + std::to_string(i) +
+                       ".cap";
+    paths.push_back(path);
+    if (!writeSyntheticCapture(path, detents, dialDetentFrame)) {
+      std::cerr << "Error: Failed to write " << path << std::endl;
+      return 1;
+    }
+
+    auto device = lib.openReplay(path, LogiLinux::ReplaySpeed::MAXIMUM);
+    // BLOCK keeps the replay threads from outrunning the consumer, so no
+    // event is lost and the counts below must match exactly
+    if (!device || lib.addToEventStream(device, 4096,
+                                        LogiLinux::OverflowPolicy::BLOCK) ==
+                       0) {
+      std::cerr << "Error: Failed to open " << path << std::endl;
+      return 1;
+    }
+    std::atomic<uint64_t> *counter = &decoded[i];
+    device->setEventRecordCallback(
+        [counter](const LogiLinux::EventRecord &) { counter->fetch_add(1); });
+    devices.push_back(device);
+  }
+
+  std::map<LogiLinux::DeviceHandle, uint64_t> per_device;
+  uint64_t total = 0;
+  std::map<LogiLinux::DeviceHandle, uint64_t> newest_per_device;
+  uint64_t late = 0;
+  uint64_t reordered = 0;
+  uint64_t unknown_handles = 0;
+  uint64_t newest = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &device : devices) {
+    device->startMonitoring();
+  }
+
+  auto consume = [&](const LogiLinux::EventRecord &event) {
+    if (event.timestamp < newest) {
+      late++;
+    } else {
+      newest = event.timestamp;
+    }
+    uint64_t &device_newest = newest_per_device[event.device];
+    if (event.timestamp < device_newest) {
+      reordered++;
+    } else {
+      device_newest = event.timestamp;
+    }
+    if (!lib.getDevice(event.device)) {
+      unknown_handles++;
+    }
+    per_device[event.device]++;
+    total++;
+  };
+
+  while (true) {
+    if (lib.dispatchEvents(consume, 100) > 0) {
+      continue;
+    }
+    bool running = false;
+    for (const auto &device : devices) {
+      running = running || device->isMonitoring();
+    }
+    // Finished: one last look for what arrived while checking
+    if (!running && lib.dispatchEvents(consume, 0) == 0) {
+      break;
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  for (const auto &device : devices) {
+    device->stopMonitoring();
+  }
+  for (const auto &path : paths) {
+    unlink(path.c_str());
+  }
+
+  std::cout << "Devices: " << device_count << ", events: " << total << " in "
+            << seconds << " s (" << static_cast<uint64_t>(total / seconds)
+            << " events/s), " << late << " late" << std::endl;
+
+  bool complete = per_device.size() == device_count;
+  for (size_t i = 0; i < device_count; i++) {
+    LogiLinux::DeviceHandle handle = static_cast<LogiLinux::DeviceHandle>(i + 1);
+    std::cout << "  handle " << handle << ": " << per_device[handle] << " of "
+              << decoded[i].load() << " events" << std::endl;
+    complete = complete && per_device[handle] == decoded[i].load();
+  }
+
+  if (!complete || unknown_handles > 0) {
+    std::cerr << "Error: " << unknown_handles
+              << " events with unknown handles"
+              << (complete ? "" : ", events missing") << std::endl;
+    return 1;
+  }
+  if (reordered > 0) {
+    std::cerr << "Error: " << reordered
+              << " events came out behind a newer one of the same device"
+              << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * synthetic-capture.h - Dialpad capture files for the benchmarks
+ *
+ * Writes a capture as if recorded from an MX Dialpad, one evdev read per
+ * frame at 1 ms intervals, with the frame contents supplied by the caller,
+ * so replay-based benchmarks run on machines without the hardware.
+ */
+
+#ifndef LOGILINUX_BENCH_SYNTHETIC_CAPTURE_H
+#define LOGILINUX_BENCH_SYNTHETIC_CAPTURE_H
+
+#include "../lib/src/util/capture.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <linux/input.h>
+#include <string>
+#include <vector>
+
+constexpr uint64_t SYNTHETIC_FRAME_INTERVAL_NS = 1000000;
+
+struct SyntheticEvent {
+  uint16_t type;
+  uint16_t code;
+  int32_t value;
+};
+
+// Fills the events of frame `index` (counting from 0), SYN_REPORT included
+using SyntheticFrame =
+    std::function<void(size_t index, std::vector<SyntheticEvent> &events)>;
+
+// One detent of the dial, low-res and high-res axis
+inline void dialDetentFrame(size_t index,
+                            std::vector<SyntheticEvent> &events) {
+  (void)index;
+  events = {{EV_REL, REL_HWHEEL, 1},
+            {EV_REL, REL_HWHEEL_HI_RES, 120},
+            {EV_SYN, SYN_REPORT, 0}};
+}
+
+inline bool writeSyntheticCapture(const std::string &path, size_t frames,
+                                  const SyntheticFrame &frame) {
+  LogiLinux::DeviceInfo info;
+  info.name = "Synthetic MX Dialpad";
+  info.device_path = "/dev/input/event-synthetic";
+  info.vendor_id = 0x046d;
+  info.product_id = 0xbc00;
+  info.type = LogiLinux::DeviceType::DIALPAD;
+
+  LogiLinux::CaptureWriter writer;
+  if (!writer.open(path, info)) {
+    return false;
+  }
+
+  std::vector<SyntheticEvent> events;
+  std::vector<struct input_event> read;
+  uint64_t timestamp = LogiLinux::getMonotonicTimestamp();
+
+  for (size_t i = 0; i < frames; i++) {
+    timestamp += SYNTHETIC_FRAME_INTERVAL_NS;
+    struct timeval time;
+    time.tv_sec = timestamp / 1000000000;
+    time.tv_usec = (timestamp % 1000000000) / 1000;
+
+    events.clear();
+    frame(i, events);
+    read.resize(events.size());
+    for (size_t e = 0; e < events.size(); e++) {
+      memset(&read[e], 0, sizeof(read[e]));
+      read[e].time = time;
+      read[e].type = events[e].type;
+      read[e].code = events[e].code;
+      read[e].value = events[e].value;
+    }
+    writer.write(LogiLinux::CaptureRecordKind::EVDEV, read.data(),
+                 read.size() * sizeof(struct input_event), timestamp);
+  }
+
+  writer.close();
+  return true;
+}
+
+#endif // LOGILINUX_BENCH_SYNTHETIC_CAPTURE_H
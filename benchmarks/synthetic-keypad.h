@@ -0,0 +1,72 @@
+/*
+ * synthetic-keypad.h - An MX Keypad for the LCD benchmarks
+ *
+ * Describes a keypad whose hidraw node is a file, a pipe or /dev/null, and
+ * reads such a pipe the way the keypad's USB link takes packets, so LCD
+ * benchmarks run on machines without the hardware.
+ */
+
+#ifndef LOGILINUX_BENCH_SYNTHETIC_KEYPAD_H
+#define LOGILINUX_BENCH_SYNTHETIC_KEYPAD_H
+
+#include "../lib/src/devices/mx_keypad_device.h"
+#include "../lib/src/devices/mx_keypad_packetizer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+inline LogiLinux::DeviceInfo
+syntheticKeypadInfo(const std::string &hidraw_path) {
+  LogiLinux::DeviceInfo info;
+  info.name = "Synthetic MX Keypad";
+  info.device_path = "/dev/input/event-synthetic";
+  info.hidraw_path = hidraw_path;
+  info.vendor_id = 0x046d;
+  info.product_id = 0xc354;
+  info.type = LogiLinux::DeviceType::MX_KEYPAD;
+  return info;
+}
+
+// Called with each whole packet the keypad would have received
+using SyntheticPacketHandler =
+    std::function<void(const std::vector<uint8_t> &packet)>;
+
+inline bool readExactly(int fd, std::vector<uint8_t> &buffer) {
+  size_t got = 0;
+  while (got < buffer.size()) {
+    ssize_t n = read(fd, buffer.data() + got, buffer.size() - got);
+    if (n <= 0) {
+      return false;
+    }
+    got += n;
+  }
+  return true;
+}
+
+// Skips the init reports, then reads whole packets at rate packets per
+// second until the write end is closed
+inline void readPacketsPaced(int fd, int rate,
+                             const SyntheticPacketHandler &handler) {
+  std::vector<uint8_t> packet(LogiLinux::MXKeypadPacketizer::PACKET_SIZE);
+  std::vector<uint8_t> init(40); // Two 20-byte init reports
+  if (!readExactly(fd, init)) {
+    return;
+  }
+
+  auto next = std::chrono::steady_clock::now();
+  const auto period = std::chrono::nanoseconds(1000000000 / rate);
+
+  while (readExactly(fd, packet)) {
+    handler(packet);
+
+    next += period;
+    std::this_thread::sleep_until(next);
+  }
+}
+
+#endif // LOGILINUX_BENCH_SYNTHETIC_KEYPAD_H
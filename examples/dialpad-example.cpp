@@ -65,7 +65,7 @@ void onEvent(LogiLinux::EventPtr event) {
     std::cout << "Delta: " << rotation->delta << " steps" << std::endl;
     std::cout << "High-res: " << rotation->delta_high_res << " units"
               << std::endl;
-    std::cout << "Timestamp: " << rotation->timestamp << " μs" << std::endl;
+    std::cout << "Timestamp: " << rotation->timestamp << " ns" << std::endl;
   } else if (auto button =
                  std::dynamic_pointer_cast<LogiLinux::ButtonEvent>(event)) {
     auto dialpad_button = LogiLinux::getDialpadButton(button->button_code);
@@ -75,7 +75,7 @@ void onEvent(LogiLinux::EventPtr event) {
               << " (code " << button->button_code << ")" << std::endl;
     std::cout << "Action: " << (button->pressed ? "PRESSED" : "RELEASED")
               << std::endl;
-    std::cout << "Timestamp: " << button->timestamp << " μs" << std::endl;
+    std::cout << "Timestamp: " << button->timestamp << " ns" << std::endl;
   }
 }
 
@@ -4,6 +4,7 @@
 #include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <logilinux/action_executor.h>
 #include <logilinux/device.h>
 #include <logilinux/events.h>
 #include <logilinux/logilinux.h>
@@ -46,13 +47,27 @@ int getCurrentVolume() {
   return output.empty() ? 50 : std::stoi(output);
 }
 
-void setVolume(int volume) {
-  if (volume < 0)
-    volume = 0;
+// Relative, so steps coalesced while pactl was busy apply in one go
+void adjustVolume(int64_t steps) {
+  if (steps == 0) {
+    return; // Turned back and forth while waiting
+  }
 
-  std::string cmd =
-      "pactl set-sink-volume @DEFAULT_SINK@ " + std::to_string(volume) + "%";
+  std::string cmd = "pactl set-sink-volume @DEFAULT_SINK@ " +
+                    std::string(steps > 0 ? "+" : "") +
+                    std::to_string(steps * 5) + "%";
   exec(cmd.c_str());
+
+  int volume = getCurrentVolume();
+  std::cout << "Dial - Volume: " << volume << "% (" << (steps > 0 ? "+" : "")
+            << steps << " steps) ";
+
+  int bars = volume / 5;
+  std::cout << "[";
+  for (int i = 0; i < 20; i++) {
+    std::cout << (i < bars ? "=" : " ");
+  }
+  std::cout << "]" << std::endl;
 }
 
 bool isMuted() {
@@ -60,43 +75,31 @@ bool isMuted() {
   return output.find("yes") != std::string::npos;
 }
 
-void toggleMute() {
+// Presses coalesced while pactl was busy cancel out in pairs
+void toggleMute(int64_t presses) {
+  if (presses % 2 == 0) {
+    return;
+  }
   exec("pactl set-sink-mute @DEFAULT_SINK@ toggle");
   is_muted = isMuted();
   std::cout << "\nAudio " << (is_muted ? "MUTED" : "UNMUTED") << std::endl;
 }
 
-void onEvent(LogiLinux::EventPtr event) {
-  if (auto rotation =
-          std::dynamic_pointer_cast<LogiLinux::RotationEvent>(event)) {
-
-    if (rotation->rotation_type != LogiLinux::RotationType::DIAL) {
-      return;
-    }
-
-    int current_volume = getCurrentVolume();
-    int new_volume = current_volume + (rotation->delta * 5);
-
-    setVolume(new_volume);
-
-    std::cout << "Dial - Volume: " << new_volume << "% ";
-
-    int bars = new_volume / 5;
-    std::cout << "[";
-    for (int i = 0; i < 20; i++) {
-      std::cout << (i < bars ? "=" : " ");
-    }
-    std::cout << "]" << std::endl;
-  } else if (auto button =
-                 std::dynamic_pointer_cast<LogiLinux::ButtonEvent>(event)) {
-    if (!button->pressed) {
+// Runs on the library's monitor thread: pactl takes tens of milliseconds,
+// so the handler only queues the work and returns
+void onEvent(LogiLinux::ActionExecutor &executor,
+             const LogiLinux::EventRecord &event) {
+  if (event.type == LogiLinux::EventType::ROTATION) {
+    if (event.rotation.rotation_type != LogiLinux::RotationType::DIAL) {
       return;
     }
-
-    auto dialpad_button = LogiLinux::getDialpadButton(button->button_code);
+    executor.submit("volume", event.rotation.delta, adjustVolume);
+  } else if (event.type == LogiLinux::EventType::BUTTON_PRESS) {
+    auto dialpad_button =
+        LogiLinux::getDialpadButton(event.button.button_code);
 
     if (dialpad_button == LogiLinux::DialpadButton::TOP_LEFT) {
-      toggleMute();
+      executor.submit("mute", 1, toggleMute);
     }
   }
 }
@@ -130,7 +133,12 @@ int main() {
   std::cout << "  - Press TOP_LEFT button: Toggle mute" << std::endl
             << std::endl;
 
-  dialpad->setEventCallback(onEvent);
+  // One worker is enough: each key runs one action at a time anyway
+  LogiLinux::ActionExecutor executor(1);
+  dialpad->setEventRecordCallback(
+      [&executor](const LogiLinux::EventRecord &event) {
+        onEvent(executor, event);
+      });
 
   dialpad->startMonitoring();
   if (!dialpad->isMonitoring()) {
@@ -156,6 +164,14 @@ int main() {
   std::cout << std::endl << "Stopping..." << std::endl;
   dialpad->grabExclusive(false);
   dialpad->stopMonitoring();
+  executor.wait();
+
+  auto stats = executor.getStats();
+  std::cout << "Actions: " << stats.submitted << " submitted, "
+            << stats.coalesced << " coalesced, " << stats.executed
+            << " run (p50 wait " << stats.queue_latency.percentile(50) / 1000
+            << " us, p50 run " << stats.execution_latency.percentile(50) / 1000
+            << " us)" << std::endl;
 
   return 0;
 }
@@ -0,0 +1,84 @@
+#ifndef LOGILINUX_ACTION_EXECUTOR_H
+#define LOGILINUX_ACTION_EXECUTOR_H
+
+#include "device.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace LogiLinux {
+
+struct ActionExecutorStats {
+  size_t workers;
+  size_t capacity;
+  size_t depth;      // Actions queued and not started yet
+  size_t high_water; // Deepest the queue has been
+  uint64_t submitted;
+  uint64_t coalesced; // Folded into an action that was already queued
+  uint64_t rejected;  // Queue was full
+  uint64_t executed;
+  uint64_t failed; // Threw an exception
+
+  LatencyHistogram queue_latency;     // Submission to start of execution
+  LatencyHistogram execution_latency; // Time spent running the action
+};
+
+/**
+ * Runs slow work (spawning processes, talking to audio servers, D-Bus...)
+ * on a small pool of worker threads, so event handlers can hand it off and
+ * return immediately instead of stalling input reading.
+ *
+ * Actions submitted under a key run one at a time, in order, and while
+ * one is waiting its turn, further submissions under the same key are
+ * folded into it by adding up their amounts: ten "volume +1" queued behind
+ * a busy pactl run once as "volume +10".
+ */
+class ActionExecutor {
+public:
+  using Action = std::function<void()>;
+  using AmountAction = std::function<void(int64_t amount)>;
+
+  /**
+   * Start `workers` threads sharing a queue of at most `capacity` actions
+   */
+  explicit ActionExecutor(size_t workers = 2, size_t capacity = 64);
+
+  /**
+   * Queued actions that haven't started are dropped; running ones are
+   * waited for
+   */
+  ~ActionExecutor();
+
+  ActionExecutor(const ActionExecutor &) = delete;
+  ActionExecutor &operator=(const ActionExecutor &) = delete;
+
+  /**
+   * Queue an action that is never coalesced. Returns false if the queue is
+   * full.
+   */
+  bool submit(Action action);
+
+  /**
+   * Queue action(amount) under key. If an action for key is already
+   * waiting, amount is added to its amount and action takes its place
+   * (this always succeeds). Returns false if the queue is full.
+   */
+  bool submit(const std::string &key, int64_t amount, AmountAction action);
+
+  /**
+   * Block until the queue is empty and no action is running
+   */
+  void wait();
+
+  ActionExecutorStats getStats() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_ACTION_EXECUTOR_H
@@ -2,6 +2,7 @@
 #define LOGILINUX_DEVICE_H
 
 #include "events.h"
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -23,24 +24,316 @@ enum class DeviceCapability {
   IMAGE_UPLOAD,
 };
 
+/**
+ * What a device's event queue does when the application falls behind
+ */
+enum class OverflowPolicy {
+  DROP_OLDEST,        // Overwrite the oldest queued event
+  COALESCE_ROTATIONS, // Fold rotations into one pending delta per axis;
+                      // other events fall back to DROP_OLDEST
+  BLOCK,              // Stall the producer until the application drains.
+                      // Devices share one reactor thread, so this stalls
+                      // input (and hotplug) of every device, not just this
+                      // one. There a wait gives up after 50 ms and the
+                      // event is dropped, as are later ones without
+                      // waiting, until the application drains again.
+                      // Replay devices have their own thread and wait.
+};
+
+struct EventQueueStats {
+  size_t capacity;
+  size_t depth;      // Events currently queued
+  size_t high_water; // Deepest the queue has been
+  uint64_t published;
+  uint64_t dropped;
+  uint64_t coalesced;
+  uint64_t blocked; // Times the monitor had to wait (BLOCK policy)
+};
+
+/**
+ * Rotation coalescing for devices that report the same movement on a
+ * low-res and a high-res axis (REL_HWHEEL + REL_HWHEEL_HI_RES)
+ */
+struct RotationCoalescing {
+  // Merge both axes of one SYN frame into a single RotationEvent carrying
+  // delta (low-res) and delta_high_res (high-res). A frame with only a
+  // partial high-res step gets delta 0 (delta_high_res / 120), whereas
+  // unmerged high-res events report at least +-1 each; merged deltas are
+  // exact so they can be summed.
+  bool merge_axes = false;
+
+  // Sum consecutive merged rotations arriving within this window into one
+  // event (0 disables). Implies merge_axes.
+  uint32_t window_us = 0;
+};
+
+/**
+ * What a rotation axis turns into on a remapping virtual device
+ */
+enum class RemapOutput {
+  NONE,              // Swallowed
+  SCROLL,            // Vertical wheel (REL_WHEEL and REL_WHEEL_HI_RES)
+  HORIZONTAL_SCROLL, // Horizontal wheel (REL_HWHEEL and REL_HWHEEL_HI_RES)
+  KEYS,              // One tap of positive_key/negative_key per detent
+};
+
+struct RotationMapping {
+  RemapOutput output = RemapOutput::NONE;
+  uint16_t positive_key = 0; // KEY_* code for KEYS, e.g. KEY_VOLUMEUP
+  uint16_t negative_key = 0;
+  bool invert = false;
+
+  // Turning faster than threshold detents/s multiplies the movement by
+  // 1 + acceleration * (speed - threshold), up to max_gain. 0 disables.
+  double acceleration = 0.0;
+  double threshold = 10.0;
+  double max_gain = 8.0;
+};
+
+struct ButtonMapping {
+  uint32_t button_code; // ButtonEvent::button_code on the source device
+  uint16_t key;         // KEY_*/BTN_* code emitted instead
+};
+
+/**
+ * Re-emit a grabbed device's events, transformed, from a uinput virtual
+ * device (Device::enableRemapping())
+ */
+struct RemapConfig {
+  std::string name = "LogiLinux Remapped Device";
+
+  RotationMapping dial;  // RotationType::DIAL
+  RotationMapping wheel; // RotationType::WHEEL
+
+  // Buttons listed here emit their key instead. Others in the mouse button
+  // range (BTN_MISC to BTN_TASK, which covers the dialpad's) pass through
+  // unchanged; anything else is dropped.
+  std::vector<ButtonMapping> buttons;
+};
+
+/**
+ * Distribution of the time from the kernel timestamping an event to the
+ * library handing it to the first consumer. Buckets are log-linear: exact
+ * below 8 ns, then 8 sub-buckets per power of two (12.5% resolution).
+ */
+struct LatencyHistogram {
+  static constexpr size_t SUB_BUCKETS = 8;
+  static constexpr size_t BUCKET_COUNT = 8 + 33 * SUB_BUCKETS; // Up to ~68 s
+
+  uint64_t buckets[BUCKET_COUNT];
+  uint64_t count;
+  uint64_t min_ns;
+  uint64_t max_ns;
+  uint64_t sum_ns;
+
+  static size_t bucketFor(uint64_t ns) {
+    if (ns < SUB_BUCKETS) {
+      return static_cast<size_t>(ns);
+    }
+    size_t exponent = 63 - __builtin_clzll(ns); // >= 3
+    size_t sub = static_cast<size_t>(ns >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    size_t bucket = SUB_BUCKETS + (exponent - 3) * SUB_BUCKETS + sub;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+  }
+
+  // Largest value that falls into the bucket
+  static uint64_t bucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+    size_t exponent = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 3;
+    uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+  }
+
+  /**
+   * Upper bound of the bucket holding the given percentile (0-100)
+   */
+  uint64_t percentile(double p) const {
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        uint64_t bound = bucketUpperBound(i);
+        return bound < max_ns ? bound : max_ns;
+      }
+    }
+    return max_ns;
+  }
+
+  uint64_t mean() const { return count ? sum_ns / count : 0; }
+};
+
+struct RemapStats {
+  uint64_t frames; // Output frames written, one write() each
+  uint64_t events;
+  uint64_t write_errors;
+
+  // From the kernel timestamping the source event to the transformed
+  // frame being written
+  LatencyHistogram latency;
+};
+
+/**
+ * What a device's input looks like right now, for consumers that sample it
+ * once per frame instead of handling events. Updated once per hardware
+ * frame, so a snapshot never shows half of one.
+ */
+struct DeviceState {
+  // Sum of every rotation delivered so far, in high-res units (120 per
+  // detent)
+  int64_t dial_position;
+  int64_t wheel_position;
+
+  uint64_t buttons;       // buttonMask() of every button held down
+  uint64_t last_event_ns; // CLOCK_MONOTONIC time of the latest event, or 0
+
+  /**
+   * Bit for a ButtonEvent::button_code. Codes are folded into 64 bits;
+   * the buttons of every supported device land on distinct bits.
+   */
+  static uint64_t buttonMask(uint32_t button_code) {
+    return 1ull << (button_code % 64);
+  }
+
+  bool isPressed(uint32_t button_code) const {
+    return (buttons & buttonMask(button_code)) != 0;
+  }
+};
+
 struct DeviceInfo {
   std::string name;
   std::string device_path;
   uint16_t vendor_id;
   uint16_t product_id;
   DeviceType type;
+
+  std::string hidraw_path; // hidraw node of the same physical device, if any
+  std::string serial;      // HID_UNIQ or USB serial number, may be empty
+  std::string phys;        // Physical path, e.g. usb-0000:00:14.0-2/input0
+  std::string sysfs_path;  // HID (or input) device directory in sysfs
+
+  /**
+   * Stable name for the physical device, shared by all of its nodes and
+   * unchanged across reconnects when the device reports a serial number
+   * (otherwise tied to the port it is plugged into)
+   */
+  std::string identity;
 };
 
 class Device {
 public:
   virtual ~Device() = default;
 
-  virtual const DeviceInfo &getInfo() const = 0;
+  /**
+   * Copy of the device's info. A keypad registered before its hidraw node
+   * appeared gets hidraw_path filled in later (and is reported as
+   * DEVICE_CONNECTED again), so this is a snapshot safe to take from any
+   * thread.
+   */
+  virtual DeviceInfo getInfo() const = 0;
   virtual DeviceType getType() const = 0;
 
   virtual bool hasCapability(DeviceCapability cap) const = 0;
 
   virtual void setEventCallback(EventCallback callback) = 0;
+
+  /**
+   * Receive one callback per hardware frame instead of one per event.
+   * When set, this replaces per-event delivery through setEventCallback().
+   */
+  virtual void setFrameCallback(FrameCallback callback) = 0;
+
+  /**
+   * Receive events as EventRecord by const reference. This path performs no
+   * heap allocation per event and may be combined with the callbacks above.
+   */
+  virtual void setEventRecordCallback(EventRecordCallback callback) = 0;
+
+  /**
+   * Publish events into a bounded lock-free queue that the application
+   * drains with pollEvents() from its own thread, so slow handlers never
+   * stall input reading. Must be called while not monitoring.
+   */
+  virtual bool enableEventQueue(
+      size_t capacity = 1024,
+      OverflowPolicy policy = OverflowPolicy::DROP_OLDEST) = 0;
+
+  /**
+   * Drain up to max_events queued events. Call from one thread only.
+   */
+  virtual size_t pollEvents(EventRecord *events, size_t max_events) = 0;
+
+  template <size_t N> size_t pollEvents(EventRecord (&events)[N]) {
+    return pollEvents(events, N);
+  }
+
+  /**
+   * eventfd that is readable while queued events are pending, for use with
+   * poll()/epoll in the application's own loop. -1 if no queue is enabled.
+   */
+  virtual int getEventFd() const = 0;
+
+  virtual EventQueueStats getEventQueueStats() const = 0;
+
+  /**
+   * Configure rotation coalescing. Must be called while not monitoring.
+   * Returns false if the device has no rotation input.
+   */
+  virtual bool setRotationCoalescing(const RotationCoalescing &options) = 0;
+
+  /**
+   * Kernel-event-to-callback latency for this device, safe to call from
+   * any thread while monitoring
+   */
+  virtual LatencyHistogram getLatencyHistogram() const = 0;
+
+  /**
+   * Start the histogram over. Safe from any thread while monitoring; it
+   * reads as empty from the moment this returns.
+   */
+  virtual void resetLatencyHistogram() = 0;
+
+  /**
+   * Current rotation totals, held buttons and last event time. Lock-free
+   * and allocation-free, safe to call from any thread at any rate. Only
+   * updated while monitoring, and it follows what is delivered, so
+   * rotations held back by coalescing show up when they are dispatched.
+   */
+  virtual DeviceState getState() const = 0;
+
+  /**
+   * Record the raw traffic read from the device while monitoring, for
+   * playback with Library::openReplay(). Returns false if the file can't be
+   * created or a capture is already running.
+   */
+  virtual bool startCapture(const std::string &path) = 0;
+  virtual void stopCapture() = 0;
+
+  /**
+   * Transform every frame through config and write it to a new uinput
+   * virtual device, from the thread that decoded it, in one write() per
+   * frame. Combine with grabExclusive(true) so the desktop only sees the
+   * remapped events. Needs write access to /dev/uinput. Must be called
+   * while not monitoring.
+   */
+  virtual bool enableRemapping(const RemapConfig &config) = 0;
+  virtual void disableRemapping() = 0;
+  virtual RemapStats getRemapStats() const = 0;
+
+  /**
+   * Used by Library's merged event stream: stamp every event from this
+   * device with handle and also hand it to sink, on the thread that
+   * decoded it. A null sink detaches. Safe while monitoring: once this
+   * returns, the previous sink is no longer running and won't be called.
+   */
+  virtual void setEventStreamSink(DeviceHandle handle,
+                                  EventRecordCallback sink) = 0;
+
   virtual void startMonitoring() = 0;
   virtual void stopMonitoring() = 0;
   virtual bool isMonitoring() const = 0;
@@ -6,6 +6,9 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <time.h>
+#include <type_traits>
+#include <vector>
 
 namespace LogiLinux {
 
@@ -42,9 +45,19 @@ enum class EventType {
   DEVICE_DISCONNECTED
 };
 
+/**
+ * Current CLOCK_MONOTONIC time in nanoseconds, the clock used for every
+ * Event::timestamp
+ */
+inline uint64_t getMonotonicTimestamp() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
 struct Event {
   EventType type;
-  uint64_t timestamp;
+  uint64_t timestamp; // CLOCK_MONOTONIC, nanoseconds
 
   Event() : type(EventType::ROTATION), timestamp(0) {}
   explicit Event(EventType t) : type(t), timestamp(0) {}
@@ -76,12 +89,95 @@ struct DeviceEvent : public Event {
   DeviceEvent() : Event(EventType::DEVICE_CONNECTED) {}
 };
 
+/**
+ * Small number naming a device in Library's merged event stream, 0 for
+ * none (see Library::addToEventStream())
+ */
+using DeviceHandle = uint16_t;
+
+/**
+ * Compact, fixed-size event record for allocation-free delivery.
+ * Trivially copyable: no heap, no RTTI. The active union member is
+ * selected by type (rotation for ROTATION, button for BUTTON_*).
+ */
+struct EventRecord {
+  struct Rotation {
+    RotationType rotation_type;
+    int32_t delta;
+    int32_t delta_high_res;
+    uint16_t raw_event_code;
+  };
+
+  struct Button {
+    uint32_t button_code;
+    bool pressed;
+  };
+
+  EventType type;
+  DeviceHandle device; // Source device once it joined the merged stream
+  uint64_t timestamp;  // CLOCK_MONOTONIC, nanoseconds
+  union {
+    Rotation rotation;
+    Button button;
+  };
+};
+
+static_assert(std::is_trivially_copyable<EventRecord>::value,
+              "EventRecord must stay trivially copyable");
+static_assert(sizeof(EventRecord) == 32, "EventRecord layout changed");
+
 using EventPtr = std::shared_ptr<Event>;
 using RotationEventPtr = std::shared_ptr<RotationEvent>;
 using ButtonEventPtr = std::shared_ptr<ButtonEvent>;
 using DeviceEventPtr = std::shared_ptr<DeviceEvent>;
 
 using EventCallback = std::function<void(EventPtr)>;
+using EventRecordCallback = std::function<void(const EventRecord &)>;
+
+// All events decoded from one hardware report (one SYN_REPORT for evdev
+// devices, one HID report for hidraw devices), in arrival order
+using EventFrame = std::vector<EventPtr>;
+using FrameCallback = std::function<void(const EventFrame &)>;
+
+/**
+ * Convert an EventRecord to the heap-allocated Event hierarchy used by
+ * EventCallback
+ */
+inline EventPtr makeEventPtr(const EventRecord &record) {
+  if (record.type == EventType::ROTATION) {
+    auto event = std::make_shared<RotationEvent>();
+    event->timestamp = record.timestamp;
+    event->rotation_type = record.rotation.rotation_type;
+    event->delta = record.rotation.delta;
+    event->delta_high_res = record.rotation.delta_high_res;
+    event->raw_event_code = record.rotation.raw_event_code;
+    return event;
+  }
+
+  if (record.type == EventType::BUTTON_PRESS ||
+      record.type == EventType::BUTTON_RELEASE) {
+    auto event = std::make_shared<ButtonEvent>();
+    event->type = record.type;
+    event->timestamp = record.timestamp;
+    event->button_code = record.button.button_code;
+    event->pressed = record.button.pressed;
+    return event;
+  }
+
+  auto event = std::make_shared<Event>(record.type);
+  event->timestamp = record.timestamp;
+  return event;
+}
+
+/**
+ * Wrap an EventCallback so it can be used where an EventRecordCallback is
+ * expected
+ */
+inline EventRecordCallback makeEventRecordCallback(EventCallback callback) {
+  return [callback](const EventRecord &record) {
+    callback(makeEventPtr(record));
+  };
+}
 
 inline DialpadButton getDialpadButton(uint32_t button_code) {
   switch (button_code) {
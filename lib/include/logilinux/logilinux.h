@@ -1,11 +1,13 @@
 #ifndef LOGILINUX_H
 #define LOGILINUX_H
 
+#include "action_executor.h"
 #include "device.h"
 #include "events.h"
 #include "version.h"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -19,6 +21,19 @@ namespace detail {
 bool hasLCD(CreativeConsoleDevice *device);
 }
 
+/**
+ * Playback pacing for Library::openReplay()
+ */
+enum class ReplaySpeed {
+  ORIGINAL, // Keep the recorded timing between reports
+  MAXIMUM,  // Decode as fast as possible
+};
+
+/**
+ * Called for each device that is plugged in (DEVICE_CONNECTED) or removed
+ * (DEVICE_DISCONNECTED)
+ */
+using HotplugCallback = std::function<void(DeviceEventPtr, DevicePtr)>;
 
 class Library {
 public:
@@ -28,12 +43,99 @@ public:
   Library(const Library &) = delete;
   Library &operator=(const Library &) = delete;
 
+  /**
+   * Scan for devices. Devices found by an earlier scan that are still
+   * present are returned as the same objects, so monitors, callbacks and
+   * LCD state survive a rescan; only new nodes create devices. Devices
+   * that are gone stop monitoring. While hotplug monitoring is on,
+   * differences are reported to its callback.
+   */
   std::vector<DevicePtr> discoverDevices();
 
+  /**
+   * Remember scan results on disk so later processes can skip the sysfs
+   * scan. The cached result is used as long as no node under /dev or
+   * /dev/input was created or removed and every cached node is unchanged;
+   * otherwise discovery rescans and refreshes the cache. An empty path
+   * means $XDG_CACHE_HOME/logilinux/devices.cache. Returns false if no
+   * cache location could be determined.
+   */
+  bool enableDiscoveryCache(const std::string &path = "");
+
   DevicePtr findDevice(DeviceType type);
 
   std::vector<DevicePtr> findDevices(DeviceType type);
 
+  /**
+   * Open a capture written by Device::startCapture() as a device that plays
+   * it back through the normal decoding path when monitoring starts.
+   * Returns nullptr if the file isn't a valid capture.
+   */
+  DevicePtr openReplay(const std::string &path,
+                       ReplaySpeed speed = ReplaySpeed::ORIGINAL);
+
+  /**
+   * Keep the device list current as devices come and go, using kernel
+   * uevents (or inotify on /dev where netlink isn't available). Only the
+   * node that changed is probed. The callback runs on the library's event
+   * thread. Returns false if neither source could be opened.
+   */
+  bool startHotplugMonitoring(HotplugCallback callback);
+  void stopHotplugMonitoring();
+  bool isHotplugMonitoring() const;
+
+  /**
+   * Merge a device's events into the library-wide stream drained by
+   * pollEvents()/dispatchEvents(). Every event of the device carries the
+   * returned handle in EventRecord::device (0 on failure). Each device is
+   * queued separately with the given capacity and overflow policy. Safe
+   * whether or not the device is monitoring; its events are merged from the
+   * next one decoded. Devices that disconnect are removed while hotplug
+   * monitoring is on.
+   */
+  DeviceHandle addToEventStream(
+      const DevicePtr &device, size_t capacity = 1024,
+      OverflowPolicy policy = OverflowPolicy::DROP_OLDEST);
+
+  /**
+   * Stop merging a device's events; events still queued for it are
+   * discarded. Safe while the device is monitoring: once this returns, none
+   * of its events reach the stream any more.
+   */
+  bool removeFromEventStream(const DevicePtr &device);
+
+  /**
+   * Drain up to max_events events from every device in the stream. Each
+   * device's events keep their order, and events queued at the time of the
+   * call are merged oldest timestamp first; an event still being decoded
+   * can come out behind newer ones of other devices. Call from one thread
+   * only.
+   */
+  size_t pollEvents(EventRecord *events, size_t max_events);
+
+  template <size_t N> size_t pollEvents(EventRecord (&events)[N]) {
+    return pollEvents(events, N);
+  }
+
+  /**
+   * Wait up to timeout_ms (-1: forever) for stream events and deliver them
+   * to callback on the calling thread, merged as pollEvents() does.
+   * Returns the number of events delivered.
+   */
+  size_t dispatchEvents(const EventRecordCallback &callback,
+                        int timeout_ms = -1);
+
+  /**
+   * eventfd that is readable while stream events are pending, for poll()
+   * or epoll in the application's own loop
+   */
+  int getEventFd() const;
+
+  /**
+   * Device an EventRecord::device handle refers to, or nullptr
+   */
+  DevicePtr getDevice(DeviceHandle handle) const;
+
   static Version getVersion();
 
 private:
@@ -0,0 +1,275 @@
+/*
+ * LogiLinux - Action Executor Implementation
+ */
+
+#include "logilinux/action_executor.h"
+#include "latency_recorder.h"
+#include "logilinux/events.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace LogiLinux {
+
+namespace {
+
+struct Task {
+  std::string key; // Empty: never coalesced
+  int64_t amount;
+  ActionExecutor::AmountAction amount_action;
+  ActionExecutor::Action action;
+  uint64_t submitted_ns;
+};
+
+} // namespace
+
+class ActionExecutor::Impl {
+public:
+  Impl(size_t workers, size_t capacity);
+  ~Impl();
+
+  bool enqueue(std::unique_ptr<Task> task);
+
+  // Fold into the queued task for key, or queue a new one, under one lock
+  // so concurrent submits for a key never both miss
+  bool submitKeyed(const std::string &key, int64_t amount,
+                   AmountAction action);
+  void wait();
+  ActionExecutorStats stats() const;
+
+private:
+  void run();
+  bool enqueueLocked(std::unique_ptr<Task> task);
+
+  // First queued task whose key isn't running, so one key's actions never
+  // overlap or overtake each other
+  std::deque<std::unique_ptr<Task>>::iterator findRunnable();
+
+  size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::deque<std::unique_ptr<Task>> queue_;
+  std::unordered_map<std::string, Task *> queued_keys_;
+  std::unordered_set<std::string> running_keys_;
+  size_t running_;
+  bool stopping_;
+
+  // Written with mutex_ held, which is all LatencyRecorder needs from its
+  // single writer
+  LatencyRecorder queue_latency_;
+  LatencyRecorder execution_latency_;
+  size_t high_water_;
+  uint64_t submitted_;
+  uint64_t coalesced_;
+  uint64_t rejected_;
+  uint64_t executed_;
+  uint64_t failed_;
+
+  std::vector<std::thread> workers_;
+};
+
+ActionExecutor::Impl::Impl(size_t workers, size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), running_(0), stopping_(false),
+      high_water_(0), submitted_(0), coalesced_(0), rejected_(0),
+      executed_(0), failed_(0) {
+  workers = std::max<size_t>(workers, 1);
+  for (size_t i = 0; i < workers; i++) {
+    workers_.emplace_back(&Impl::run, this);
+  }
+}
+
+ActionExecutor::Impl::~Impl() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    queue_.clear();
+    queued_keys_.clear();
+  }
+  work_cv_.notify_all();
+  idle_cv_.notify_all();
+
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+bool ActionExecutor::Impl::enqueue(std::unique_ptr<Task> task) {
+  bool queued;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued = enqueueLocked(std::move(task));
+  }
+  if (queued) {
+    work_cv_.notify_one();
+  }
+  return queued;
+}
+
+bool ActionExecutor::Impl::submitKeyed(const std::string &key,
+                                       int64_t amount, AmountAction action) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = queued_keys_.find(key);
+    if (it != queued_keys_.end()) {
+      // Keeps its place in the queue and its submission time, so the
+      // latency reported is that of the oldest request it carries
+      submitted_++;
+      coalesced_++;
+      it->second->amount += amount;
+      it->second->amount_action = std::move(action);
+      return true;
+    }
+
+    auto task = std::make_unique<Task>();
+    task->key = key;
+    task->amount = amount;
+    task->amount_action = std::move(action);
+    if (!enqueueLocked(std::move(task))) {
+      return false;
+    }
+  }
+  work_cv_.notify_one();
+  return true;
+}
+
+bool ActionExecutor::Impl::enqueueLocked(std::unique_ptr<Task> task) {
+  submitted_++;
+  if (stopping_ || queue_.size() >= capacity_) {
+    rejected_++;
+    return false;
+  }
+
+  task->submitted_ns = getMonotonicTimestamp();
+  if (!task->key.empty()) {
+    queued_keys_[task->key] = task.get();
+  }
+  queue_.push_back(std::move(task));
+  high_water_ = std::max(high_water_, queue_.size());
+  return true;
+}
+
+void ActionExecutor::Impl::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock,
+                [this] { return stopping_ || (queue_.empty() && !running_); });
+}
+
+ActionExecutorStats ActionExecutor::Impl::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ActionExecutorStats stats;
+  stats.workers = workers_.size();
+  stats.capacity = capacity_;
+  stats.depth = queue_.size();
+  stats.high_water = high_water_;
+  stats.submitted = submitted_;
+  stats.coalesced = coalesced_;
+  stats.rejected = rejected_;
+  stats.executed = executed_;
+  stats.failed = failed_;
+  stats.queue_latency = queue_latency_.snapshot();
+  stats.execution_latency = execution_latency_.snapshot();
+  return stats;
+}
+
+std::deque<std::unique_ptr<Task>>::iterator
+ActionExecutor::Impl::findRunnable() {
+  return std::find_if(queue_.begin(), queue_.end(),
+                      [this](const std::unique_ptr<Task> &task) {
+                        return task->key.empty() ||
+                               running_keys_.count(task->key) == 0;
+                      });
+}
+
+void ActionExecutor::Impl::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (true) {
+    auto next = queue_.end();
+    work_cv_.wait(lock, [&] {
+      next = findRunnable();
+      return stopping_ || next != queue_.end();
+    });
+    if (stopping_) {
+      return;
+    }
+
+    std::unique_ptr<Task> task = std::move(*next);
+    queue_.erase(next);
+    if (!task->key.empty()) {
+      queued_keys_.erase(task->key);
+      running_keys_.insert(task->key);
+    }
+    running_++;
+    queue_latency_.record(task->submitted_ns);
+    lock.unlock();
+
+    uint64_t started_ns = getMonotonicTimestamp();
+    bool failed = false;
+    try {
+      if (task->amount_action) {
+        task->amount_action(task->amount);
+      } else if (task->action) {
+        task->action();
+      }
+    } catch (...) {
+      // An action's failure is its own business; the worker must survive
+      failed = true;
+    }
+
+    lock.lock();
+    execution_latency_.record(started_ns);
+    executed_++;
+    if (failed) {
+      failed_++;
+    }
+    running_--;
+    if (!task->key.empty()) {
+      running_keys_.erase(task->key);
+      // A follow-up for this key may have been skipped while it ran
+      work_cv_.notify_one();
+    }
+    if (queue_.empty() && !running_) {
+      idle_cv_.notify_all();
+    }
+  }
+}
+
+ActionExecutor::ActionExecutor(size_t workers, size_t capacity)
+    : pImpl(std::make_unique<Impl>(workers, capacity)) {}
+
+ActionExecutor::~ActionExecutor() = default;
+
+bool ActionExecutor::submit(Action action) {
+  if (!action) {
+    return false;
+  }
+
+  auto task = std::make_unique<Task>();
+  task->amount = 0;
+  task->action = std::move(action);
+  return pImpl->enqueue(std::move(task));
+}
+
+bool ActionExecutor::submit(const std::string &key, int64_t amount,
+                            AmountAction action) {
+  if (!action) {
+    return false;
+  }
+  if (key.empty()) {
+    return submit([action, amount] { action(amount); });
+  }
+  return pImpl->submitKeyed(key, amount, std::move(action));
+}
+
+void ActionExecutor::wait() { pImpl->wait(); }
+
+ActionExecutorStats ActionExecutor::getStats() const { return pImpl->stats(); }
+
+} // namespace LogiLinux
@@ -1,15 +1,10 @@
-
 #include "device_manager.h"
 #include "../devices/dialpad_device.h"
 #include "../devices/mx_keypad_device.h"
+#include "sysfs.h"
 
 #include <algorithm>
-#include <cstring>
-#include <dirent.h>
-#include <fcntl.h>
-#include <linux/hidraw.h>
-#include <linux/input.h>
-#include <sys/ioctl.h>
+#include <cstdio>
 #include <unistd.h>
 
 namespace LogiLinux {
@@ -19,164 +14,320 @@ constexpr uint16_t LOGITECH_VENDOR_ID = 0x046d;
 constexpr uint16_t MX_DIALPAD_PRODUCT_ID = 0xbc00;
 constexpr uint16_t MX_KEYPAD_PRODUCT_ID = 0xc354;
 
-DeviceManager::DeviceManager() {}
-
-DeviceManager::~DeviceManager() {}
-
-std::vector<DevicePtr> DeviceManager::scanDevices() {
-  discovered_devices_.clear();
-
-  // Scan /dev/input/event* devices
-  DIR *dir = opendir("/dev/input");
-  if (dir) {
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != nullptr) {
-      std::string name = entry->d_name;
-
-      if (name.find("event") == 0) {
-        std::string device_path = "/dev/input/" + name;
+// Directory `levels` above path. Two levels above a HID device is the USB
+// device when it is plugged in directly (its interfaces are siblings below
+// it), or the receiver interface for devices paired to a receiver.
+static std::string ancestorOf(const std::string &path, int levels) {
+  std::string result = path;
+  for (int i = 0; i < levels; i++) {
+    size_t slash = result.find_last_of('/');
+    if (slash == std::string::npos || slash == 0) {
+      return "";
+    }
+    result.erase(slash);
+  }
+  return result;
+}
 
-        auto info = probeDevice(device_path);
-        if (info) {
-          DevicePtr device;
+// Physical path without the interface, e.g. "usb-0000:00:14.0-2"
+static std::string physPrefix(const std::string &phys) {
+  return phys.substr(0, phys.find_last_of('/'));
+}
 
-          switch (info->type) {
-          case DeviceType::DIALPAD:
-            device = std::make_shared<DialpadDevice>(*info);
-            break;
+DeviceManager::DeviceManager(const std::string &sysfs_root,
+                             const std::string &dev_root)
+    : sysfs_root_(sysfs_root), dev_root_(dev_root) {}
 
-          case DeviceType::MX_KEYPAD:
-            device = std::make_shared<MXKeypadDevice>(*info);
-            break;
+DeviceManager::~DeviceManager() {}
 
-          default:
-            break;
-          }
+std::vector<DeviceInfo> DeviceManager::scanDevices() {
+  if (!cache_) {
+    return scanSysfs();
+  }
 
-          if (device) {
-            discovered_devices_.push_back(device);
-          }
-        }
+  std::vector<DeviceInfo> infos;
+  if (cache_->load(infos)) {
+    // hidraw nodes are needed again for pairing nodes added later
+    hidraw_infos_.clear();
+    for (const auto &info : infos) {
+      if (info.hidraw_path == info.device_path) {
+        hidraw_infos_.push_back(std::make_unique<DeviceInfo>(info));
       }
     }
-    closedir(dir);
+    return infos;
   }
 
-  // Also scan /dev/hidraw* devices for devices that don't have event interfaces
-  for (int i = 0; i < 20; i++) {
-    std::string hidraw_path = "/dev/hidraw" + std::to_string(i);
-    auto info = probeHidrawDevice(hidraw_path);
-    if (info) {
-      DevicePtr device;
+  DiscoveryCache::Stamp stamp = cache_->stamp();
+  infos = scanSysfs();
+  cache_->store(stamp, infos);
+  return infos;
+}
 
-      switch (info->type) {
-      case DeviceType::MX_KEYPAD:
-        device = std::make_shared<MXKeypadDevice>(*info);
-        break;
+void DeviceManager::setCachePath(const std::string &path) {
+  if (path.empty()) {
+    cache_.reset();
+  } else {
+    cache_ = std::make_unique<DiscoveryCache>(path, dev_root_);
+  }
+}
 
-      default:
-        break;
-      }
+std::vector<DeviceInfo> DeviceManager::scanSysfs() {
+  std::vector<DeviceInfo> infos;
 
-      if (device) {
-        discovered_devices_.push_back(device);
-      }
+  // hidraw nodes first: keypad event nodes need them for LCD control
+  hidraw_infos_.clear();
+  for (const auto &name :
+       Sysfs::listEntries(sysfs_root_ + "/class/hidraw", "hidraw")) {
+    auto info = probeHidrawNode(name);
+    if (info) {
+      info->hidraw_path = info->device_path;
+      identifyDevice(*info);
+      hidraw_infos_.push_back(std::move(info));
     }
   }
 
-  return discovered_devices_;
-}
+  for (const auto &name :
+       Sysfs::listEntries(sysfs_root_ + "/class/input", "event")) {
+    auto info = probeInputNode(name);
+    if (!info) {
+      continue;
+    }
 
-std::vector<DevicePtr> DeviceManager::findDevicesByType(DeviceType type) {
-  std::vector<DevicePtr> result;
+    info->hidraw_path = findHidrawNode(*info, hidraw_infos_);
+    identifyDevice(*info);
+    infos.push_back(std::move(*info));
+  }
 
-  for (const auto &device : discovered_devices_) {
-    if (device->getType() == type) {
-      result.push_back(device);
-    }
+  // Also list hidraw nodes for devices that don't have event interfaces
+  for (const auto &info : hidraw_infos_) {
+    infos.push_back(*info);
   }
 
-  return result;
+  return infos;
 }
 
 std::unique_ptr<DeviceInfo>
-DeviceManager::probeDevice(const std::string &device_path) {
-  int fd = open(device_path.c_str(), O_RDONLY | O_NONBLOCK);
-  if (fd < 0) {
+DeviceManager::probeNode(const std::string &devname) {
+  // Only event nodes, like scanSysfs(): mouseN and jsN of the same input
+  // device would pass the id check but aren't listed by a rescan
+  if (devname.compare(0, 11, "input/event") == 0) {
+    auto info = probeInputNode(devname.substr(6));
+    if (info) {
+      info->hidraw_path = findHidrawNode(*info, hidraw_infos_);
+      identifyDevice(*info);
+    }
+    return info;
+  }
+  if (devname.compare(0, 6, "hidraw") != 0) {
     return nullptr;
   }
 
-  struct input_id id;
-  if (ioctl(fd, EVIOCGID, &id) < 0) {
-    close(fd);
+  auto info = probeHidrawNode(devname);
+  if (!info) {
     return nullptr;
   }
 
-  if (id.vendor != LOGITECH_VENDOR_ID) {
-    close(fd);
+  info->hidraw_path = info->device_path;
+  identifyDevice(*info);
+
+  removeNode(devname);
+  hidraw_infos_.push_back(std::make_unique<DeviceInfo>(*info));
+  return info;
+}
+
+void DeviceManager::removeNode(const std::string &devname) {
+  std::string device_path = devicePath(devname);
+  hidraw_infos_.erase(
+      std::remove_if(hidraw_infos_.begin(), hidraw_infos_.end(),
+                     [&device_path](const std::unique_ptr<DeviceInfo> &info) {
+                       return info->device_path == device_path;
+                     }),
+      hidraw_infos_.end());
+}
+
+std::string DeviceManager::findHidrawNode(const DeviceInfo &info) const {
+  return findHidrawNode(info, hidraw_infos_);
+}
+
+std::string DeviceManager::devicePath(const std::string &devname) const {
+  return dev_root_ + "/" + devname;
+}
+
+DevicePtr DeviceManager::createDevice(const DeviceInfo &info) {
+  switch (info.type) {
+  case DeviceType::DIALPAD:
+    // Only the event node carries the dial; a dialpad hidraw node has
+    // nothing to offer on its own
+    if (info.device_path != info.hidraw_path) {
+      return std::make_shared<DialpadDevice>(info);
+    }
     return nullptr;
-  }
 
-  char name[256] = "Unknown";
-  ioctl(fd, EVIOCGNAME(sizeof(name)), name);
+  case DeviceType::MX_KEYPAD:
+    return std::make_shared<MXKeypadDevice>(info);
+
+  default:
+    return nullptr;
+  }
+}
 
-  close(fd);
+std::unique_ptr<DeviceInfo>
+DeviceManager::probeInputNode(const std::string &node_name) {
+  // The input device's id/ attributes are what EVIOCGID would report
+  std::string device_dir =
+      sysfs_root_ + "/class/input/" + node_name + "/device";
+
+  uint16_t vendor_id = 0;
+  uint16_t product_id = 0;
+  if (!Sysfs::readHexAttribute(device_dir + "/id/vendor", vendor_id) ||
+      vendor_id != LOGITECH_VENDOR_ID ||
+      !Sysfs::readHexAttribute(device_dir + "/id/product", product_id)) {
+    return nullptr;
+  }
 
-  DeviceType type = identifyDeviceType(id.vendor, id.product);
+  DeviceType type = identifyDeviceType(vendor_id, product_id);
 
   if (type == DeviceType::UNKNOWN) {
     return nullptr;
   }
 
+  // sysfs can briefly list a device before udev has created its node
+  std::string device_path = dev_root_ + "/input/" + node_name;
+  if (access(device_path.c_str(), F_OK) < 0) {
+    return nullptr;
+  }
+
+  std::string name;
+  if (!Sysfs::readAttribute(device_dir + "/name", name)) {
+    name = "Unknown";
+  }
+
   auto info = std::make_unique<DeviceInfo>();
   info->name = name;
   info->device_path = device_path;
-  info->vendor_id = id.vendor;
-  info->product_id = id.product;
+  info->vendor_id = vendor_id;
+  info->product_id = product_id;
   info->type = type;
 
+  Sysfs::readAttribute(device_dir + "/phys", info->phys);
+  Sysfs::readAttribute(device_dir + "/uniq", info->serial);
+
+  // The input device's parent is the HID device, except for virtual
+  // devices (uinput) which have none
+  info->sysfs_path = Sysfs::resolvePath(device_dir + "/device");
+  if (info->sysfs_path.empty()) {
+    info->sysfs_path = Sysfs::resolvePath(device_dir);
+  }
+
   return info;
 }
 
 std::unique_ptr<DeviceInfo>
-DeviceManager::probeHidrawDevice(const std::string &device_path) {
-  int fd = open(device_path.c_str(), O_RDWR | O_NONBLOCK);
-  if (fd < 0) {
+DeviceManager::probeHidrawNode(const std::string &node_name) {
+  Uevent uevent;
+  if (!uevent.load(sysfs_root_ + "/class/hidraw/" + node_name +
+                   "/device/uevent")) {
     return nullptr;
   }
 
-  struct hidraw_devinfo info;
-  if (ioctl(fd, HIDIOCGRAWINFO, &info) < 0) {
-    close(fd);
+  uint16_t bus = 0;
+  uint16_t vendor_id = 0;
+  uint16_t product_id = 0;
+  if (!Sysfs::parseHidId(uevent.get("HID_ID"), bus, vendor_id, product_id) ||
+      vendor_id != LOGITECH_VENDOR_ID) {
     return nullptr;
   }
 
-  if (info.vendor != LOGITECH_VENDOR_ID) {
-    close(fd);
+  DeviceType type = identifyDeviceType(vendor_id, product_id);
+
+  if (type == DeviceType::UNKNOWN) {
     return nullptr;
   }
 
-  char name[256] = "Unknown";
-  ioctl(fd, HIDIOCGRAWNAME(sizeof(name)), name);
-
-  close(fd);
-
-  DeviceType type = identifyDeviceType(info.vendor, info.product);
-
-  if (type == DeviceType::UNKNOWN) {
+  std::string device_path = dev_root_ + "/" + node_name;
+  if (access(device_path.c_str(), F_OK) < 0) {
     return nullptr;
   }
 
+  std::string name = uevent.get("HID_NAME");
+
   auto device_info = std::make_unique<DeviceInfo>();
-  device_info->name = name;
+  device_info->name = name.empty() ? "Unknown" : name;
   device_info->device_path = device_path;
-  device_info->vendor_id = info.vendor;
-  device_info->product_id = info.product;
+  device_info->vendor_id = vendor_id;
+  device_info->product_id = product_id;
   device_info->type = type;
+  device_info->phys = uevent.get("HID_PHYS");
+  device_info->serial = uevent.get("HID_UNIQ");
+  device_info->sysfs_path = Sysfs::resolvePath(sysfs_root_ + "/class/hidraw/" +
+                                               node_name + "/device");
 
   return device_info;
 }
 
+std::string DeviceManager::findHidrawNode(
+    const DeviceInfo &info,
+    const std::vector<std::unique_ptr<DeviceInfo>> &hidraws) const {
+  auto sameModel = [&info](const DeviceInfo &hidraw) {
+    return hidraw.vendor_id == info.vendor_id &&
+           hidraw.product_id == info.product_id;
+  };
+
+  // Same HID device (also the case for devices behind a receiver)
+  if (!info.sysfs_path.empty()) {
+    for (const auto &hidraw : hidraws) {
+      if (sameModel(*hidraw) && hidraw->sysfs_path == info.sysfs_path) {
+        return hidraw->device_path;
+      }
+    }
+  }
+
+  // Another interface of the same USB device
+  std::string usb_device = ancestorOf(info.sysfs_path, 2);
+  if (!usb_device.empty()) {
+    for (const auto &hidraw : hidraws) {
+      if (sameModel(*hidraw) &&
+          ancestorOf(hidraw->sysfs_path, 2) == usb_device) {
+        return hidraw->device_path;
+      }
+    }
+  }
+
+  // No usable topology: match the port in the physical path
+  if (!info.phys.empty()) {
+    for (const auto &hidraw : hidraws) {
+      if (sameModel(*hidraw) && !hidraw->phys.empty() &&
+          physPrefix(hidraw->phys) == physPrefix(info.phys)) {
+        return hidraw->device_path;
+      }
+    }
+  }
+
+  return "";
+}
+
+void DeviceManager::identifyDevice(DeviceInfo &info) {
+  // Directly attached USB devices keep their serial on the USB device
+  if (info.serial.empty() && !info.sysfs_path.empty()) {
+    Sysfs::readAttribute(ancestorOf(info.sysfs_path, 2) + "/serial",
+                         info.serial);
+  }
+
+  char model[16];
+  snprintf(model, sizeof(model), "%04x:%04x", info.vendor_id,
+           info.product_id);
+
+  if (!info.serial.empty()) {
+    info.identity = std::string(model) + ":" + info.serial;
+  } else if (!info.phys.empty()) {
+    info.identity = std::string(model) + "@" + physPrefix(info.phys);
+  } else if (!info.sysfs_path.empty()) {
+    info.identity = std::string(model) + "@" + info.sysfs_path;
+  } else {
+    info.identity = std::string(model) + "@" + info.device_path;
+  }
+}
+
 DeviceType DeviceManager::identifyDeviceType(uint16_t vendor_id,
                                              uint16_t product_id) {
   if (vendor_id != LOGITECH_VENDOR_ID) {
@@ -1,47 +1,108 @@
-
 #ifndef LOGILINUX_DEVICE_MANAGER_H
 #define LOGILINUX_DEVICE_MANAGER_H
 
+#include "discovery_cache.h"
 #include "logilinux/device.h"
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace LogiLinux {
 
 class DeviceManager {
 public:
-  DeviceManager();
+  /**
+   * Discovery reads device attributes below sysfs_root and hands out nodes
+   * below dev_root. Both are only changed to run against a fake tree.
+   */
+  explicit DeviceManager(const std::string &sysfs_root = "/sys",
+                         const std::string &dev_root = "/dev");
   ~DeviceManager();
 
   /**
-   * Scan for all Logitech devices
+   * Scan for all Logitech device nodes. Only sysfs is read; no device node
+   * is opened and no device object is created (see createDevice()). With a
+   * cache set, a still-valid cached result is returned instead and a real
+   * scan is written back to it.
+   */
+  std::vector<DeviceInfo> scanDevices();
+
+  /**
+   * Keep an on-disk cache of the last scan at path; an empty path turns
+   * the cache off
+   */
+  void setCachePath(const std::string &path);
+
+  /**
+   * Probe a single node that just appeared, named relative to the /dev
+   * root as in a uevent's DEVNAME ("input/event5", "hidraw3"). Event nodes
+   * are paired with the hidraw nodes seen so far. Returns nullptr if the
+   * node isn't a supported Logitech device; input nodes other than
+   * eventN (mouseN, jsN) never are.
+   */
+  std::unique_ptr<DeviceInfo> probeNode(const std::string &devname);
+
+  /**
+   * Forget a node that went away
+   */
+  void removeNode(const std::string &devname);
+
+  /**
+   * hidraw node belonging to the same physical device as info among the
+   * hidraw nodes seen so far, or an empty string
    */
-  std::vector<DevicePtr> scanDevices();
+  std::string findHidrawNode(const DeviceInfo &info) const;
 
   /**
-   * Find devices by type
+   * Full node path for a DEVNAME
    */
-  std::vector<DevicePtr> findDevicesByType(DeviceType type);
+  std::string devicePath(const std::string &devname) const;
+
+  /**
+   * Device object for a probed node, or nullptr for unsupported types
+   */
+  static DevicePtr createDevice(const DeviceInfo &info);
 
 private:
+  std::vector<DeviceInfo> scanSysfs();
+
   /**
-   * Check if a device path is a Logitech device
+   * Check if an input event node (e.g. "event5") is a Logitech device
    * Returns DeviceInfo if valid, nullptr otherwise
    */
-  std::unique_ptr<DeviceInfo> probeDevice(const std::string &device_path);
+  std::unique_ptr<DeviceInfo> probeInputNode(const std::string &node_name);
 
   /**
-   * Check if a hidraw device is a Logitech device
+   * Check if a hidraw node (e.g. "hidraw3") is a Logitech device
    * Returns DeviceInfo if valid, nullptr otherwise
    */
-  std::unique_ptr<DeviceInfo> probeHidrawDevice(const std::string &device_path);
+  std::unique_ptr<DeviceInfo> probeHidrawNode(const std::string &node_name);
+
+  /**
+   * hidraw node belonging to the same physical device as info, or an empty
+   * string. Matched through the shared HID/USB parent in sysfs, falling back
+   * to the physical path when the topology isn't available.
+   */
+  std::string
+  findHidrawNode(const DeviceInfo &info,
+                 const std::vector<std::unique_ptr<DeviceInfo>> &hidraws) const;
+
+  /**
+   * Fill in serial (if not known yet) and identity
+   */
+  void identifyDevice(DeviceInfo &info);
 
   /**
    * Identify device type from VID/PID
    */
   DeviceType identifyDeviceType(uint16_t vendor_id, uint16_t product_id);
 
-  std::vector<DevicePtr> discovered_devices_;
+  std::string sysfs_root_;
+  std::string dev_root_;
+  // hidraw nodes from the last scan plus those added since, for pairing
+  std::vector<std::unique_ptr<DeviceInfo>> hidraw_infos_;
+
+  std::unique_ptr<DiscoveryCache> cache_;
 };
 
 } // namespace LogiLinux
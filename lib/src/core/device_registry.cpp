@@ -0,0 +1,265 @@
+/*
+ * LogiLinux - Device Registry Implementation
+ */
+
+#include "device_registry.h"
+#include "../devices/mx_keypad_device.h"
+#include <algorithm>
+
+namespace LogiLinux {
+
+static DeviceEventPtr makeDeviceEvent(EventType type,
+                                      const std::string &device_path) {
+  auto event = std::make_shared<DeviceEvent>();
+  event->type = type;
+  event->timestamp = getMonotonicTimestamp();
+  event->device_path = device_path;
+  return event;
+}
+
+// Same node of the same physical device; the hidraw pairing may differ
+static bool isSameDevice(const DeviceInfo &a, const DeviceInfo &b) {
+  return a.device_path == b.device_path && a.identity == b.identity;
+}
+
+// Bring a kept device's hidraw pairing up to date with a fresh probe.
+// Only a keypad's event node can be re-paired in place (gaining, losing or
+// swapping its hidraw node); false for any other change.
+static bool updatePairing(const DevicePtr &device, const DeviceInfo &current,
+                          const DeviceInfo &info, bool &repaired) {
+  repaired = false;
+  if (current.hidraw_path == info.hidraw_path) {
+    return true;
+  }
+  if (current.type != DeviceType::MX_KEYPAD) {
+    return false;
+  }
+
+  auto keypad = std::static_pointer_cast<MXKeypadDevice>(device);
+  if (!current.hidraw_path.empty() &&
+      !keypad->detachHidraw(current.hidraw_path)) {
+    return false;
+  }
+  if (!info.hidraw_path.empty()) {
+    keypad->attachHidraw(info.hidraw_path);
+  }
+  repaired = true;
+  return true;
+}
+
+// Devices the registry drops are stopped before they are reported, so
+// nothing keeps reading a node that is gone (or that a new device now
+// owns) and DEVICE_DISCONNECTED handlers may detach them from a stream
+static void stopDropped(const std::vector<DeviceEventPtr> &events,
+                        const std::vector<DevicePtr> &changed) {
+  for (size_t i = 0; i < events.size(); i++) {
+    if (events[i]->type == EventType::DEVICE_DISCONNECTED) {
+      changed[i]->stopMonitoring();
+    }
+  }
+}
+
+DeviceRegistry::DeviceRegistry(std::unique_ptr<DeviceManager> manager)
+    : manager_(std::move(manager)) {}
+
+std::vector<DevicePtr> DeviceRegistry::scan(const ChangeCallback &callback) {
+  std::vector<DeviceEventPtr> events;
+  std::vector<DevicePtr> changed;
+  std::vector<DevicePtr> result;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DeviceInfo> infos = manager_->scanDevices();
+
+    std::vector<DevicePtr> devices;
+    devices.reserve(infos.size());
+    std::vector<bool> kept(devices_.size(), false);
+
+    for (const auto &info : infos) {
+      DevicePtr device;
+      for (size_t i = 0; i < devices_.size(); i++) {
+        if (kept[i]) {
+          continue;
+        }
+        DeviceInfo current = devices_[i]->getInfo();
+        bool repaired;
+        if (isSameDevice(current, info) &&
+            updatePairing(devices_[i], current, info, repaired)) {
+          device = devices_[i];
+          kept[i] = true;
+          if (repaired) {
+            // Reported connected again, as when hotplug pairs it
+            events.push_back(makeDeviceEvent(EventType::DEVICE_CONNECTED,
+                                             info.device_path));
+            changed.push_back(device);
+          }
+          break;
+        }
+      }
+
+      if (!device) {
+        device = DeviceManager::createDevice(info);
+        if (!device) {
+          continue;
+        }
+        events.push_back(
+            makeDeviceEvent(EventType::DEVICE_CONNECTED, info.device_path));
+        changed.push_back(device);
+      }
+
+      devices.push_back(device);
+    }
+
+    for (size_t i = 0; i < devices_.size(); i++) {
+      if (!kept[i]) {
+        events.push_back(makeDeviceEvent(EventType::DEVICE_DISCONNECTED,
+                                         devices_[i]->getInfo().device_path));
+        changed.push_back(devices_[i]);
+      }
+    }
+
+    devices_ = std::move(devices);
+    result = devices_;
+  }
+
+  stopDropped(events, changed);
+  if (callback) {
+    for (size_t i = 0; i < events.size(); i++) {
+      callback(events[i], changed[i]);
+    }
+  }
+
+  return result;
+}
+
+void DeviceRegistry::setCachePath(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  manager_->setCachePath(path);
+}
+
+std::vector<DevicePtr> DeviceRegistry::devices() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return devices_;
+}
+
+bool DeviceRegistry::empty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return devices_.empty();
+}
+
+void DeviceRegistry::handleUevent(const UeventMessage &message,
+                                  const ChangeCallback &callback) {
+  std::vector<DeviceEventPtr> events;
+  std::vector<DevicePtr> changed;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (message.action == "add") {
+      addNode(message.devname, events, changed);
+    } else if (message.action == "remove") {
+      removeNode(message.devname, events, changed);
+    }
+  }
+
+  // Outside the lock so callbacks may query the registry
+  stopDropped(events, changed);
+  if (callback) {
+    for (size_t i = 0; i < events.size(); i++) {
+      callback(events[i], changed[i]);
+    }
+  }
+}
+
+void DeviceRegistry::addNode(const std::string &devname,
+                             std::vector<DeviceEventPtr> &events,
+                             std::vector<DevicePtr> &changed) {
+  std::string device_path = manager_->devicePath(devname);
+
+  // The same node can be reported twice, e.g. by a scan racing a uevent
+  for (const auto &device : devices_) {
+    if (device->getInfo().device_path == device_path) {
+      return;
+    }
+  }
+
+  auto info = manager_->probeNode(devname);
+  if (!info) {
+    return;
+  }
+
+  DevicePtr device = DeviceManager::createDevice(*info);
+  if (!device) {
+    return;
+  }
+
+  devices_.push_back(device);
+  events.push_back(
+      makeDeviceEvent(EventType::DEVICE_CONNECTED, info->device_path));
+  changed.push_back(device);
+
+  if (info->hidraw_path != info->device_path) {
+    return;
+  }
+
+  // A keypad's hidraw node usually shows up after its event node, which
+  // was then registered without one. Pair those devices in place, so
+  // callers holding them keep a live device that now has its LCD; they
+  // are reported connected again to say so.
+  for (const auto &existing : devices_) {
+    const DeviceInfo &existing_info = existing->getInfo();
+    if (existing_info.type != DeviceType::MX_KEYPAD ||
+        !existing_info.hidraw_path.empty() ||
+        manager_->findHidrawNode(existing_info) != info->device_path) {
+      continue;
+    }
+
+    auto keypad = std::static_pointer_cast<MXKeypadDevice>(existing);
+    if (!keypad->attachHidraw(info->device_path)) {
+      continue;
+    }
+
+    events.push_back(makeDeviceEvent(EventType::DEVICE_CONNECTED,
+                                     existing_info.device_path));
+    changed.push_back(existing);
+  }
+}
+
+void DeviceRegistry::removeNode(const std::string &devname,
+                                std::vector<DeviceEventPtr> &events,
+                                std::vector<DevicePtr> &changed) {
+  // sysfs is already gone, so the node is matched by path alone
+  manager_->removeNode(devname);
+
+  std::string device_path = manager_->devicePath(devname);
+  auto it = std::find_if(devices_.begin(), devices_.end(),
+                         [&device_path](const DevicePtr &device) {
+                           return device->getInfo().device_path ==
+                                  device_path;
+                         });
+  if (it != devices_.end()) {
+    events.push_back(
+        makeDeviceEvent(EventType::DEVICE_DISCONNECTED, device_path));
+    changed.push_back(*it);
+    devices_.erase(it);
+  }
+
+  // Keypads paired with a removed hidraw node lose it in place (and are
+  // reported connected again, without the LCD), so the node pairs again
+  // through addNode() when it comes back instead of staying stale
+  for (const auto &device : devices_) {
+    if (device->getType() != DeviceType::MX_KEYPAD) {
+      continue;
+    }
+
+    auto keypad = std::static_pointer_cast<MXKeypadDevice>(device);
+    if (!keypad->detachHidraw(device_path)) {
+      continue;
+    }
+
+    events.push_back(makeDeviceEvent(EventType::DEVICE_CONNECTED,
+                                     device->getInfo().device_path));
+    changed.push_back(device);
+  }
+}
+
+} // namespace LogiLinux
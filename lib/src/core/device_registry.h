@@ -0,0 +1,83 @@
+/*
+ * LogiLinux - Device Registry
+ * The set of known devices, kept current by scans and hotplug uevents
+ */
+
+#ifndef LOGILINUX_DEVICE_REGISTRY_H
+#define LOGILINUX_DEVICE_REGISTRY_H
+
+#include "device_manager.h"
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include "uevent_source.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace LogiLinux {
+
+class DeviceRegistry {
+public:
+  /**
+   * Called with DEVICE_CONNECTED or DEVICE_DISCONNECTED and the device
+   * that was added or removed
+   */
+  using ChangeCallback = std::function<void(DeviceEventPtr, DevicePtr)>;
+
+  explicit DeviceRegistry(std::unique_ptr<DeviceManager> manager);
+
+  DeviceRegistry(const DeviceRegistry &) = delete;
+  DeviceRegistry &operator=(const DeviceRegistry &) = delete;
+
+  /**
+   * Rescan sysfs and reconcile the registry with it. A device whose node
+   * path and identity are unchanged keeps its object (and with it any
+   * monitor, callbacks and LCD state); a keypad whose hidraw node showed up,
+   * went away or changed since is re-paired in place and reported as
+   * DEVICE_CONNECTED again. Only
+   * nodes that appeared or went away create or drop devices, and those
+   * changes are reported through callback if one is given. Dropped devices
+   * have their monitoring stopped before they are reported.
+   */
+  std::vector<DevicePtr> scan(const ChangeCallback &callback = nullptr);
+
+  /**
+   * See DeviceManager::setCachePath()
+   */
+  void setCachePath(const std::string &path);
+
+  /**
+   * Snapshot of the registered devices
+   */
+  std::vector<DevicePtr> devices() const;
+
+  bool empty() const;
+
+  /**
+   * Apply one uevent: probe just the node that was added, or drop the
+   * device whose node was removed. A keypad's hidraw node arriving after
+   * its event node is attached to the existing device, and detached again
+   * when it is removed; either way that device is reported as
+   * DEVICE_CONNECTED again. Changes are reported through callback after
+   * the registry has been updated; a dropped device's monitoring is
+   * stopped first.
+   */
+  void handleUevent(const UeventMessage &message,
+                    const ChangeCallback &callback);
+
+private:
+  void addNode(const std::string &devname, std::vector<DeviceEventPtr> &events,
+               std::vector<DevicePtr> &changed);
+  void removeNode(const std::string &devname,
+                  std::vector<DeviceEventPtr> &events,
+                  std::vector<DevicePtr> &changed);
+
+  mutable std::mutex mutex_;
+  std::unique_ptr<DeviceManager> manager_;
+  std::vector<DevicePtr> devices_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_DEVICE_REGISTRY_H
@@ -0,0 +1,251 @@
+/*
+ * LogiLinux - Discovery Cache Implementation
+ */
+
+#include "discovery_cache.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// First line of the file; bump the number when the layout changes
+constexpr const char *CACHE_MAGIC = "logilinux-discovery-cache 1";
+
+// Recorded for a directory or node that doesn't exist
+constexpr int64_t MISSING = -1;
+
+constexpr size_t NODE_FIELDS = 12;
+
+// Directory mtimes come from the coarse clock, so two changes within one
+// tick can leave the same mtime. A scan that starts that close to the last
+// change isn't cached, or a node created right after it could go unnoticed.
+constexpr int64_t SETTLE_TIME_NS = 50000000;
+
+static int64_t toNanoseconds(const struct timespec &ts) {
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+static int64_t mtimeOf(const std::string &path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0) {
+    return MISSING;
+  }
+  return toNanoseconds(st.st_mtim);
+}
+
+static bool nodeStamp(const std::string &path, uint64_t &inode,
+                      int64_t &ctime_ns) {
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0) {
+    return false;
+  }
+  inode = st.st_ino;
+  ctime_ns = toNanoseconds(st.st_ctim);
+  return true;
+}
+
+// Fields are tab-separated and records newline-separated; attributes never
+// legitimately contain either
+static std::string sanitize(const std::string &value) {
+  std::string result = value;
+  for (char &c : result) {
+    if (c == '\t' || c == '\n') {
+      c = ' ';
+    }
+  }
+  return result;
+}
+
+static std::vector<std::string> splitFields(const std::string &line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    size_t tab = line.find('\t', start);
+    fields.push_back(line.substr(start, tab - start));
+    if (tab == std::string::npos) {
+      return fields;
+    }
+    start = tab + 1;
+  }
+}
+
+static bool parseInt(const std::string &text, int64_t &value) {
+  if (text.empty()) {
+    return false;
+  }
+  char *end = nullptr;
+  errno = 0;
+  value = std::strtoll(text.c_str(), &end, 10);
+  return errno == 0 && *end == '\0';
+}
+
+static bool makeDirectories(const std::string &path) {
+  for (size_t slash = path.find('/', 1); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    if (mkdir(path.substr(0, slash).c_str(), 0700) < 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+  return mkdir(path.c_str(), 0700) == 0 || errno == EEXIST;
+}
+
+DiscoveryCache::DiscoveryCache(const std::string &path,
+                               const std::string &dev_root)
+    : path_(path), dev_root_(dev_root) {}
+
+std::string DiscoveryCache::defaultPath() {
+  const char *cache_home = getenv("XDG_CACHE_HOME");
+  if (cache_home && cache_home[0] == '/') {
+    return std::string(cache_home) + "/logilinux/devices.cache";
+  }
+
+  const char *home = getenv("HOME");
+  if (home && home[0] == '/') {
+    return std::string(home) + "/.cache/logilinux/devices.cache";
+  }
+
+  return "";
+}
+
+DiscoveryCache::Stamp DiscoveryCache::stamp() const {
+  Stamp stamp;
+  stamp.dev_mtime_ns = mtimeOf(dev_root_);
+  stamp.input_mtime_ns = mtimeOf(dev_root_ + "/input");
+  return stamp;
+}
+
+bool DiscoveryCache::load(std::vector<DeviceInfo> &infos) const {
+  std::ifstream file(path_);
+  if (!file) {
+    return false;
+  }
+
+  std::string line;
+  if (!std::getline(file, line) || line != CACHE_MAGIC) {
+    return false;
+  }
+
+  // Checked first: it is the cheapest way to notice added nodes
+  int64_t dev_mtime_ns;
+  int64_t input_mtime_ns;
+  if (!std::getline(file, line)) {
+    return false;
+  }
+  auto header = splitFields(line);
+  if (header.size() != 3 || header[0] != dev_root_ ||
+      !parseInt(header[1], dev_mtime_ns) ||
+      !parseInt(header[2], input_mtime_ns)) {
+    return false;
+  }
+
+  Stamp current = stamp();
+  if (current.dev_mtime_ns != dev_mtime_ns ||
+      current.input_mtime_ns != input_mtime_ns) {
+    return false;
+  }
+
+  std::vector<DeviceInfo> cached;
+  while (std::getline(file, line)) {
+    auto fields = splitFields(line);
+    int64_t inode;
+    int64_t ctime_ns;
+    int64_t type;
+    int64_t vendor_id;
+    int64_t product_id;
+    if (fields.size() != NODE_FIELDS || !parseInt(fields[0], inode) ||
+        !parseInt(fields[1], ctime_ns) || !parseInt(fields[2], type) ||
+        !parseInt(fields[3], vendor_id) || !parseInt(fields[4], product_id)) {
+      return false;
+    }
+
+    DeviceInfo info;
+    info.type = static_cast<DeviceType>(type);
+    info.vendor_id = static_cast<uint16_t>(vendor_id);
+    info.product_id = static_cast<uint16_t>(product_id);
+    info.device_path = fields[5];
+    info.hidraw_path = fields[6];
+    info.identity = fields[7];
+    info.serial = fields[8];
+    info.phys = fields[9];
+    info.sysfs_path = fields[10];
+    info.name = fields[11];
+
+    // A recreated node gets a new inode or at least a new ctime
+    uint64_t current_inode;
+    int64_t current_ctime_ns;
+    if (!nodeStamp(info.device_path, current_inode, current_ctime_ns) ||
+        current_inode != static_cast<uint64_t>(inode) ||
+        current_ctime_ns != ctime_ns) {
+      return false;
+    }
+
+    cached.push_back(std::move(info));
+  }
+
+  infos = std::move(cached);
+  return true;
+}
+
+bool DiscoveryCache::store(const Stamp &stamp,
+                           const std::vector<DeviceInfo> &infos) const {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  int64_t now_ns = toNanoseconds(now);
+  if (now_ns - stamp.dev_mtime_ns < SETTLE_TIME_NS ||
+      now_ns - stamp.input_mtime_ns < SETTLE_TIME_NS) {
+    return false;
+  }
+
+  size_t slash = path_.find_last_of('/');
+  if (slash == std::string::npos || slash == 0 ||
+      !makeDirectories(path_.substr(0, slash))) {
+    return false;
+  }
+
+  std::ostringstream contents;
+  contents << CACHE_MAGIC << '\n'
+           << dev_root_ << '\t' << stamp.dev_mtime_ns << '\t'
+           << stamp.input_mtime_ns << '\n';
+
+  for (const auto &info : infos) {
+    uint64_t inode;
+    int64_t ctime_ns;
+    if (!nodeStamp(info.device_path, inode, ctime_ns)) {
+      return false; // Already gone; the next start rescans anyway
+    }
+
+    contents << inode << '\t' << ctime_ns << '\t'
+             << static_cast<int>(info.type) << '\t' << info.vendor_id << '\t'
+             << info.product_id << '\t' << sanitize(info.device_path) << '\t'
+             << sanitize(info.hidraw_path) << '\t' << sanitize(info.identity)
+             << '\t' << sanitize(info.serial) << '\t' << sanitize(info.phys)
+             << '\t' << sanitize(info.sysfs_path) << '\t'
+             << sanitize(info.name) << '\n';
+  }
+
+  // Write a private file and rename it over the old one, so concurrent
+  // tools never read a half-written cache
+  std::string temp_path = path_ + "." + std::to_string(getpid());
+  {
+    std::ofstream file(temp_path, std::ios::trunc);
+    file << contents.str();
+    if (!file.flush()) {
+      unlink(temp_path.c_str());
+      return false;
+    }
+  }
+
+  if (rename(temp_path.c_str(), path_.c_str()) < 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,63 @@
+/*
+ * LogiLinux - Discovery Cache
+ * On-disk copy of the last scan, validated against the device nodes
+ */
+
+#ifndef LOGILINUX_DISCOVERY_CACHE_H
+#define LOGILINUX_DISCOVERY_CACHE_H
+
+#include "logilinux/device.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LogiLinux {
+
+/**
+ * A cached scan is valid while the dev_root and dev_root/input directories
+ * keep their mtime (no node was created or removed there) and every cached
+ * node keeps its inode and ctime (none was recreated). Checking that takes
+ * a few stat() calls instead of reading sysfs for every input device.
+ */
+class DiscoveryCache {
+public:
+  /**
+   * Directory mtimes taken before a scan, so a node appearing while the
+   * scan runs invalidates the stored result
+   */
+  struct Stamp {
+    int64_t dev_mtime_ns;
+    int64_t input_mtime_ns;
+  };
+
+  DiscoveryCache(const std::string &path, const std::string &dev_root);
+
+  /**
+   * $XDG_CACHE_HOME/logilinux/devices.cache, falling back to ~/.cache, or
+   * an empty string if neither is set
+   */
+  static std::string defaultPath();
+
+  const std::string &path() const { return path_; }
+
+  Stamp stamp() const;
+
+  /**
+   * Read the cached scan. Returns false if there is none or it no longer
+   * matches the device nodes.
+   */
+  bool load(std::vector<DeviceInfo> &infos) const;
+
+  /**
+   * Replace the cache with the result of a scan started at stamp
+   */
+  bool store(const Stamp &stamp, const std::vector<DeviceInfo> &infos) const;
+
+private:
+  std::string path_;
+  std::string dev_root_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_DISCOVERY_CACHE_H
@@ -0,0 +1,145 @@
+/*
+ * LogiLinux - Event Dispatcher Implementation
+ */
+
+#include "event_dispatcher.h"
+
+namespace LogiLinux {
+
+EventDispatcher::EventDispatcher() : has_sink_(false), device_handle_(0) {}
+
+void EventDispatcher::setEventCallback(EventCallback callback) {
+  event_callback_ = callback;
+}
+
+void EventDispatcher::setFrameCallback(FrameCallback callback) {
+  frame_callback_ = callback;
+  frame_.clear();
+}
+
+void EventDispatcher::setRecordCallback(EventRecordCallback callback) {
+  record_callback_ = callback;
+}
+
+void EventDispatcher::setStreamSink(DeviceHandle handle,
+                                    EventRecordCallback sink) {
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+  stream_sink_ = sink;
+  has_sink_.store(static_cast<bool>(sink), std::memory_order_release);
+  device_handle_.store(sink ? handle : 0, std::memory_order_relaxed);
+}
+
+bool EventDispatcher::enableQueue(size_t capacity, OverflowPolicy policy) {
+  ring_ = std::make_unique<EventRing>(capacity, policy);
+  return ring_->eventFd() >= 0;
+}
+
+size_t EventDispatcher::pollQueue(EventRecord *events, size_t max_events) {
+  return ring_ ? ring_->pop(events, max_events) : 0;
+}
+
+int EventDispatcher::queueFd() const { return ring_ ? ring_->eventFd() : -1; }
+
+EventQueueStats EventDispatcher::queueStats() const {
+  return ring_ ? ring_->stats() : EventQueueStats{};
+}
+
+void EventDispatcher::interruptQueue() {
+  if (ring_) {
+    ring_->interrupt();
+  }
+}
+
+void EventDispatcher::resumeQueue() {
+  if (ring_) {
+    ring_->resume();
+  }
+}
+
+bool EventDispatcher::enableRemapping(const RemapConfig &config) {
+  auto remapper = std::make_unique<UinputRemapper>(config);
+  if (!remapper->open()) {
+    return false;
+  }
+  remapper_ = std::move(remapper);
+  return true;
+}
+
+void EventDispatcher::enableRemapping(
+    std::unique_ptr<UinputRemapper> remapper) {
+  remapper_ = std::move(remapper);
+}
+
+void EventDispatcher::disableRemapping() { remapper_.reset(); }
+
+RemapStats EventDispatcher::remapStats() const {
+  return remapper_ ? remapper_->stats() : RemapStats{};
+}
+
+LatencyHistogram EventDispatcher::latencyHistogram() const {
+  return latency_.snapshot();
+}
+
+void EventDispatcher::resetLatencyHistogram() { latency_.reset(); }
+
+DeviceState EventDispatcher::state() const { return state_.snapshot(); }
+
+void EventDispatcher::dispatch(const EventRecord &decoded) {
+  latency_.record(decoded.timestamp);
+  state_.record(decoded);
+
+  EventRecord record = decoded;
+  record.device = device_handle_.load(std::memory_order_relaxed);
+
+  if (remapper_) {
+    remapper_->process(record);
+    held_.push_back(record);
+    return;
+  }
+
+  deliver(record);
+}
+
+void EventDispatcher::deliver(const EventRecord &record) {
+  if (has_sink_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    if (stream_sink_) {
+      stream_sink_(record);
+    }
+  }
+
+  if (ring_) {
+    ring_->push(record);
+  }
+
+  if (record_callback_) {
+    record_callback_(record);
+  }
+
+  if (frame_callback_) {
+    frame_.push_back(makeEventPtr(record));
+  } else if (event_callback_) {
+    event_callback_(makeEventPtr(record));
+  }
+}
+
+void EventDispatcher::endFrame() {
+  state_.commit();
+
+  // Before the frame's records reach any consumer, so slow handlers don't
+  // delay the output
+  if (remapper_) {
+    remapper_->endFrame();
+  }
+  for (const EventRecord &record : held_) {
+    deliver(record);
+  }
+  held_.clear(); // Keeps capacity for the next frame
+
+  if (frame_callback_ && !frame_.empty()) {
+    frame_callback_(frame_);
+    frame_.clear(); // Keeps capacity for the next frame
+  }
+}
+
+} // namespace LogiLinux
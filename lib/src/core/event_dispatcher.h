@@ -0,0 +1,111 @@
+/*
+ * LogiLinux - Event Dispatcher
+ * Fans decoded events out to the callbacks registered on a device
+ */
+
+#ifndef LOGILINUX_EVENT_DISPATCHER_H
+#define LOGILINUX_EVENT_DISPATCHER_H
+
+#include "event_ring.h"
+#include "latency_recorder.h"
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include "state_recorder.h"
+#include "uinput_remapper.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace LogiLinux {
+
+class EventDispatcher {
+public:
+  EventDispatcher();
+
+  void setEventCallback(EventCallback callback);
+  void setFrameCallback(FrameCallback callback);
+  void setRecordCallback(EventRecordCallback callback);
+
+  /**
+   * Stamp events with handle and pass them to sink as well
+   * (Device::setEventStreamSink()). May be called from any thread while
+   * events are dispatched; waits for a call into the old sink to return.
+   */
+  void setStreamSink(DeviceHandle handle, EventRecordCallback sink);
+
+  /**
+   * Route events into a lock-free queue drained by pollQueue()
+   */
+  bool enableQueue(size_t capacity, OverflowPolicy policy);
+  size_t pollQueue(EventRecord *events, size_t max_events);
+  int queueFd() const;
+  EventQueueStats queueStats() const;
+
+  /**
+   * Release a producer blocked on a full queue, so monitoring can stop
+   * even if the application stopped draining
+   */
+  void interruptQueue();
+  void resumeQueue();
+
+  /**
+   * Also re-emit events through a uinput virtual device
+   * (Device::enableRemapping())
+   */
+  bool enableRemapping(const RemapConfig &config);
+  void enableRemapping(std::unique_ptr<UinputRemapper> remapper);
+  void disableRemapping();
+  RemapStats remapStats() const;
+
+  /**
+   * Time from the kernel stamping an event to dispatch() receiving it
+   */
+  LatencyHistogram latencyHistogram() const;
+  void resetLatencyHistogram();
+
+  /**
+   * State as of the last completed frame (Device::getState())
+   */
+  DeviceState state() const;
+
+  /**
+   * Deliver one decoded event. Its latency is recorded before any consumer
+   * runs, so slow callbacks show up in later events rather than this one.
+   * Record consumers are called immediately, unless remapping: then the
+   * frame's records are held until endFrame() has written the output, so
+   * slow consumers never delay it. Event objects are only allocated if a
+   * legacy callback is registered.
+   */
+  void dispatch(const EventRecord &record);
+
+  /**
+   * Mark the end of a hardware frame (SYN_REPORT or HID report). This is
+   * also when the device state is published.
+   */
+  void endFrame();
+
+private:
+  void deliver(const EventRecord &record);
+
+  EventCallback event_callback_;
+  FrameCallback frame_callback_;
+  EventRecordCallback record_callback_;
+  // Swapped while the device may be monitoring, hence the lock. Dispatch
+  // only takes it while a sink is attached.
+  std::mutex sink_mutex_;
+  EventRecordCallback stream_sink_;
+  std::atomic<bool> has_sink_;
+  std::atomic<DeviceHandle> device_handle_;
+  std::unique_ptr<EventRing> ring_;
+  std::unique_ptr<UinputRemapper> remapper_;
+  LatencyRecorder latency_;
+  StateRecorder state_;
+
+  EventFrame frame_;
+  std::vector<EventRecord> held_; // This frame's records, while remapping
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_EVENT_DISPATCHER_H
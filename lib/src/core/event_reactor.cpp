@@ -0,0 +1,149 @@
+/*
+ * LogiLinux - Event Reactor Implementation
+ */
+
+#include "event_reactor.h"
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// Tag used in epoll_event.data for the shutdown eventfd; source ids start at 1
+constexpr uint64_t WAKE_ID = 0;
+
+constexpr int MAX_EPOLL_EVENTS = 32;
+
+EventReactor &EventReactor::instance() {
+  static EventReactor reactor;
+  return reactor;
+}
+
+EventReactor::EventReactor()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), next_id_(1),
+      dispatching_id_(0), thread_id_(std::thread::id()),
+      should_stop_(false) {
+  if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_ID;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+  }
+}
+
+EventReactor::~EventReactor() {
+  should_stop_ = true;
+
+  if (thread_.joinable()) {
+    uint64_t one = 1;
+    ssize_t ret = write(wake_fd_, &one, sizeof(one));
+    (void)ret;
+    thread_.join();
+  }
+
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+uint64_t EventReactor::addSource(int fd, Handler handler) {
+  if (epoll_fd_ < 0 || wake_fd_ < 0 || fd < 0) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint64_t id = next_id_++;
+
+  struct epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    return 0;
+  }
+
+  sources_[id] = std::make_shared<Source>(Source{fd, std::move(handler)});
+
+  // The thread is started lazily so processes that never monitor a device
+  // don't carry an extra thread around
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&EventReactor::run, this);
+  }
+
+  return id;
+}
+
+void EventReactor::removeSource(uint64_t id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  auto it = sources_.find(id);
+  if (it == sources_.end()) {
+    return;
+  }
+
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second->fd, nullptr);
+  sources_.erase(it);
+
+  // A handler removing its own source must not wait for itself
+  if (!isReactorThread()) {
+    dispatch_done_.wait(lock, [this, id] { return dispatching_id_ != id; });
+  }
+}
+
+bool EventReactor::isReactorThread() const {
+  return std::this_thread::get_id() ==
+         thread_id_.load(std::memory_order_acquire);
+}
+
+void EventReactor::run() {
+  thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+  struct epoll_event events[MAX_EPOLL_EVENTS];
+
+  while (!should_stop_) {
+    // No timeout: the thread sleeps until a device has data or we shut down
+    int count = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, -1);
+
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    for (int i = 0; i < count && !should_stop_; i++) {
+      uint64_t id = events[i].data.u64;
+      if (id == WAKE_ID) {
+        uint64_t value;
+        ssize_t ret = read(wake_fd_, &value, sizeof(value));
+        (void)ret;
+        continue;
+      }
+
+      std::shared_ptr<Source> source;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(id);
+        if (it == sources_.end()) {
+          continue; // Removed after epoll_wait returned
+        }
+        source = it->second;
+        dispatching_id_ = id;
+      }
+
+      source->handler(events[i].events);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dispatching_id_ = 0;
+      }
+      dispatch_done_.notify_all();
+    }
+  }
+}
+
+} // namespace LogiLinux
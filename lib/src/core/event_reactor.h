@@ -0,0 +1,86 @@
+/*
+ * LogiLinux - Event Reactor
+ * Single epoll thread that services every device fd in the library
+ */
+
+#ifndef LOGILINUX_EVENT_REACTOR_H
+#define LOGILINUX_EVENT_REACTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace LogiLinux {
+
+class EventReactor {
+public:
+  /**
+   * Called on the reactor thread with the epoll event mask
+   * (EPOLLIN, EPOLLHUP, EPOLLERR, ...) whenever the fd is ready
+   */
+  using Handler = std::function<void(uint32_t events)>;
+
+  /**
+   * Library-wide reactor shared by all devices
+   */
+  static EventReactor &instance();
+
+  EventReactor(const EventReactor &) = delete;
+  EventReactor &operator=(const EventReactor &) = delete;
+
+  /**
+   * Register a readable fd. The fd is watched level-triggered, so handlers
+   * may leave data unread and will be called again.
+   * Returns a source id, or 0 on failure.
+   */
+  uint64_t addSource(int fd, Handler handler);
+
+  /**
+   * Unregister a source. When called from another thread this blocks until
+   * any in-flight handler for the source has returned, so the caller may
+   * close the fd and release handler state afterwards. Unknown ids are
+   * ignored.
+   */
+  void removeSource(uint64_t id);
+
+  /**
+   * Check if the calling thread is the reactor thread
+   */
+  bool isReactorThread() const;
+
+private:
+  struct Source {
+    int fd;
+    Handler handler;
+  };
+
+  EventReactor();
+  ~EventReactor();
+
+  /**
+   * Main dispatch loop (runs in the reactor thread)
+   */
+  void run();
+
+  int epoll_fd_;
+  int wake_fd_;
+
+  std::mutex mutex_;
+  std::condition_variable dispatch_done_;
+  std::unordered_map<uint64_t, std::shared_ptr<Source>> sources_;
+  uint64_t next_id_;
+  uint64_t dispatching_id_;
+
+  std::thread thread_; // Started lazily, under mutex_
+  std::atomic<std::thread::id> thread_id_; // Set by run(), read anywhere
+  std::atomic<bool> should_stop_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_EVENT_REACTOR_H
@@ -0,0 +1,339 @@
+/*
+ * LogiLinux - Event Ring Implementation
+ */
+
+#include "event_ring.h"
+#include "event_reactor.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// Longest a BLOCK producer on the reactor thread waits for the consumer
+// before it drops the event. Every device shares that thread, so this
+// bounds how long one stalled application can hold up all the others.
+constexpr auto BLOCK_TIMEOUT = std::chrono::milliseconds(50);
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "futex word must be a plain 32-bit atomic");
+
+static uint32_t *futexWord(std::atomic<uint32_t> &word) {
+  return reinterpret_cast<uint32_t *>(&word);
+}
+
+// Sleep until woken, word no longer holds expected, or timeout (if any)
+// passes
+static void futexWait(std::atomic<uint32_t> &word, uint32_t expected,
+                      const std::chrono::nanoseconds *timeout) {
+  struct timespec ts;
+  if (timeout) {
+    ts.tv_sec = static_cast<time_t>(timeout->count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout->count() % 1000000000);
+  }
+  syscall(SYS_futex, futexWord(word), FUTEX_WAIT_PRIVATE, expected,
+          timeout ? &ts : nullptr, nullptr, 0);
+}
+
+static void futexWakeAll(std::atomic<uint32_t> &word) {
+  syscall(SYS_futex, futexWord(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+          nullptr, 0);
+}
+
+static size_t roundUpPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+static int32_t clampToInt32(int64_t value) {
+  if (value > std::numeric_limits<int32_t>::max()) {
+    return std::numeric_limits<int32_t>::max();
+  }
+  if (value < std::numeric_limits<int32_t>::min()) {
+    return std::numeric_limits<int32_t>::min();
+  }
+  return static_cast<int32_t>(value);
+}
+
+EventRing::EventRing(size_t capacity, OverflowPolicy policy,
+                     int shared_event_fd)
+    : capacity_(roundUpPowerOfTwo(capacity < 2 ? 2 : capacity)),
+      mask_(capacity_ - 1), policy_(policy),
+      event_fd_(shared_event_fd >= 0
+                    ? shared_event_fd
+                    : eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      owns_event_fd_(shared_event_fd < 0), head_(0), tail_(0),
+      interrupted_(false), space_seq_(0), producer_waiting_(false),
+      stalled_(false), published_(0), dropped_(0), coalesced_(0),
+      blocked_(0), high_water_(0) {
+  slots_.reset(new Slot[capacity_]);
+  for (size_t i = 0; i < capacity_; i++) {
+    for (auto &word : slots_[i].words) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+EventRing::~EventRing() {
+  if (owns_event_fd_ && event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+void EventRing::store(size_t index, const EventRecord &record) {
+  uint64_t words[SLOT_WORDS];
+  memcpy(words, &record, sizeof(record));
+  for (size_t i = 0; i < SLOT_WORDS; i++) {
+    slots_[index].words[i].store(words[i], std::memory_order_relaxed);
+  }
+}
+
+EventRecord EventRing::load(size_t index) const {
+  uint64_t words[SLOT_WORDS];
+  for (size_t i = 0; i < SLOT_WORDS; i++) {
+    words[i] = slots_[index].words[i].load(std::memory_order_relaxed);
+  }
+  EventRecord record;
+  memcpy(&record, words, sizeof(record));
+  return record;
+}
+
+bool EventRing::push(const EventRecord &record) {
+  if (policy_ == OverflowPolicy::COALESCE_ROTATIONS) {
+    // Anything folded earlier goes out ahead of this event
+    EventRecord pending;
+    if (head_.load() - tail_.load() < capacity_ &&
+        takePending(pending_dial_, RotationType::DIAL, pending)) {
+      pushSlot(pending);
+    }
+    if (head_.load() - tail_.load() < capacity_ &&
+        takePending(pending_wheel_, RotationType::WHEEL, pending)) {
+      pushSlot(pending);
+    }
+
+    if (record.type == EventType::ROTATION &&
+        head_.load() - tail_.load() >= capacity_) {
+      PendingRotation &target =
+          record.rotation.rotation_type == RotationType::WHEEL
+              ? pending_wheel_
+              : pending_dial_;
+      target.timestamp.store(record.timestamp);
+      target.raw_event_code.store(record.rotation.raw_event_code);
+      target.device.store(record.device);
+      target.delta.fetch_add(record.rotation.delta);
+      target.delta_high_res.fetch_add(record.rotation.delta_high_res);
+      coalesced_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  if (policy_ == OverflowPolicy::BLOCK &&
+      head_.load() - tail_.load() >= capacity_ && !waitForSpace()) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  return pushSlot(record);
+}
+
+bool EventRing::waitForSpace() {
+  // Only the shared reactor thread needs the bound; a replay thread is the
+  // device's own and waits as long as it takes, so nothing is lost
+  bool bounded = EventReactor::instance().isReactorThread();
+
+  // A consumer that already let one wait time out isn't draining; don't
+  // hold the reactor up again until it does
+  if (bounded && stalled_.load()) {
+    return false;
+  }
+
+  blocked_.fetch_add(1, std::memory_order_relaxed);
+  auto deadline = std::chrono::steady_clock::now() + BLOCK_TIMEOUT;
+
+  while (!interrupted_.load()) {
+    // Announce the wait before the last look at tail_; pop() moves tail_
+    // before it checks the flag, so one of us sees the other
+    uint32_t seq = space_seq_.load();
+    producer_waiting_.store(true);
+    if (head_.load() - tail_.load() < capacity_) {
+      break;
+    }
+
+    if (!bounded) {
+      futexWait(space_seq_, seq, nullptr);
+      continue;
+    }
+
+    std::chrono::nanoseconds remaining =
+        deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::nanoseconds::zero()) {
+      stalled_.store(true);
+      break;
+    }
+    futexWait(space_seq_, seq, &remaining);
+  }
+
+  producer_waiting_.store(false);
+  return head_.load() - tail_.load() < capacity_;
+}
+
+void EventRing::wakeProducer() {
+  space_seq_.fetch_add(1);
+  futexWakeAll(space_seq_);
+}
+
+bool EventRing::pushSlot(const EventRecord &record) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  uint64_t tail = tail_.load();
+
+  if (head - tail >= capacity_) {
+    // Full: retire the oldest event. If the CAS fails the consumer just
+    // took it, which frees the slot just as well.
+    if (tail_.compare_exchange_strong(tail, tail + 1)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  store(head & mask_, record);
+  head_.store(head + 1);
+  published_.fetch_add(1, std::memory_order_relaxed);
+
+  tail = tail_.load();
+  uint64_t depth = head + 1 - tail;
+  if (depth > high_water_.load(std::memory_order_relaxed)) {
+    high_water_.store(depth, std::memory_order_relaxed);
+  }
+
+  // Only wake the consumer on the empty -> non-empty edge. Both sides use
+  // sequentially consistent head/tail accesses, so either we see the
+  // consumer caught up here or the consumer sees our event in pop().
+  if (tail == head) {
+    signal();
+  }
+
+  return true;
+}
+
+size_t EventRing::pop(EventRecord *events, size_t max_events) {
+  if (owns_event_fd_ && event_fd_ >= 0) {
+    uint64_t value;
+    ssize_t ret = read(event_fd_, &value, sizeof(value));
+    (void)ret;
+  }
+
+  size_t count = 0;
+  while (count < max_events) {
+    uint64_t tail = tail_.load();
+    if (tail == head_.load()) {
+      break;
+    }
+
+    EventRecord record = load(tail & mask_);
+
+    // Fails if the producer dropped this slot while we were copying it
+    if (tail_.compare_exchange_strong(tail, tail + 1)) {
+      events[count++] = record;
+    }
+  }
+
+  if (policy_ == OverflowPolicy::COALESCE_ROTATIONS) {
+    if (count < max_events &&
+        takePending(pending_dial_, RotationType::DIAL, events[count])) {
+      count++;
+    }
+    if (count < max_events &&
+        takePending(pending_wheel_, RotationType::WHEEL, events[count])) {
+      count++;
+    }
+  }
+
+  // Keep the eventfd readable if we left events behind
+  if (owns_event_fd_ && head_.load() != tail_.load()) {
+    signal();
+  }
+
+  if (count > 0 && policy_ == OverflowPolicy::BLOCK) {
+    stalled_.store(false);
+    if (producer_waiting_.load()) {
+      wakeProducer();
+    }
+  }
+
+  return count;
+}
+
+bool EventRing::takePending(PendingRotation &pending, RotationType type,
+                            EventRecord &record) {
+  int64_t delta_high_res = pending.delta_high_res.exchange(0);
+  int64_t delta = pending.delta.exchange(0);
+  if (delta == 0 && delta_high_res == 0) {
+    return false;
+  }
+
+  // Producer and consumer may both flush; the exchanges make sure every
+  // folded delta is reported exactly once
+  record = {};
+  record.type = EventType::ROTATION;
+  record.device = pending.device.load();
+  record.timestamp = pending.timestamp.load();
+  record.rotation.rotation_type = type;
+  record.rotation.delta = clampToInt32(delta);
+  record.rotation.delta_high_res = clampToInt32(delta_high_res);
+  record.rotation.raw_event_code = pending.raw_event_code.load();
+  return true;
+}
+
+void EventRing::signal() {
+  if (event_fd_ >= 0) {
+    uint64_t one = 1;
+    ssize_t ret = write(event_fd_, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+bool EventRing::empty() const {
+  return head_.load() == tail_.load() &&
+         pending_dial_.delta_high_res.load() == 0 &&
+         pending_dial_.delta.load() == 0 &&
+         pending_wheel_.delta_high_res.load() == 0 &&
+         pending_wheel_.delta.load() == 0;
+}
+
+void EventRing::interrupt() {
+  interrupted_ = true;
+  wakeProducer();
+}
+
+void EventRing::resume() {
+  interrupted_ = false;
+  stalled_ = false;
+}
+
+EventQueueStats EventRing::stats() const {
+  // Tail first: head can only move ahead of it, never behind
+  uint64_t tail = tail_.load();
+  uint64_t head = head_.load();
+
+  EventQueueStats stats;
+  stats.capacity = capacity_;
+  stats.depth = static_cast<size_t>(head - tail);
+  stats.high_water = static_cast<size_t>(high_water_.load());
+  stats.published = published_.load();
+  stats.dropped = dropped_.load();
+  stats.coalesced = coalesced_.load();
+  stats.blocked = blocked_.load();
+  return stats;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,125 @@
+/*
+ * LogiLinux - Event Ring
+ * Bounded lock-free single-producer/single-consumer event queue
+ */
+
+#ifndef LOGILINUX_EVENT_RING_H
+#define LOGILINUX_EVENT_RING_H
+
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace LogiLinux {
+
+class EventRing {
+public:
+  /**
+   * Capacity is rounded up to a power of two. With a shared_event_fd the
+   * ring signals that eventfd instead of creating its own, and pop()
+   * leaves it alone: the owner of the fd clears it before draining and
+   * re-arms it if it stops early.
+   */
+  EventRing(size_t capacity, OverflowPolicy policy, int shared_event_fd = -1);
+  ~EventRing();
+
+  EventRing(const EventRing &) = delete;
+  EventRing &operator=(const EventRing &) = delete;
+
+  /**
+   * Publish an event (producer side). Returns false if the event was
+   * dropped or folded into a coalesced rotation.
+   */
+  bool push(const EventRecord &record);
+
+  /**
+   * Drain up to max_events events (consumer side)
+   */
+  size_t pop(EventRecord *events, size_t max_events);
+
+  /**
+   * eventfd that becomes readable when the ring goes from empty to
+   * non-empty
+   */
+  int eventFd() const { return event_fd_; }
+
+  /**
+   * Make a producer blocked by OverflowPolicy::BLOCK give up (and keep
+   * giving up) until resume() is called. Used while stopping a monitor.
+   * Without it a BLOCK producer on the reactor thread still gives up after
+   * a bounded wait, and drops events without waiting until the consumer
+   * drains again.
+   */
+  void interrupt();
+  void resume();
+
+  EventQueueStats stats() const;
+
+  /**
+   * Nothing queued (consumer side; rotations being coalesced count)
+   */
+  bool empty() const;
+
+private:
+  // Slots are stored as atomic words so a producer overwriting the oldest
+  // slot can never race with a consumer copying it out
+  static constexpr size_t SLOT_WORDS = sizeof(EventRecord) / sizeof(uint64_t);
+  struct Slot {
+    std::atomic<uint64_t> words[SLOT_WORDS];
+  };
+
+  struct PendingRotation {
+    std::atomic<int64_t> delta{0};
+    std::atomic<int64_t> delta_high_res{0};
+    std::atomic<uint64_t> timestamp{0};
+    std::atomic<uint16_t> raw_event_code{0};
+    std::atomic<uint16_t> device{0};
+  };
+
+  void store(size_t index, const EventRecord &record);
+  EventRecord load(size_t index) const;
+
+  bool pushSlot(const EventRecord &record);
+  bool waitForSpace();
+  void wakeProducer();
+  bool takePending(PendingRotation &pending, RotationType type,
+                   EventRecord &record);
+  void signal();
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_;
+  size_t mask_;
+  OverflowPolicy policy_;
+  int event_fd_;
+  bool owns_event_fd_;
+
+  alignas(64) std::atomic<uint64_t> head_; // Next slot to write
+  alignas(64) std::atomic<uint64_t> tail_; // Next slot to read
+
+  // Rotations folded together while the ring was full
+  // (OverflowPolicy::COALESCE_ROTATIONS)
+  PendingRotation pending_dial_;
+  PendingRotation pending_wheel_;
+
+  std::atomic<bool> interrupted_;
+
+  // OverflowPolicy::BLOCK: the producer sleeps on space_seq_ (a futex)
+  // and pop() bumps it when producer_waiting_ is set. stalled_ is set when
+  // a wait times out and cleared once the consumer takes something.
+  std::atomic<uint32_t> space_seq_;
+  std::atomic<bool> producer_waiting_;
+  std::atomic<bool> stalled_;
+
+  std::atomic<uint64_t> published_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> coalesced_;
+  std::atomic<uint64_t> blocked_;
+  std::atomic<uint64_t> high_water_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_EVENT_RING_H
@@ -0,0 +1,200 @@
+/*
+ * LogiLinux - Event Stream Implementation
+ */
+
+#include "event_stream.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+EventStream::EventStream()
+    : event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), last_handle_(0) {}
+
+EventStream::~EventStream() {
+  // Detach first: the sinks point into the rings. Devices may still be
+  // monitoring, so release a producer blocked on a full ring; detaching
+  // then waits for any push in progress.
+  for (const auto &source : sources_) {
+    source->ring->interrupt();
+    source->device->setEventStreamSink(0, nullptr);
+  }
+  sources_.clear();
+
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+DeviceHandle EventStream::add(const DevicePtr &device, size_t capacity,
+                              OverflowPolicy policy) {
+  if (!device || event_fd_ < 0) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (const auto &source : sources_) {
+    if (source->device == device) {
+      return source->handle;
+    }
+  }
+
+  DeviceHandle handle = nextHandle();
+  if (handle == 0) {
+    return 0; // Every handle is taken
+  }
+
+  auto source = std::make_unique<Source>();
+  source->handle = handle;
+  source->device = device;
+  source->ring = std::make_unique<EventRing>(capacity, policy, event_fd_);
+  source->batch_pos = 0;
+  source->batch_count = 0;
+
+  EventRing *ring = source->ring.get();
+  device->setEventStreamSink(
+      handle, [ring](const EventRecord &record) { ring->push(record); });
+
+  sources_.push_back(std::move(source));
+  last_handle_ = handle;
+  return handle;
+}
+
+bool EventStream::remove(const DevicePtr &device) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (auto it = sources_.begin(); it != sources_.end(); ++it) {
+    if ((*it)->device == device) {
+      (*it)->ring->interrupt();
+      device->setEventStreamSink(0, nullptr);
+      sources_.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+DevicePtr EventStream::device(DeviceHandle handle) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (const auto &source : sources_) {
+    if (source->handle == handle) {
+      return source->device;
+    }
+  }
+  return nullptr;
+}
+
+DeviceHandle EventStream::nextHandle() const {
+  // Handles are handed out in order and reused only after wrapping, so a
+  // stale handle from a removed device rarely names a new one
+  DeviceHandle handle = last_handle_;
+  for (size_t attempt = 0; attempt < 0xffff; attempt++) {
+    handle = handle == 0xffff ? 1 : handle + 1;
+
+    bool taken = false;
+    for (const auto &source : sources_) {
+      if (source->handle == handle) {
+        taken = true;
+        break;
+      }
+    }
+    if (!taken) {
+      return handle;
+    }
+  }
+  return 0;
+}
+
+bool EventStream::refill(Source &source) {
+  if (source.batch_pos < source.batch_count) {
+    return true;
+  }
+
+  source.batch_pos = 0;
+  source.batch_count = source.ring->pop(source.batch, BATCH_SIZE);
+  return source.batch_count > 0;
+}
+
+size_t EventStream::poll(EventRecord *events, size_t max_events) {
+  if (event_fd_ < 0) {
+    return 0;
+  }
+
+  // Clear the eventfd before looking at the rings: a producer that pushes
+  // after we looked will find its ring empty and signal again
+  uint64_t value;
+  ssize_t ret = read(event_fd_, &value, sizeof(value));
+  (void)ret;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // k-way merge on the oldest pending event of each device. Each ring is
+  // already in timestamp order, and with a handful of devices a linear
+  // scan beats a heap. Only what is queued now is merged: holding events
+  // back for devices that might still push an older one would delay all
+  // input, so cross-device order is best-effort.
+  size_t count = 0;
+  while (count < max_events) {
+    Source *oldest = nullptr;
+    for (const auto &source : sources_) {
+      if (refill(*source) &&
+          (!oldest || source->batch[source->batch_pos].timestamp <
+                          oldest->batch[oldest->batch_pos].timestamp)) {
+        oldest = source.get();
+      }
+    }
+
+    if (!oldest) {
+      break;
+    }
+    events[count++] = oldest->batch[oldest->batch_pos++];
+  }
+
+  // Stopped early: keep the eventfd readable for the rest
+  if (count == max_events) {
+    for (const auto &source : sources_) {
+      if (source->batch_pos < source->batch_count || !source->ring->empty()) {
+        uint64_t one = 1;
+        ret = write(event_fd_, &one, sizeof(one));
+        (void)ret;
+        break;
+      }
+    }
+  }
+
+  return count;
+}
+
+size_t EventStream::dispatch(const EventRecordCallback &callback,
+                             int timeout_ms) {
+  if (event_fd_ < 0 || !callback) {
+    return 0;
+  }
+
+  struct pollfd pfd = {};
+  pfd.fd = event_fd_;
+  pfd.events = POLLIN;
+  int ready = ::poll(&pfd, 1, timeout_ms);
+  if (ready <= 0) {
+    return 0;
+  }
+
+  // Delivered outside the lock so the callback may add or remove devices
+  EventRecord events[BATCH_SIZE];
+  size_t total = 0;
+  size_t count;
+  do {
+    count = poll(events, BATCH_SIZE);
+    for (size_t i = 0; i < count; i++) {
+      callback(events[i]);
+    }
+    total += count;
+  } while (count == BATCH_SIZE);
+
+  return total;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,94 @@
+/*
+ * LogiLinux - Event Stream
+ * Events from several devices merged into one queue, in timestamp order as
+ * far as they have been queued
+ */
+
+#ifndef LOGILINUX_EVENT_STREAM_H
+#define LOGILINUX_EVENT_STREAM_H
+
+#include "event_ring.h"
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace LogiLinux {
+
+class EventStream {
+public:
+  EventStream();
+  ~EventStream();
+
+  EventStream(const EventStream &) = delete;
+  EventStream &operator=(const EventStream &) = delete;
+
+  /**
+   * Start merging a device's events. Each device gets its own ring (it is
+   * the only producer for it), all sharing the stream's eventfd. Returns
+   * the device's handle, the existing one if it was already added, or 0 on
+   * failure.
+   */
+  DeviceHandle add(const DevicePtr &device, size_t capacity,
+                   OverflowPolicy policy);
+
+  /**
+   * Stop merging a device's events; anything still queued for it is
+   * discarded
+   */
+  bool remove(const DevicePtr &device);
+
+  /**
+   * Device for a handle, or nullptr
+   */
+  DevicePtr device(DeviceHandle handle) const;
+
+  /**
+   * Drain up to max_events events from all devices, oldest timestamp
+   * first among those already queued. Each device's own events keep their
+   * order; across devices the merge is best-effort, since an older event
+   * a producer is still pushing comes out after newer ones drained before
+   * it arrived. Call from one thread only.
+   */
+  size_t poll(EventRecord *events, size_t max_events);
+
+  /**
+   * Wait up to timeout_ms (-1: forever) for events, then call callback for
+   * each queued event, merged as poll() does. Returns the number delivered.
+   */
+  size_t dispatch(const EventRecordCallback &callback, int timeout_ms);
+
+  int eventFd() const { return event_fd_; }
+
+private:
+  // Events popped from a ring but not delivered yet
+  static constexpr size_t BATCH_SIZE = 64;
+
+  struct Source {
+    DeviceHandle handle;
+    DevicePtr device;
+    std::unique_ptr<EventRing> ring;
+    EventRecord batch[BATCH_SIZE];
+    size_t batch_pos;
+    size_t batch_count;
+  };
+
+  /**
+   * Make sure the source's next event is in its batch; false if it has
+   * none
+   */
+  static bool refill(Source &source);
+
+  DeviceHandle nextHandle() const;
+
+  int event_fd_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Source>> sources_;
+  DeviceHandle last_handle_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_EVENT_STREAM_H
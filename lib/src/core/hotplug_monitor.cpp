@@ -0,0 +1,65 @@
+/*
+ * LogiLinux - Hotplug Monitor Implementation
+ */
+
+#include "hotplug_monitor.h"
+#include "event_reactor.h"
+
+namespace LogiLinux {
+
+// Only evdev and hidraw nodes can be a supported device. Other input
+// handlers (mouseN for the dial, jsN) sit on the same input device and
+// would pass its id check, so they are filtered here like inotify does.
+static bool isDeviceNodeEvent(const UeventMessage &message) {
+  if (message.action != "add" && message.action != "remove") {
+    return false;
+  }
+  if (message.subsystem == "input") {
+    return message.devname.compare(0, 11, "input/event") == 0;
+  }
+  if (message.subsystem == "hidraw") {
+    return message.devname.compare(0, 6, "hidraw") == 0;
+  }
+  return false;
+}
+
+HotplugMonitor::HotplugMonitor(std::unique_ptr<UeventSource> source)
+    : source_(std::move(source)), source_id_(0) {}
+
+HotplugMonitor::~HotplugMonitor() { stop(); }
+
+bool HotplugMonitor::start(Callback callback) {
+  if (!source_ || source_id_ != 0) {
+    return false;
+  }
+
+  callback_ = std::move(callback);
+  source_id_ = EventReactor::instance().addSource(
+      source_->fd(), [this](uint32_t) { onReadable(); });
+  return source_id_ != 0;
+}
+
+void HotplugMonitor::stop() {
+  uint64_t source_id = source_id_.exchange(0);
+  if (source_id != 0) {
+    EventReactor::instance().removeSource(source_id);
+  }
+}
+
+void HotplugMonitor::onReadable() {
+  messages_.clear();
+  bool healthy = source_->read(messages_);
+
+  for (const auto &message : messages_) {
+    if (isDeviceNodeEvent(message) && callback_) {
+      callback_(message);
+    }
+  }
+
+  if (!healthy) {
+    // Nothing more will come; removing our own source doesn't block
+    stop();
+  }
+}
+
+} // namespace LogiLinux
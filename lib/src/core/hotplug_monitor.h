@@ -0,0 +1,49 @@
+/*
+ * LogiLinux - Hotplug Monitor
+ * Delivers device node add/remove uevents on the reactor thread
+ */
+
+#ifndef LOGILINUX_HOTPLUG_MONITOR_H
+#define LOGILINUX_HOTPLUG_MONITOR_H
+
+#include "uevent_source.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace LogiLinux {
+
+class HotplugMonitor {
+public:
+  /**
+   * Called on the reactor thread for each "add" or "remove" of an input or
+   * hidraw device node
+   */
+  using Callback = std::function<void(const UeventMessage &message)>;
+
+  explicit HotplugMonitor(std::unique_ptr<UeventSource> source);
+  ~HotplugMonitor();
+
+  HotplugMonitor(const HotplugMonitor &) = delete;
+  HotplugMonitor &operator=(const HotplugMonitor &) = delete;
+
+  bool start(Callback callback);
+  void stop();
+  bool isRunning() const { return source_id_ != 0; }
+
+private:
+  void onReadable();
+
+  std::unique_ptr<UeventSource> source_;
+  Callback callback_;
+  std::atomic<uint64_t> source_id_;
+
+  // Reused between reads
+  std::vector<UeventMessage> messages_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_HOTPLUG_MONITOR_H
@@ -3,41 +3,173 @@
  */
 
 #include "input_monitor.h"
+#include "event_reactor.h"
+#include "rotation_frame.h"
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <linux/input.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 namespace LogiLinux {
 
-InputMonitor::InputMonitor(const std::string &device_path)
-    : device_path_(device_path), running_(false), should_stop_(false),
-      device_fd_(-1) {}
+// Events pulled from the kernel per read() call. A single dial detent is
+// already three events (REL_HWHEEL, REL_HWHEEL_HI_RES, SYN_REPORT).
+constexpr size_t READ_BATCH_SIZE = 64;
+
+// Upper bound on reads per wakeup so a busy device can't starve the other
+// devices sharing the reactor thread. Leftover data wakes us again.
+constexpr int MAX_READS_PER_WAKEUP = 16;
+
+// Relative axes decodeRotation() understands; everything else is masked
+// out in the kernel
+static bool isRotationCode(uint16_t code) {
+  return code == REL_HWHEEL || code == REL_DIAL || code == REL_WHEEL ||
+         code == REL_MISC || code == 0x0b || code == 0x0c;
+}
+
+// Bitmaps in the layout used by EVIOCGKEY and EVIOCSMASK
+static void setBit(uint8_t *bits, uint16_t code, bool value) {
+  if (value) {
+    bits[code / 8] |= static_cast<uint8_t>(1u << (code % 8));
+  } else {
+    bits[code / 8] &= static_cast<uint8_t>(~(1u << (code % 8)));
+  }
+}
+
+// start() switches the fd to CLOCK_MONOTONIC, so this is directly
+// comparable with getMonotonicTimestamp()
+static uint64_t eventTimestamp(const struct input_event &ev) {
+  return static_cast<uint64_t>(ev.time.tv_sec) * 1000000000ull +
+         static_cast<uint64_t>(ev.time.tv_usec) * 1000;
+}
+
+InputMonitor::InputMonitor(const std::string &device_path,
+                           EventDispatcher &dispatcher, CaptureWriter *capture)
+    : device_path_(device_path), dispatcher_(dispatcher), capture_(capture),
+      running_(false), source_id_(0), device_fd_(-1), frame_record_count_(0),
+      syncing_(false), key_state_(), frame_axes_(), pending_(), timer_fd_(-1),
+      timer_source_id_(0) {}
 
 InputMonitor::~InputMonitor() { stop(); }
 
-bool InputMonitor::start(EventCallback callback) {
+bool InputMonitor::setRotationCoalescing(const RotationCoalescing &options) {
+  if (running_) {
+    return false;
+  }
+
+  coalescing_ = options;
+  if (coalescing_.window_us > 0) {
+    coalescing_.merge_axes = true;
+  }
+
+  return true;
+}
+
+bool InputMonitor::start() {
   if (running_) {
     return false;
   }
 
-  callback_ = callback;
+  // Release an fd left behind by a device that disappeared while monitored
+  stop();
 
   device_fd_ = open(device_path_.c_str(), O_RDONLY | O_NONBLOCK);
   if (device_fd_ < 0) {
     return false;
   }
 
-  should_stop_ = false;
+  // evdev stamps events with CLOCK_REALTIME by default, which jumps with
+  // NTP and can't be compared against the time a callback runs
+  int clock_id = CLOCK_MONOTONIC;
+  if (ioctl(device_fd_, EVIOCSCLOCKID, &clock_id) < 0) {
+    std::cerr << "Failed to select monotonic clock for " << device_path_
+              << ": " << strerror(errno) << std::endl;
+  }
+
+  installEventMask();
+
+  // Keys already held when we start are part of the baseline, so their
+  // release is reported but no press is invented
+  memset(key_state_, 0, sizeof(key_state_));
+  ioctl(device_fd_, EVIOCGKEY(sizeof(key_state_)), key_state_);
+  frame_record_count_ = 0;
+  syncing_ = false;
+
+  for (auto &axis : frame_axes_) {
+    axis = AxisFrame();
+  }
+  for (auto &pending : pending_) {
+    pending = PendingRotation();
+  }
+
+  // The window timer is only armed while a rotation is held back, so it
+  // causes no wakeups when the dial is idle
+  if (coalescing_.window_us > 0) {
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ >= 0) {
+      timer_source_id_ = EventReactor::instance().addSource(
+          timer_fd_, [this](uint32_t) { onTimer(); });
+    }
+    if (timer_source_id_ == 0) {
+      stop();
+      return false;
+    }
+  }
+
   running_ = true;
-  monitor_thread_ = std::thread(&InputMonitor::monitorLoop, this);
+  source_id_ = EventReactor::instance().addSource(
+      device_fd_, [this](uint32_t events) { onReadable(events); });
+
+  if (source_id_ == 0) {
+    stop();
+    return false;
+  }
 
   return true;
 }
 
+void InputMonitor::installEventMask() {
+  // The dialpad also reports EV_MSC scancodes and axes we don't decode.
+  // Masking them keeps them out of our queue entirely, so they neither wake
+  // the reactor nor take up room in the evdev buffer. Kernels without
+  // EVIOCSMASK (< 4.4) keep delivering them and processEvent() ignores them.
+  uint8_t rel_codes[REL_MAX / 8 + 1] = {};
+  for (uint16_t code = 0; code <= REL_MAX; code++) {
+    if (isRotationCode(code)) {
+      setBit(rel_codes, code, true);
+    }
+  }
+
+  uint8_t no_codes[KEY_MAX / 8 + 1] = {};
+  const struct {
+    uint32_t type;
+    const uint8_t *codes;
+    size_t size;
+  } masks[] = {
+      {EV_REL, rel_codes, sizeof(rel_codes)},
+      {EV_MSC, no_codes, MSC_MAX / 8 + 1},
+      {EV_ABS, no_codes, ABS_MAX / 8 + 1},
+      {EV_SW, no_codes, SW_MAX / 8 + 1},
+      {EV_LED, no_codes, LED_MAX / 8 + 1},
+      {EV_SND, no_codes, SND_MAX / 8 + 1},
+  };
+
+  for (const auto &mask : masks) {
+    struct input_mask request = {};
+    request.type = mask.type;
+    request.codes_size = static_cast<uint32_t>(mask.size);
+    request.codes_ptr = reinterpret_cast<uint64_t>(mask.codes);
+    if (ioctl(device_fd_, EVIOCSMASK, &request) < 0) {
+      return;
+    }
+  }
+}
+
 bool InputMonitor::grabDevice(bool grab) {
   if (device_fd_ < 0) {
     return false;
@@ -52,14 +184,16 @@ bool InputMonitor::grabDevice(bool grab) {
 }
 
 void InputMonitor::stop() {
-  if (!running_) {
-    return;
+  // The source may already be gone if the device disappeared, but the fd
+  // still has to be closed
+  uint64_t source_id = source_id_.exchange(0);
+  if (source_id != 0) {
+    EventReactor::instance().removeSource(source_id);
   }
 
-  should_stop_ = true;
-
-  if (monitor_thread_.joinable()) {
-    monitor_thread_.join();
+  uint64_t timer_source_id = timer_source_id_.exchange(0);
+  if (timer_source_id != 0) {
+    EventReactor::instance().removeSource(timer_source_id);
   }
 
   if (device_fd_ >= 0) {
@@ -67,99 +201,370 @@ void InputMonitor::stop() {
     device_fd_ = -1;
   }
 
+  if (timer_fd_ >= 0) {
+    close(timer_fd_);
+    timer_fd_ = -1;
+  }
+
   running_ = false;
 }
 
-void InputMonitor::monitorLoop() {
-  struct pollfd pfd;
-  pfd.fd = device_fd_;
-  pfd.events = POLLIN;
+void InputMonitor::onReadable(uint32_t events) {
+  struct input_event buffer[READ_BATCH_SIZE];
+  ssize_t bytes = 0;
 
-  struct input_event ev;
+  for (int i = 0; i < MAX_READS_PER_WAKEUP; i++) {
+    bytes = read(device_fd_, buffer, sizeof(buffer));
+    if (bytes <= 0) {
+      break;
+    }
 
-  while (!should_stop_) {
-    int ret = poll(&pfd, 1, 100);
+    if (capture_) {
+      capture_->write(CaptureRecordKind::EVDEV, buffer,
+                      static_cast<size_t>(bytes));
+    }
 
-    if (ret < 0) {
-      break;
+    // evdev only ever returns whole events
+    processEvents(buffer,
+                  static_cast<size_t>(bytes) / sizeof(struct input_event));
+
+    // A callback called stop(): the fd is closed, maybe already reused
+    if (stopped()) {
+      return;
     }
 
-    if (ret == 0) {
-      continue;
+    if (static_cast<size_t>(bytes) < sizeof(buffer)) {
+      return; // Drained
     }
+  }
 
-    if (pfd.revents & POLLIN) {
-      ssize_t bytes = read(device_fd_, &ev, sizeof(ev));
+  if (bytes > 0) {
+    return; // More pending, level-triggered epoll will call us again
+  }
 
-      if (bytes == sizeof(ev)) {
-        processEvent(ev);
-      }
+  bool fatal = (bytes < 0 && errno != EAGAIN && errno != EINTR) ||
+               (bytes <= 0 && (events & (EPOLLHUP | EPOLLERR)));
+  if (fatal) {
+    // Device went away - stop watching it, stop() will close the fd
+    uint64_t source_id = source_id_.exchange(0);
+    if (source_id != 0) {
+      EventReactor::instance().removeSource(source_id);
+    }
+    running_ = false;
+  }
+}
+
+void InputMonitor::processEvents(const struct input_event *events,
+                                 size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    processEvent(events[i]);
+    if (stopped()) {
+      return; // The rest of the batch is dropped with the monitor
     }
   }
 }
 
+bool InputMonitor::stopped() const {
+  // The replay decoder never opens a device, so it is never "stopped"
+  return !device_path_.empty() && (!running_ || device_fd_ < 0);
+}
+
 void InputMonitor::processEvent(const struct input_event &ev) {
-  if (!callback_) {
+  if (ev.type == EV_SYN) {
+    if (ev.code == SYN_DROPPED) {
+      // The kernel buffer overflowed: this frame is incomplete and so is
+      // everything until the next SYN_REPORT
+      discardFrame();
+      syncing_ = true;
+    } else if (ev.code == SYN_REPORT) {
+      if (syncing_) {
+        discardFrame();
+        syncing_ = false;
+        resyncKeys(eventTimestamp(ev));
+        if (!stopped()) {
+          dispatcher_.endFrame();
+        }
+      } else {
+        commitFrame();
+      }
+    }
+    return;
+  }
+
+  if (syncing_) {
     return;
   }
 
   if (ev.type == EV_REL) {
-    if (ev.code == 0x06 || ev.code == 0x08 || ev.code == 0x0b ||
-        ev.code == 0x0c || ev.code == REL_HWHEEL || ev.code == REL_MISC ||
-        ev.code == REL_WHEEL || ev.code == REL_DIAL) {
-
-      auto event = std::make_shared<RotationEvent>();
-      event->timestamp =
-          static_cast<uint64_t>(ev.time.tv_sec) * 1000000 + ev.time.tv_usec;
-      event->type = EventType::ROTATION;
-      event->raw_event_code = ev.code;
-
-      // Code 8 (REL_WHEEL) or 11 (REL_WHEEL_HI_RES) = Scroll wheel
-      // Code 6 (REL_HWHEEL) or 12 (REL_HWHEEL_HI_RES) = Dial/knob
-      if (ev.code == 0x08 || ev.code == 0x0b) {
-        event->rotation_type = RotationType::WHEEL;
-      } else {
-        event->rotation_type = RotationType::DIAL;
-      }
+    EventRecord record = {};
+    if (!decodeRotation(ev, record)) {
+      return;
+    }
 
-      if (ev.code == 0x06 || ev.code == 0x08) {
-        event->delta = ev.value;
-        event->delta_high_res = ev.value * 120;
-      } else if (ev.code == 0x0b || ev.code == 0x0c) {
-        event->delta_high_res = ev.value;
-        event->delta = ev.value / 120;
-        if (event->delta == 0 && ev.value != 0) {
-          event->delta = (ev.value > 0) ? 1 : -1;
-        }
-      } else if (ev.code == REL_DIAL) {
-        event->delta = ev.value;
-        event->delta_high_res = ev.value * 120;
-      } else if (ev.code == REL_MISC) {
-        event->delta_high_res = ev.value;
-        event->delta = (ev.value > 0) ? 1 : -1;
-      }
+    if (!coalescing_.merge_axes) {
+      bufferRecord(record);
+      return;
+    }
 
-      callback_(event);
+    // Hold the value until SYN_REPORT so both axes become one event
+    AxisFrame &axis =
+        frame_axes_[static_cast<int>(record.rotation.rotation_type)];
+    if (RotationFrame::isHighResCode(ev.code)) {
+      axis.high_res_seen = true;
+      axis.high_res += ev.value;
+      axis.raw_event_code = ev.code;
+    } else {
+      axis.low_res_seen = true;
+      axis.low_res += ev.value;
+      if (!axis.high_res_seen) {
+        axis.raw_event_code = ev.code;
+      }
     }
+    axis.timestamp = record.timestamp;
   }
 
   else if (ev.type == EV_KEY) {
-    auto event = std::make_shared<ButtonEvent>();
-    event->timestamp =
-        static_cast<uint64_t>(ev.time.tv_sec) * 1000000 + ev.time.tv_usec;
-    event->button_code = ev.code;
+    if (ev.code > KEY_MAX) {
+      return;
+    }
+
+    EventRecord record = {};
+    record.timestamp = eventTimestamp(ev);
+    record.button.button_code = ev.code;
 
     if (ev.value == 1) {
-      event->type = EventType::BUTTON_PRESS;
-      event->pressed = true;
+      record.type = EventType::BUTTON_PRESS;
+      record.button.pressed = true;
     } else if (ev.value == 0) {
-      event->type = EventType::BUTTON_RELEASE;
-      event->pressed = false;
+      record.type = EventType::BUTTON_RELEASE;
+      record.button.pressed = false;
     } else {
+      return; // Autorepeat
+    }
+
+    bufferRecord(record);
+  }
+}
+
+void InputMonitor::bufferRecord(const EventRecord &record) {
+  if (frame_record_count_ == MAX_FRAME_RECORDS) {
+    // Unusually long frame: deliver what we have rather than lose events.
+    // These can no longer be retracted by a SYN_DROPPED.
+    size_t count = frame_record_count_;
+    frame_record_count_ = 0;
+    for (size_t i = 0; i < count; i++) {
+      deliverRecord(frame_records_[i]);
+      if (stopped()) {
+        return;
+      }
+    }
+  }
+
+  frame_records_[frame_record_count_++] = record;
+}
+
+void InputMonitor::commitFrame() {
+  // A callback may stop the monitor at any point; stopping ends the frame,
+  // so nothing more of it is delivered here
+  size_t count = frame_record_count_;
+  frame_record_count_ = 0;
+  for (size_t i = 0; i < count; i++) {
+    deliverRecord(frame_records_[i]);
+    if (stopped()) {
+      return;
+    }
+  }
+
+  if (coalescing_.merge_axes) {
+    flushFrameAxes();
+    if (stopped()) {
       return;
     }
+  }
+  dispatcher_.endFrame();
+}
+
+void InputMonitor::deliverRecord(const EventRecord &record) {
+  if (record.type != EventType::ROTATION) {
+    setBit(key_state_, record.button.button_code, record.button.pressed);
+
+    // Rotations held back by the window happened before this press
+    flushCoalesced();
+    if (stopped()) {
+      return;
+    }
+  }
+  dispatcher_.dispatch(record);
+}
+
+void InputMonitor::discardFrame() {
+  frame_record_count_ = 0;
+  for (auto &axis : frame_axes_) {
+    axis = AxisFrame();
+  }
+}
+
+void InputMonitor::resyncKeys(uint64_t timestamp) {
+  uint8_t keys[sizeof(key_state_)] = {};
+  if (device_fd_ < 0 ||
+      ioctl(device_fd_, EVIOCGKEY(sizeof(keys)), keys) < 0) {
+    return; // Replayed input: nothing to ask, keep the state we have
+  }
+
+  for (size_t byte = 0; byte < sizeof(keys); byte++) {
+    unsigned changed = keys[byte] ^ key_state_[byte];
+    while (changed) {
+      unsigned bit = __builtin_ctz(changed);
+      changed &= changed - 1;
+
+      EventRecord record = {};
+      record.timestamp = timestamp;
+      record.button.button_code = static_cast<uint32_t>(byte * 8 + bit);
+      record.button.pressed = keys[byte] & (1u << bit);
+      record.type = record.button.pressed ? EventType::BUTTON_PRESS
+                                          : EventType::BUTTON_RELEASE;
+
+      flushCoalesced();
+      if (stopped()) {
+        return;
+      }
+      dispatcher_.dispatch(record);
+      if (stopped()) {
+        return;
+      }
+    }
+    key_state_[byte] = keys[byte];
+  }
+}
+
+bool InputMonitor::decodeRotation(const struct input_event &ev,
+                                  EventRecord &record) {
+  if (!isRotationCode(ev.code)) {
+    return false;
+  }
+
+  record.type = EventType::ROTATION;
+  record.timestamp = eventTimestamp(ev);
+  EventRecord::Rotation &rotation = record.rotation;
+  rotation.raw_event_code = ev.code;
+
+  // Code 8 (REL_WHEEL) or 11 (REL_WHEEL_HI_RES) = Scroll wheel
+  // Code 6 (REL_HWHEEL) or 12 (REL_HWHEEL_HI_RES) = Dial/knob
+  if (ev.code == 0x08 || ev.code == 0x0b) {
+    rotation.rotation_type = RotationType::WHEEL;
+  } else {
+    rotation.rotation_type = RotationType::DIAL;
+  }
+
+  if (ev.code == 0x06 || ev.code == 0x08) {
+    rotation.delta = ev.value;
+    rotation.delta_high_res = ev.value * 120;
+  } else if (ev.code == 0x0b || ev.code == 0x0c) {
+    rotation.delta_high_res = ev.value;
+    rotation.delta = ev.value / 120;
+    if (rotation.delta == 0 && ev.value != 0) {
+      rotation.delta = (ev.value > 0) ? 1 : -1;
+    }
+  } else if (ev.code == REL_DIAL) {
+    rotation.delta = ev.value;
+    rotation.delta_high_res = ev.value * 120;
+  } else if (ev.code == REL_MISC) {
+    rotation.delta_high_res = ev.value;
+    rotation.delta = (ev.value > 0) ? 1 : -1;
+  }
+
+  return true;
+}
+
+void InputMonitor::flushFrameAxes() {
+  for (int type = 0; type < 2; type++) {
+    AxisFrame &axis = frame_axes_[type];
+    if (!axis.low_res_seen && !axis.high_res_seen) {
+      continue;
+    }
+
+    EventRecord record = {};
+    record.type = EventType::ROTATION;
+    record.timestamp = axis.timestamp;
+    record.rotation.rotation_type = static_cast<RotationType>(type);
+    record.rotation.raw_event_code = axis.raw_event_code;
+
+    if (axis.low_res_seen && axis.high_res_seen) {
+      record.rotation.delta = axis.low_res;
+      record.rotation.delta_high_res = axis.high_res;
+    } else if (axis.high_res_seen) {
+      // Partial detent: no low-res step yet, so delta stays 0 rather than
+      // being rounded to +-1 as decodeRotation() does for a lone event.
+      // Merged rotations get summed by the coalescing window, and rounding
+      // each partial step up would count detents that never happened.
+      record.rotation.delta = axis.high_res / 120;
+      record.rotation.delta_high_res = axis.high_res;
+    } else {
+      record.rotation.delta = axis.low_res;
+      record.rotation.delta_high_res = axis.low_res * 120;
+    }
+
+    axis = AxisFrame();
+
+    if (coalescing_.window_us > 0) {
+      accumulate(record);
+    } else {
+      dispatcher_.dispatch(record);
+    }
+    if (stopped()) {
+      return;
+    }
+  }
+}
+
+void InputMonitor::accumulate(const EventRecord &record) {
+  PendingRotation &pending =
+      pending_[static_cast<int>(record.rotation.rotation_type)];
+
+  if (pending.valid &&
+      record.timestamp - pending.window_start <=
+          coalescing_.window_us * 1000ull) {
+    pending.record.rotation.delta += record.rotation.delta;
+    pending.record.rotation.delta_high_res += record.rotation.delta_high_res;
+    pending.record.timestamp = record.timestamp;
+    return;
+  }
+
+  if (pending.valid) {
+    dispatcher_.dispatch(pending.record);
+  }
+
+  pending.valid = true;
+  pending.window_start = record.timestamp;
+  pending.record = record;
+
+  if (timer_fd_ >= 0) {
+    struct itimerspec timer = {};
+    timer.it_value.tv_sec = coalescing_.window_us / 1000000;
+    timer.it_value.tv_nsec = (coalescing_.window_us % 1000000) * 1000;
+    timerfd_settime(timer_fd_, 0, &timer, nullptr);
+  }
+}
+
+bool InputMonitor::flushCoalesced() {
+  bool flushed = false;
+  for (auto &pending : pending_) {
+    if (pending.valid) {
+      pending.valid = false;
+      dispatcher_.dispatch(pending.record);
+      flushed = true;
+    }
+  }
+  return flushed;
+}
+
+void InputMonitor::onTimer() {
+  uint64_t expirations;
+  ssize_t ret = read(timer_fd_, &expirations, sizeof(expirations));
+  (void)ret;
 
-    callback_(event);
+  if (flushCoalesced() && !stopped()) {
+    dispatcher_.endFrame();
   }
 }
 
@@ -6,24 +6,31 @@
 #ifndef LOGILINUX_INPUT_MONITOR_H
 #define LOGILINUX_INPUT_MONITOR_H
 
+#include "event_dispatcher.h"
+#include "../util/capture.h"
+#include "logilinux/device.h"
 #include "logilinux/events.h"
 #include <atomic>
-#include <functional>
+#include <cstddef>
 #include <linux/input.h>
 #include <string>
-#include <thread>
 
 namespace LogiLinux {
 
 class InputMonitor {
 public:
-  InputMonitor(const std::string &device_path);
+  /**
+   * Raw reads are also appended to capture, if given, while it is open
+   */
+  InputMonitor(const std::string &device_path, EventDispatcher &dispatcher,
+               CaptureWriter *capture = nullptr);
   ~InputMonitor();
 
   /**
-   * Start monitoring events in a background thread
+   * Start monitoring events on the library's event reactor thread.
+   * Decoded events are handed to the dispatcher, frame by frame.
    */
-  bool start(EventCallback callback);
+  bool start();
 
   /**
    * Grab the device exclusively (prevents other apps from receiving events)
@@ -40,25 +47,133 @@ public:
    */
   bool isRunning() const { return running_; }
 
+  /**
+   * Decode raw input events as if they had been read from the device
+   */
+  void processEvents(const struct input_event *events, size_t count);
+
+  /**
+   * Configure rotation coalescing (only while stopped)
+   */
+  bool setRotationCoalescing(const RotationCoalescing &options);
+
+  /**
+   * Deliver rotations still held back by the coalescing window. Returns
+   * false if there were none. The caller ends the frame.
+   */
+  bool flushCoalesced();
+
 private:
   /**
-   * Main monitoring loop (runs in separate thread)
+   * Drain readable data from the device (runs on the reactor thread)
    */
-  void monitorLoop();
+  void onReadable(uint32_t events);
+
+  /**
+   * A callback stopped this (device-reading) monitor while it was
+   * delivering: return without delivering or ending anything more
+   */
+  bool stopped() const;
 
   /**
    * Process a raw input event
    */
   void processEvent(const struct input_event &ev);
 
+  /**
+   * Ask the kernel to only queue the event codes we decode
+   */
+  void installEventMask();
+
+  /**
+   * Hold a decoded event until the SYN_REPORT that completes its frame
+   */
+  void bufferRecord(const EventRecord &record);
+
+  /**
+   * Deliver the buffered frame (SYN_REPORT received)
+   */
+  void commitFrame();
+
+  /**
+   * Deliver one buffered event, keeping key_state_ in step for resyncKeys()
+   */
+  void deliverRecord(const EventRecord &record);
+
+  /**
+   * Drop the buffered frame (SYN_DROPPED received)
+   */
+  void discardFrame();
+
+  /**
+   * Re-read the key state after SYN_DROPPED and emit the presses and
+   * releases that were lost in the overflow
+   */
+  void resyncKeys(uint64_t timestamp);
+
+  /**
+   * Decode an EV_REL event into a rotation record
+   */
+  bool decodeRotation(const struct input_event &ev, EventRecord &record);
+
+  /**
+   * Merge the axes collected for the current SYN frame into one rotation
+   * per axis and deliver them
+   */
+  void flushFrameAxes();
+
+  /**
+   * Feed a merged rotation into the coalescing window
+   */
+  void accumulate(const EventRecord &record);
+
+  /**
+   * Coalescing window timer expired (runs on the reactor thread)
+   */
+  void onTimer();
+
+  // Low-res and high-res values of one rotation axis within a SYN frame
+  struct AxisFrame {
+    bool low_res_seen;
+    bool high_res_seen;
+    int32_t low_res;
+    int32_t high_res;
+    uint16_t raw_event_code;
+    uint64_t timestamp;
+  };
+
+  // Rotation held back by the coalescing window
+  struct PendingRotation {
+    bool valid;
+    uint64_t window_start;
+    EventRecord record;
+  };
+
   std::string device_path_;
-  EventCallback callback_;
+  EventDispatcher &dispatcher_;
+  CaptureWriter *capture_;
 
-  std::thread monitor_thread_;
   std::atomic<bool> running_;
-  std::atomic<bool> should_stop_;
+  std::atomic<uint64_t> source_id_;
 
   int device_fd_;
+
+  // Events of the SYN frame in progress
+  static constexpr size_t MAX_FRAME_RECORDS = 16;
+  EventRecord frame_records_[MAX_FRAME_RECORDS];
+  size_t frame_record_count_;
+
+  // Set by SYN_DROPPED; everything up to the next SYN_REPORT is discarded
+  bool syncing_;
+
+  // Key state as delivered to consumers, in EVIOCGKEY layout
+  uint8_t key_state_[KEY_MAX / 8 + 1];
+
+  RotationCoalescing coalescing_;
+  AxisFrame frame_axes_[2];       // Indexed by RotationType
+  PendingRotation pending_[2];    // Indexed by RotationType
+  int timer_fd_;
+  std::atomic<uint64_t> timer_source_id_;
 };
 
 } // namespace LogiLinux
@@ -0,0 +1,83 @@
+/*
+ * LogiLinux - Latency Recorder Implementation
+ */
+
+#include "latency_recorder.h"
+#include "logilinux/events.h"
+#include <limits>
+
+namespace LogiLinux {
+
+LatencyRecorder::LatencyRecorder() : reset_epoch_(0), applied_epoch_(0) {
+  clear();
+}
+
+void LatencyRecorder::record(uint64_t timestamp_ns) {
+  if (timestamp_ns == 0) {
+    return; // Synthetic event
+  }
+
+  uint64_t now = getMonotonicTimestamp();
+  if (timestamp_ns > now) {
+    return; // Not stamped with our clock
+  }
+
+  uint64_t latency = now - timestamp_ns;
+
+  uint64_t epoch = reset_epoch_.load(std::memory_order_acquire);
+  if (epoch != applied_epoch_.load(std::memory_order_relaxed)) {
+    clear();
+    applied_epoch_.store(epoch, std::memory_order_release);
+  }
+
+  // Single writer, so plain load/store pairs are enough; relaxed ordering
+  // keeps this to a handful of uncontended instructions per event
+  auto &bucket = buckets_[LatencyHistogram::bucketFor(latency)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+  count_.store(count_.load(std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+  sum_ns_.store(sum_ns_.load(std::memory_order_relaxed) + latency,
+                std::memory_order_relaxed);
+  if (latency < min_ns_.load(std::memory_order_relaxed)) {
+    min_ns_.store(latency, std::memory_order_relaxed);
+  }
+  if (latency > max_ns_.load(std::memory_order_relaxed)) {
+    max_ns_.store(latency, std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram LatencyRecorder::snapshot() const {
+  LatencyHistogram histogram = {};
+  if (applied_epoch_.load(std::memory_order_acquire) !=
+      reset_epoch_.load(std::memory_order_relaxed)) {
+    return histogram; // Reset, and the writer hasn't cleared it yet
+  }
+
+  for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+    histogram.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  histogram.count = count_.load(std::memory_order_relaxed);
+  histogram.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+  histogram.max_ns = max_ns_.load(std::memory_order_relaxed);
+  histogram.min_ns = histogram.count ? min_ns_.load(std::memory_order_relaxed)
+                                     : 0;
+  return histogram;
+}
+
+void LatencyRecorder::reset() {
+  reset_epoch_.fetch_add(1, std::memory_order_release);
+}
+
+void LatencyRecorder::clear() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_ns_.store(0, std::memory_order_relaxed);
+  min_ns_.store(std::numeric_limits<uint64_t>::max(),
+                std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace LogiLinux
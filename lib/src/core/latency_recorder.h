@@ -0,0 +1,53 @@
+/*
+ * LogiLinux - Latency Recorder
+ * Lock-free histogram of kernel-event-to-delivery latency
+ */
+
+#ifndef LOGILINUX_LATENCY_RECORDER_H
+#define LOGILINUX_LATENCY_RECORDER_H
+
+#include "logilinux/device.h"
+#include <atomic>
+#include <cstdint>
+
+namespace LogiLinux {
+
+class LatencyRecorder {
+public:
+  LatencyRecorder();
+
+  LatencyRecorder(const LatencyRecorder &) = delete;
+  LatencyRecorder &operator=(const LatencyRecorder &) = delete;
+
+  /**
+   * Record the age of an event stamped at timestamp_ns (CLOCK_MONOTONIC).
+   * Called from the reactor thread only; readers may snapshot concurrently.
+   */
+  void record(uint64_t timestamp_ns);
+
+  LatencyHistogram snapshot() const;
+
+  /**
+   * Empty the histogram. Safe from any thread: the request is applied by
+   * the writer before its next record(), so a concurrent record() can't
+   * leave a count over zeroed buckets. Snapshots taken meanwhile are empty.
+   */
+  void reset();
+
+private:
+  void clear();
+
+  std::atomic<uint64_t> buckets_[LatencyHistogram::BUCKET_COUNT];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> min_ns_;
+  std::atomic<uint64_t> max_ns_;
+  std::atomic<uint64_t> sum_ns_;
+
+  // reset() bumps the requested epoch, record() catches up to it
+  std::atomic<uint64_t> reset_epoch_;
+  std::atomic<uint64_t> applied_epoch_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_LATENCY_RECORDER_H
@@ -1,5 +1,10 @@
 
 #include "core/device_manager.h"
+#include "core/discovery_cache.h"
+#include "core/event_stream.h"
+#include "core/device_registry.h"
+#include "core/hotplug_monitor.h"
+#include "devices/replay_device.h"
 #include "logilinux/logilinux.h"
 #include "logilinux/version.h"
 #include <algorithm>
@@ -8,10 +13,19 @@ namespace LogiLinux {
 
 class Library::Impl {
 public:
-  Impl() : device_manager_(std::make_unique<DeviceManager>()) {}
+  Impl() : registry_(std::make_unique<DeviceManager>()) {}
 
-  std::unique_ptr<DeviceManager> device_manager_;
-  std::vector<DevicePtr> devices_;
+  ~Impl() {
+    // The hotplug thread calls into the registry and the stream, so it
+    // goes first. The stream then detaches from its devices, which may
+    // still be monitoring, before the registry drops them.
+    hotplug_.reset();
+  }
+
+  DeviceRegistry registry_;
+  EventStream stream_;
+  std::unique_ptr<HotplugMonitor> hotplug_;
+  HotplugCallback hotplug_callback_;
 };
 
 Library::Library() : pImpl(std::make_unique<Impl>()) {}
@@ -21,20 +35,35 @@ Library::~Library() = default;
 Version Library::getVersion() { return LogiLinux::getVersion(); }
 
 std::vector<DevicePtr> Library::discoverDevices() {
-  pImpl->devices_ = pImpl->device_manager_->scanDevices();
-  return pImpl->devices_;
+  // Changes a rescan finds are reported like hotplug events, in case the
+  // monitor missed any
+  if (isHotplugMonitoring()) {
+    return pImpl->registry_.scan(pImpl->hotplug_callback_);
+  }
+  return pImpl->registry_.scan();
+}
+
+bool Library::enableDiscoveryCache(const std::string &path) {
+  std::string cache_path = path.empty() ? DiscoveryCache::defaultPath() : path;
+  if (cache_path.empty()) {
+    return false;
+  }
+
+  pImpl->registry_.setCachePath(cache_path);
+  return true;
 }
 
 DevicePtr Library::findDevice(DeviceType type) {
-  if (pImpl->devices_.empty()) {
+  if (pImpl->registry_.empty()) {
     discoverDevices();
   }
+  auto devices = pImpl->registry_.devices();
 
   // For MX_KEYPAD, prefer hidraw devices over event devices
   // because the keypad needs hidraw for LCD control and initialization
   if (type == DeviceType::MX_KEYPAD) {
     // First pass: look for hidraw device
-    for (const auto &device : pImpl->devices_) {
+    for (const auto &device : devices) {
       if (device->getType() == type) {
         const auto &info = device->getInfo();
         if (info.device_path.find("/dev/hidraw") != std::string::npos) {
@@ -43,14 +72,14 @@ DevicePtr Library::findDevice(DeviceType type) {
       }
     }
     // Second pass: if no hidraw found, return any matching device
-    for (const auto &device : pImpl->devices_) {
+    for (const auto &device : devices) {
       if (device->getType() == type) {
         return device;
       }
     }
   } else {
     // For other devices, return first match
-    for (const auto &device : pImpl->devices_) {
+    for (const auto &device : devices) {
       if (device->getType() == type) {
         return device;
       }
@@ -61,12 +90,13 @@ DevicePtr Library::findDevice(DeviceType type) {
 }
 
 std::vector<DevicePtr> Library::findDevices(DeviceType type) {
-  if (pImpl->devices_.empty()) {
+  if (pImpl->registry_.empty()) {
     discoverDevices();
   }
+  auto devices = pImpl->registry_.devices();
 
   std::vector<DevicePtr> result;
-  for (const auto &device : pImpl->devices_) {
+  for (const auto &device : devices) {
     if (device->getType() == type) {
       result.push_back(device);
     }
@@ -75,4 +105,85 @@ std::vector<DevicePtr> Library::findDevices(DeviceType type) {
   return result;
 }
 
+bool Library::startHotplugMonitoring(HotplugCallback callback) {
+  if (pImpl->hotplug_ && pImpl->hotplug_->isRunning()) {
+    return false;
+  }
+
+  auto source = createUeventSource();
+  if (!source) {
+    return false;
+  }
+
+  // Start listening before the initial scan so nothing plugged in between
+  // the two is missed; the registry ignores nodes it already knows
+  pImpl->hotplug_ = std::make_unique<HotplugMonitor>(std::move(source));
+  EventStream *stream = &pImpl->stream_;
+  pImpl->hotplug_callback_ = [stream, callback](DeviceEventPtr event,
+                                                DevicePtr device) {
+    if (callback) {
+      callback(event, device);
+    }
+    if (event->type == EventType::DEVICE_DISCONNECTED) {
+      stream->remove(device);
+    }
+  };
+
+  DeviceRegistry *registry = &pImpl->registry_;
+  HotplugCallback notify = pImpl->hotplug_callback_;
+  bool started = pImpl->hotplug_->start(
+      [registry, notify](const UeventMessage &message) {
+        registry->handleUevent(message, notify);
+      });
+  if (!started) {
+    pImpl->hotplug_.reset();
+    return false;
+  }
+
+  // Devices already present are not reported as connected
+  if (pImpl->registry_.empty()) {
+    pImpl->registry_.scan();
+  }
+  return true;
+}
+
+void Library::stopHotplugMonitoring() { pImpl->hotplug_.reset(); }
+
+bool Library::isHotplugMonitoring() const {
+  return pImpl->hotplug_ && pImpl->hotplug_->isRunning();
+}
+
+DeviceHandle Library::addToEventStream(const DevicePtr &device,
+                                       size_t capacity,
+                                       OverflowPolicy policy) {
+  return pImpl->stream_.add(device, capacity, policy);
+}
+
+bool Library::removeFromEventStream(const DevicePtr &device) {
+  return pImpl->stream_.remove(device);
+}
+
+size_t Library::pollEvents(EventRecord *events, size_t max_events) {
+  return pImpl->stream_.poll(events, max_events);
+}
+
+size_t Library::dispatchEvents(const EventRecordCallback &callback,
+                               int timeout_ms) {
+  return pImpl->stream_.dispatch(callback, timeout_ms);
+}
+
+int Library::getEventFd() const { return pImpl->stream_.eventFd(); }
+
+DevicePtr Library::getDevice(DeviceHandle handle) const {
+  return pImpl->stream_.device(handle);
+}
+
+DevicePtr Library::openReplay(const std::string &path, ReplaySpeed speed) {
+  auto device = std::make_shared<ReplayDevice>(speed);
+  if (!device->open(path)) {
+    return nullptr;
+  }
+  return device;
+}
+
 } // namespace LogiLinux
@@ -0,0 +1,61 @@
+/*
+ * LogiLinux - Rotation Frame
+ * Net rotation per axis over one hardware frame
+ */
+
+#ifndef LOGILINUX_ROTATION_FRAME_H
+#define LOGILINUX_ROTATION_FRAME_H
+
+#include "logilinux/events.h"
+#include <cstdint>
+#include <linux/input.h>
+
+namespace LogiLinux {
+
+/**
+ * Without axis merging the dialpad reports each detent on both its low-res
+ * and its high-res code, so summing delta_high_res over a frame would count
+ * it twice. This counts the high-res reports of an axis when there are any
+ * and falls back to the low-res ones otherwise.
+ */
+class RotationFrame {
+public:
+  // REL_WHEEL_HI_RES, REL_HWHEEL_HI_RES and REL_MISC report the same
+  // movement as their low-res partner in 1/120 steps
+  static bool isHighResCode(uint16_t code) {
+    return code == 0x0b || code == 0x0c || code == REL_MISC;
+  }
+
+  void add(const EventRecord &record) {
+    Axis &axis = axes_[static_cast<int>(record.rotation.rotation_type)];
+    if (isHighResCode(record.rotation.raw_event_code)) {
+      axis.high_res_seen = true;
+      axis.high_res += record.rotation.delta_high_res;
+    } else {
+      axis.low_res += record.rotation.delta_high_res;
+    }
+  }
+
+  /**
+   * Rotation of one axis in high-res units (120 per detent), clearing it
+   */
+  int64_t take(RotationType type) {
+    Axis &axis = axes_[static_cast<int>(type)];
+    int64_t delta = axis.high_res_seen ? axis.high_res : axis.low_res;
+    axis = Axis();
+    return delta;
+  }
+
+private:
+  struct Axis {
+    int64_t low_res = 0; // In high-res units
+    int64_t high_res = 0;
+    bool high_res_seen = false;
+  };
+
+  Axis axes_[2]; // Indexed by RotationType
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_ROTATION_FRAME_H
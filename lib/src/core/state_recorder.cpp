@@ -0,0 +1,70 @@
+/*
+ * LogiLinux - State Recorder Implementation
+ */
+
+#include "state_recorder.h"
+
+namespace LogiLinux {
+
+StateRecorder::StateRecorder()
+    : current_(), dirty_(false), sequence_(0), dial_position_(0),
+      wheel_position_(0), buttons_(0), last_event_ns_(0) {}
+
+void StateRecorder::record(const EventRecord &record) {
+  if (record.type == EventType::ROTATION) {
+    rotation_.add(record);
+  } else if (record.type == EventType::BUTTON_PRESS) {
+    current_.buttons |= DeviceState::buttonMask(record.button.button_code);
+  } else if (record.type == EventType::BUTTON_RELEASE) {
+    current_.buttons &= ~DeviceState::buttonMask(record.button.button_code);
+  } else {
+    return;
+  }
+
+  if (record.timestamp > current_.last_event_ns) {
+    current_.last_event_ns = record.timestamp;
+  }
+  dirty_ = true;
+}
+
+void StateRecorder::commit() {
+  if (!dirty_) {
+    return;
+  }
+  dirty_ = false;
+
+  current_.dial_position += rotation_.take(RotationType::DIAL);
+  current_.wheel_position += rotation_.take(RotationType::WHEEL);
+
+  // Single writer: bump the sequence to odd, write, bump it back to even.
+  // The fields are relaxed atomics so a racing reader is well defined; the
+  // fences order them against the sequence.
+  uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  dial_position_.store(current_.dial_position, std::memory_order_relaxed);
+  wheel_position_.store(current_.wheel_position, std::memory_order_relaxed);
+  buttons_.store(current_.buttons, std::memory_order_relaxed);
+  last_event_ns_.store(current_.last_event_ns, std::memory_order_relaxed);
+
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+DeviceState StateRecorder::snapshot() const {
+  DeviceState state;
+  uint32_t before;
+  uint32_t after;
+  do {
+    before = sequence_.load(std::memory_order_acquire);
+    state.dial_position = dial_position_.load(std::memory_order_relaxed);
+    state.wheel_position = wheel_position_.load(std::memory_order_relaxed);
+    state.buttons = buttons_.load(std::memory_order_relaxed);
+    state.last_event_ns = last_event_ns_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = sequence_.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  return state;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,57 @@
+/*
+ * LogiLinux - State Recorder
+ * Seqlock-protected DeviceState, published once per hardware frame
+ */
+
+#ifndef LOGILINUX_STATE_RECORDER_H
+#define LOGILINUX_STATE_RECORDER_H
+
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include "rotation_frame.h"
+#include <atomic>
+#include <cstdint>
+
+namespace LogiLinux {
+
+class StateRecorder {
+public:
+  StateRecorder();
+
+  StateRecorder(const StateRecorder &) = delete;
+  StateRecorder &operator=(const StateRecorder &) = delete;
+
+  /**
+   * Fold one delivered event into the current frame. Called from the
+   * thread decoding the device only.
+   */
+  void record(const EventRecord &record);
+
+  /**
+   * Publish the frame recorded so far. Same thread as record().
+   */
+  void commit();
+
+  /**
+   * Consistent copy of the last published state; any thread, never blocks
+   * the writer
+   */
+  DeviceState snapshot() const;
+
+private:
+  // Writer-only
+  DeviceState current_;
+  RotationFrame rotation_;
+  bool dirty_;
+
+  // Odd while the writer is updating the fields below
+  alignas(64) std::atomic<uint32_t> sequence_;
+  std::atomic<int64_t> dial_position_;
+  std::atomic<int64_t> wheel_position_;
+  std::atomic<uint64_t> buttons_;
+  std::atomic<uint64_t> last_event_ns_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_STATE_RECORDER_H
@@ -0,0 +1,160 @@
+/*
+ * LogiLinux - Sysfs Helpers Implementation
+ */
+
+#include "sysfs.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// Attributes and uevent files we read are far smaller than a page
+constexpr size_t MAX_ATTRIBUTE_SIZE = 4096;
+
+static bool readSmallFile(const std::string &path, std::string &contents) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  char buffer[MAX_ATTRIBUTE_SIZE];
+  ssize_t bytes = read(fd, buffer, sizeof(buffer));
+  close(fd);
+
+  if (bytes < 0) {
+    return false;
+  }
+
+  contents.assign(buffer, static_cast<size_t>(bytes));
+  return true;
+}
+
+bool Uevent::load(const std::string &path) {
+  std::string contents;
+  if (!readSmallFile(path, contents)) {
+    return false;
+  }
+
+  vars_.clear();
+  size_t start = 0;
+  while (start < contents.size()) {
+    size_t end = contents.find('\n', start);
+    if (end == std::string::npos) {
+      end = contents.size();
+    }
+
+    size_t equals = contents.find('=', start);
+    if (equals != std::string::npos && equals < end) {
+      vars_.emplace_back(contents.substr(start, equals - start),
+                         contents.substr(equals + 1, end - equals - 1));
+    }
+    start = end + 1;
+  }
+
+  return true;
+}
+
+std::string Uevent::get(const std::string &key) const {
+  for (const auto &var : vars_) {
+    if (var.first == key) {
+      return var.second;
+    }
+  }
+  return "";
+}
+
+bool Sysfs::readAttribute(const std::string &path, std::string &value) {
+  if (!readSmallFile(path, value)) {
+    return false;
+  }
+
+  while (!value.empty() && (value.back() == '\n' || value.back() == '\0')) {
+    value.pop_back();
+  }
+  return true;
+}
+
+bool Sysfs::readHexAttribute(const std::string &path, uint16_t &value) {
+  std::string text;
+  if (!readAttribute(path, text) || text.empty()) {
+    return false;
+  }
+
+  char *end = nullptr;
+  unsigned long parsed = strtoul(text.c_str(), &end, 16);
+  if (end == text.c_str() || parsed > UINT16_MAX) {
+    return false;
+  }
+
+  value = static_cast<uint16_t>(parsed);
+  return true;
+}
+
+std::string Sysfs::resolvePath(const std::string &path) {
+  char resolved[PATH_MAX];
+  if (!realpath(path.c_str(), resolved)) {
+    return "";
+  }
+  return resolved;
+}
+
+std::vector<std::string> Sysfs::listEntries(const std::string &path,
+                                            const std::string &prefix) {
+  std::vector<std::string> entries;
+
+  DIR *dir = opendir(path.c_str());
+  if (!dir) {
+    return entries;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    std::string name = entry->d_name;
+    if (name.compare(0, prefix.size(), prefix) == 0 &&
+        name.size() > prefix.size()) {
+      entries.push_back(name);
+    }
+  }
+  closedir(dir);
+
+  size_t prefix_size = prefix.size();
+  std::sort(entries.begin(), entries.end(),
+            [prefix_size](const std::string &a, const std::string &b) {
+              return strtoul(a.c_str() + prefix_size, nullptr, 10) <
+                     strtoul(b.c_str() + prefix_size, nullptr, 10);
+            });
+
+  return entries;
+}
+
+bool Sysfs::parseHidId(const std::string &hid_id, uint16_t &bus,
+                       uint16_t &vendor, uint16_t &product) {
+  // BUS:VENDOR:PRODUCT with 4 and 8 hex digit fields
+  const char *text = hid_id.c_str();
+  char *end = nullptr;
+
+  unsigned long bus_value = strtoul(text, &end, 16);
+  if (*end != ':') {
+    return false;
+  }
+  unsigned long vendor_value = strtoul(end + 1, &end, 16);
+  if (*end != ':') {
+    return false;
+  }
+  unsigned long product_value = strtoul(end + 1, &end, 16);
+  if (end == text || bus_value > UINT16_MAX || vendor_value > UINT16_MAX ||
+      product_value > UINT16_MAX) {
+    return false;
+  }
+
+  bus = static_cast<uint16_t>(bus_value);
+  vendor = static_cast<uint16_t>(vendor_value);
+  product = static_cast<uint16_t>(product_value);
+  return true;
+}
+
+} // namespace LogiLinux
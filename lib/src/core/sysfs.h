@@ -0,0 +1,66 @@
+/*
+ * LogiLinux - Sysfs Helpers
+ * Read device attributes from sysfs without opening device nodes
+ */
+
+#ifndef LOGILINUX_SYSFS_H
+#define LOGILINUX_SYSFS_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace LogiLinux {
+
+/**
+ * KEY=VALUE pairs of a sysfs uevent file
+ */
+class Uevent {
+public:
+  bool load(const std::string &path);
+
+  /**
+   * Value of key, or an empty string if absent
+   */
+  std::string get(const std::string &key) const;
+
+private:
+  std::vector<std::pair<std::string, std::string>> vars_;
+};
+
+class Sysfs {
+public:
+  /**
+   * Read a small attribute file, without the trailing newline
+   */
+  static bool readAttribute(const std::string &path, std::string &value);
+
+  /**
+   * Read an attribute holding a hexadecimal number (e.g. id/vendor)
+   */
+  static bool readHexAttribute(const std::string &path, uint16_t &value);
+
+  /**
+   * Canonical path with symlinks resolved, or an empty string if it doesn't
+   * exist
+   */
+  static std::string resolvePath(const std::string &path);
+
+  /**
+   * Names of the entries in a directory starting with prefix, in numeric
+   * order of their suffix (event2 before event10)
+   */
+  static std::vector<std::string> listEntries(const std::string &path,
+                                              const std::string &prefix);
+
+  /**
+   * Parse a HID_ID value ("0003:0000046D:0000C354")
+   */
+  static bool parseHidId(const std::string &hid_id, uint16_t &bus,
+                         uint16_t &vendor, uint16_t &product);
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_SYSFS_H
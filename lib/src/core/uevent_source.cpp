@@ -0,0 +1,224 @@
+/*
+ * LogiLinux - Uevent Source Implementation
+ */
+
+#include "uevent_source.h"
+#include <cerrno>
+#include <cstring>
+#include <linux/netlink.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// Multicast group the kernel sends uevents to (udev rebroadcasts on 2)
+constexpr unsigned KERNEL_UEVENT_GROUP = 1;
+
+// Largest uevent the kernel sends (UEVENT_BUFFER_SIZE)
+constexpr size_t UEVENT_BUFFER_SIZE = 2048;
+
+constexpr uint32_t WATCH_MASK =
+    IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM;
+
+// Enough for a burst of inotify events with maximum-length names
+constexpr size_t INOTIFY_BUFFER_SIZE =
+    16 * (sizeof(struct inotify_event) + 256);
+
+NetlinkUeventSource::NetlinkUeventSource() : fd_(-1) {}
+
+NetlinkUeventSource::~NetlinkUeventSource() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool NetlinkUeventSource::open() {
+  if (fd_ >= 0) {
+    return true;
+  }
+
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  NETLINK_KOBJECT_UEVENT);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = KERNEL_UEVENT_GROUP;
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+  return true;
+}
+
+bool NetlinkUeventSource::read(std::vector<UeventMessage> &messages) {
+  char buffer[UEVENT_BUFFER_SIZE];
+
+  while (true) {
+    struct sockaddr_nl sender = {};
+    socklen_t sender_len = sizeof(sender);
+    ssize_t len = recvfrom(fd_, buffer, sizeof(buffer), 0,
+                           reinterpret_cast<struct sockaddr *>(&sender),
+                           &sender_len);
+    if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // ENOBUFS means messages were lost, which a later add or remove for
+      // the same node corrects; the socket itself is still fine
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS;
+    }
+
+    // Anything not from the kernel (port 0) could be forged by another
+    // process
+    if (sender_len != sizeof(sender) || sender.nl_pid != 0) {
+      continue;
+    }
+
+    UeventMessage message;
+    if (parse(buffer, static_cast<size_t>(len), message)) {
+      messages.push_back(std::move(message));
+    }
+  }
+}
+
+bool NetlinkUeventSource::parse(const char *data, size_t len,
+                                UeventMessage &message) {
+  // The "action@devpath" header is followed by NUL-separated KEY=VALUE
+  // pairs; the header carries nothing the pairs don't
+  size_t header_len = strnlen(data, len);
+  if (header_len == len || !memchr(data, '@', header_len)) {
+    return false;
+  }
+
+  message = UeventMessage();
+  size_t pos = header_len + 1;
+  while (pos < len) {
+    const char *entry = data + pos;
+    size_t entry_len = strnlen(entry, len - pos);
+    const char *equals =
+        static_cast<const char *>(memchr(entry, '=', entry_len));
+
+    if (equals) {
+      std::string key(entry, equals - entry);
+      std::string value(equals + 1, entry + entry_len);
+      if (key == "ACTION") {
+        message.action = std::move(value);
+      } else if (key == "SUBSYSTEM") {
+        message.subsystem = std::move(value);
+      } else if (key == "DEVNAME") {
+        message.devname = std::move(value);
+      }
+    }
+
+    pos += entry_len + 1;
+  }
+
+  return !message.action.empty() && !message.subsystem.empty();
+}
+
+InotifyUeventSource::InotifyUeventSource(const std::string &dev_root)
+    : dev_root_(dev_root), fd_(-1), input_wd_(-1), dev_wd_(-1) {}
+
+InotifyUeventSource::~InotifyUeventSource() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool InotifyUeventSource::open() {
+  if (fd_ >= 0) {
+    return true;
+  }
+
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  input_wd_ =
+      inotify_add_watch(fd, (dev_root_ + "/input").c_str(), WATCH_MASK);
+  dev_wd_ = inotify_add_watch(fd, dev_root_.c_str(), WATCH_MASK);
+  if (input_wd_ < 0 && dev_wd_ < 0) {
+    close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+  return true;
+}
+
+bool InotifyUeventSource::read(std::vector<UeventMessage> &messages) {
+  alignas(struct inotify_event) char buffer[INOTIFY_BUFFER_SIZE];
+
+  while (true) {
+    ssize_t len = ::read(fd_, buffer, sizeof(buffer));
+    if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (len == 0) {
+      return false;
+    }
+
+    for (ssize_t pos = 0; pos < len;) {
+      const auto *event = reinterpret_cast<const struct inotify_event *>(
+          buffer + pos);
+      pos += sizeof(struct inotify_event) + event->len;
+
+      if (event->len == 0) {
+        continue;
+      }
+
+      std::string name = event->name;
+
+      // /dev/input only exists once the first input device does
+      if (event->mask & IN_ISDIR) {
+        if (event->wd == dev_wd_ && name == "input" && input_wd_ < 0 &&
+            (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+          input_wd_ = inotify_add_watch(fd_, (dev_root_ + "/input").c_str(),
+                                        WATCH_MASK);
+        }
+        continue;
+      }
+
+      UeventMessage message;
+      if (event->wd == input_wd_ && name.compare(0, 5, "event") == 0) {
+        message.subsystem = "input";
+        message.devname = "input/" + name;
+      } else if (event->wd == dev_wd_ && name.compare(0, 6, "hidraw") == 0) {
+        message.subsystem = "hidraw";
+        message.devname = name;
+      } else {
+        continue;
+      }
+
+      message.action =
+          (event->mask & (IN_CREATE | IN_MOVED_TO)) ? "add" : "remove";
+      messages.push_back(std::move(message));
+    }
+  }
+}
+
+std::unique_ptr<UeventSource> createUeventSource(const std::string &dev_root) {
+  auto netlink = std::make_unique<NetlinkUeventSource>();
+  if (netlink->open()) {
+    return netlink;
+  }
+
+  auto inotify = std::make_unique<InotifyUeventSource>(dev_root);
+  if (inotify->open()) {
+    return inotify;
+  }
+
+  return nullptr;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,108 @@
+/*
+ * LogiLinux - Uevent Source
+ * Device add/remove notifications from the kernel or from /dev
+ */
+
+#ifndef LOGILINUX_UEVENT_SOURCE_H
+#define LOGILINUX_UEVENT_SOURCE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LogiLinux {
+
+/**
+ * One device node appearing or going away
+ */
+struct UeventMessage {
+  std::string action;    // "add", "remove", "change", ...
+  std::string subsystem; // "input", "hidraw", ...
+  std::string devname;   // Node relative to /dev, e.g. "input/event5"
+};
+
+/**
+ * Pollable stream of uevents. HotplugMonitor takes any implementation, so
+ * hotplug handling can be driven without real hardware.
+ */
+class UeventSource {
+public:
+  virtual ~UeventSource() = default;
+
+  /**
+   * fd that becomes readable when messages are pending
+   */
+  virtual int fd() const = 0;
+
+  /**
+   * Append every pending message to messages without blocking. Returns
+   * false if the source failed and will not deliver anything more.
+   */
+  virtual bool read(std::vector<UeventMessage> &messages) = 0;
+};
+
+/**
+ * Kernel uevents from a NETLINK_KOBJECT_UEVENT socket. Only messages sent
+ * by the kernel itself are accepted.
+ */
+class NetlinkUeventSource : public UeventSource {
+public:
+  NetlinkUeventSource();
+  ~NetlinkUeventSource() override;
+
+  NetlinkUeventSource(const NetlinkUeventSource &) = delete;
+  NetlinkUeventSource &operator=(const NetlinkUeventSource &) = delete;
+
+  /**
+   * Create and bind the socket. Fails where netlink sockets are not
+   * permitted, e.g. in some containers.
+   */
+  bool open();
+
+  int fd() const override { return fd_; }
+  bool read(std::vector<UeventMessage> &messages) override;
+
+  /**
+   * Parse one datagram ("add@/devices/...\0ACTION=add\0SUBSYSTEM=...\0")
+   */
+  static bool parse(const char *data, size_t len, UeventMessage &message);
+
+private:
+  int fd_;
+};
+
+/**
+ * Fallback when netlink is unavailable: watches dev_root/input and dev_root
+ * with inotify and reports event* and hidraw* nodes being created or
+ * deleted
+ */
+class InotifyUeventSource : public UeventSource {
+public:
+  explicit InotifyUeventSource(const std::string &dev_root = "/dev");
+  ~InotifyUeventSource() override;
+
+  InotifyUeventSource(const InotifyUeventSource &) = delete;
+  InotifyUeventSource &operator=(const InotifyUeventSource &) = delete;
+
+  bool open();
+
+  int fd() const override { return fd_; }
+  bool read(std::vector<UeventMessage> &messages) override;
+
+private:
+  std::string dev_root_;
+  int fd_;
+  int input_wd_;
+  int dev_wd_;
+};
+
+/**
+ * Netlink source if it can be opened, otherwise the inotify fallback, or
+ * nullptr if neither works
+ */
+std::unique_ptr<UeventSource>
+createUeventSource(const std::string &dev_root = "/dev");
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_UEVENT_SOURCE_H
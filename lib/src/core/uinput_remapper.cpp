@@ -0,0 +1,242 @@
+/*
+ * LogiLinux - uinput Remapper Implementation
+ */
+
+#include "uinput_remapper.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+RemapEngine::RemapEngine(const RemapConfig &config)
+    : config_(config), count_(0), finished_(false), frame_start_ns_(0),
+      frame_end_ns_(0) {}
+
+bool RemapEngine::passesThrough(uint32_t button_code) {
+  return button_code >= BTN_MISC && button_code <= BTN_TASK;
+}
+
+std::vector<uint16_t> RemapEngine::keyCodes() const {
+  std::vector<uint16_t> codes;
+  for (uint16_t code = BTN_MISC; code <= BTN_TASK; code++) {
+    codes.push_back(code);
+  }
+  for (const RotationMapping *mapping : {&config_.dial, &config_.wheel}) {
+    if (mapping->output == RemapOutput::KEYS) {
+      codes.push_back(mapping->positive_key);
+      codes.push_back(mapping->negative_key);
+    }
+  }
+  for (const auto &button : config_.buttons) {
+    codes.push_back(button.key);
+  }
+
+  codes.erase(std::remove(codes.begin(), codes.end(), 0), codes.end());
+  std::sort(codes.begin(), codes.end());
+  codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+  return codes;
+}
+
+void RemapEngine::append(uint16_t type, uint16_t code, int32_t value) {
+  if (count_ == MAX_FRAME_EVENTS) {
+    return;
+  }
+  struct input_event &ev = frame_[count_++];
+  memset(&ev, 0, sizeof(ev)); // uinput stamps the time itself
+  ev.type = type;
+  ev.code = code;
+  ev.value = value;
+}
+
+void RemapEngine::process(const EventRecord &record) {
+  if (finished_) {
+    count_ = 0;
+    frame_start_ns_ = 0;
+    finished_ = false;
+  }
+  if (frame_start_ns_ == 0 || record.timestamp < frame_start_ns_) {
+    frame_start_ns_ = record.timestamp;
+  }
+  frame_end_ns_ = std::max(frame_end_ns_, record.timestamp);
+
+  if (record.type == EventType::ROTATION) {
+    rotation_.add(record);
+    return;
+  }
+
+  if (record.type != EventType::BUTTON_PRESS &&
+      record.type != EventType::BUTTON_RELEASE) {
+    return;
+  }
+
+  uint32_t code = record.button.button_code;
+  uint16_t key = passesThrough(code) ? static_cast<uint16_t>(code) : 0;
+  for (const auto &button : config_.buttons) {
+    if (button.button_code == code) {
+      key = button.key;
+      break;
+    }
+  }
+  if (key != 0) {
+    append(EV_KEY, key, record.button.pressed ? 1 : 0);
+  }
+}
+
+void RemapEngine::emitRotation(const RotationMapping &mapping,
+                               AxisState &state, int64_t delta,
+                               uint64_t timestamp) {
+  double gain = 1.0;
+  if (mapping.acceleration > 0 && state.last_ns != 0 &&
+      timestamp > state.last_ns) {
+    double seconds = (timestamp - state.last_ns) / 1e9;
+    double speed = std::abs(delta) / 120.0 / seconds; // Detents per second
+    if (speed > mapping.threshold) {
+      gain = std::min(1.0 + mapping.acceleration * (speed - mapping.threshold),
+                      std::max(mapping.max_gain, 1.0));
+    }
+  }
+  state.last_ns = timestamp;
+
+  double scaled = (mapping.invert ? -delta : delta) * gain + state.residual;
+
+  if (mapping.output == RemapOutput::KEYS) {
+    int64_t taps = static_cast<int64_t>(scaled / 120);
+    state.residual = scaled - taps * 120.0;
+    taps = std::max<int64_t>(std::min<int64_t>(taps, MAX_TAPS), -MAX_TAPS);
+
+    uint16_t key = taps > 0 ? mapping.positive_key : mapping.negative_key;
+    for (int64_t i = 0; key != 0 && i < std::abs(taps); i++) {
+      // Each press and release in its own frame, as a keyboard sends them
+      append(EV_KEY, key, 1);
+      append(EV_SYN, SYN_REPORT, 0);
+      append(EV_KEY, key, 0);
+      append(EV_SYN, SYN_REPORT, 0);
+    }
+    return;
+  }
+
+  bool vertical = mapping.output == RemapOutput::SCROLL;
+  int64_t high_res = static_cast<int64_t>(scaled);
+  state.residual = scaled - high_res;
+  if (high_res == 0) {
+    return;
+  }
+
+  // Like a real high-res wheel: a low-res step for every 120 high-res units
+  state.low_res += high_res;
+  int64_t low_res = state.low_res / 120;
+  state.low_res -= low_res * 120;
+
+  append(EV_REL, vertical ? REL_WHEEL_HI_RES : REL_HWHEEL_HI_RES,
+         static_cast<int32_t>(high_res));
+  if (low_res != 0) {
+    append(EV_REL, vertical ? REL_WHEEL : REL_HWHEEL,
+           static_cast<int32_t>(low_res));
+  }
+}
+
+size_t RemapEngine::finishFrame() {
+  if (finished_) {
+    return 0; // Nothing new since the last frame
+  }
+  finished_ = true;
+
+  const RotationType types[] = {RotationType::DIAL, RotationType::WHEEL};
+  const RotationMapping *mappings[] = {&config_.dial, &config_.wheel};
+  for (int i = 0; i < 2; i++) {
+    int64_t delta = rotation_.take(types[i]);
+    if (delta != 0 && mappings[i]->output != RemapOutput::NONE) {
+      emitRotation(*mappings[i], axes_[static_cast<int>(types[i])], delta,
+                   frame_end_ns_);
+    }
+  }
+
+  if (count_ > 0 && frame_[count_ - 1].type != EV_SYN) {
+    if (count_ == MAX_FRAME_EVENTS) {
+      count_--; // The frame must end in SYN_REPORT
+    }
+    append(EV_SYN, SYN_REPORT, 0);
+  }
+  return count_;
+}
+
+UinputRemapper::UinputRemapper(const RemapConfig &config)
+    : engine_(config), fd_(-1), frames_(0), events_(0), write_errors_(0) {}
+
+UinputRemapper::~UinputRemapper() {
+  if (fd_ >= 0) {
+    ioctl(fd_, UI_DEV_DESTROY);
+    close(fd_);
+  }
+}
+
+bool UinputRemapper::open() {
+  fd_ = ::open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    return false;
+  }
+
+  bool ok = ioctl(fd_, UI_SET_EVBIT, EV_SYN) >= 0 &&
+            ioctl(fd_, UI_SET_EVBIT, EV_KEY) >= 0 &&
+            ioctl(fd_, UI_SET_EVBIT, EV_REL) >= 0;
+
+  // REL_X/REL_Y are never sent, but without them the desktop doesn't take
+  // a device with wheels and mouse buttons for a pointer
+  const uint16_t rel_codes[] = {REL_X, REL_Y, REL_WHEEL, REL_HWHEEL,
+                                REL_WHEEL_HI_RES, REL_HWHEEL_HI_RES};
+  for (uint16_t code : rel_codes) {
+    ok = ok && ioctl(fd_, UI_SET_RELBIT, code) >= 0;
+  }
+  for (uint16_t code : engine_.keyCodes()) {
+    ok = ok && ioctl(fd_, UI_SET_KEYBIT, code) >= 0;
+  }
+
+  // Deliberately not the source's VID/PID, so discovery never mistakes the
+  // virtual device for the real one
+  struct uinput_setup setup;
+  memset(&setup, 0, sizeof(setup));
+  setup.id.bustype = BUS_VIRTUAL;
+  strncpy(setup.name, engine_.name().c_str(), UINPUT_MAX_NAME_SIZE - 1);
+
+  ok = ok && ioctl(fd_, UI_DEV_SETUP, &setup) >= 0 &&
+       ioctl(fd_, UI_DEV_CREATE) >= 0;
+  if (!ok) {
+    close(fd_);
+    fd_ = -1;
+  }
+  return ok;
+}
+
+void UinputRemapper::endFrame() {
+  size_t count = engine_.finishFrame();
+  if (count == 0 || fd_ < 0) {
+    return;
+  }
+
+  size_t size = count * sizeof(struct input_event);
+  ssize_t written = write(fd_, engine_.events(), size);
+  if (written != static_cast<ssize_t>(size)) {
+    write_errors_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  frames_.fetch_add(1, std::memory_order_relaxed);
+  events_.fetch_add(count, std::memory_order_relaxed);
+  latency_.record(engine_.frameTimestamp());
+}
+
+RemapStats UinputRemapper::stats() const {
+  RemapStats stats;
+  stats.frames = frames_.load(std::memory_order_relaxed);
+  stats.events = events_.load(std::memory_order_relaxed);
+  stats.write_errors = write_errors_.load(std::memory_order_relaxed);
+  stats.latency = latency_.snapshot();
+  return stats;
+}
+
+} // namespace LogiLinux
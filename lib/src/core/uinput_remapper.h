@@ -0,0 +1,124 @@
+/*
+ * LogiLinux - uinput Remapper
+ * Re-emits transformed device frames from a uinput virtual device
+ */
+
+#ifndef LOGILINUX_UINPUT_REMAPPER_H
+#define LOGILINUX_UINPUT_REMAPPER_H
+
+#include "latency_recorder.h"
+#include "logilinux/device.h"
+#include "logilinux/events.h"
+#include "rotation_frame.h"
+#include <atomic>
+#include <cstddef>
+#include <linux/input.h>
+#include <string>
+#include <vector>
+
+namespace LogiLinux {
+
+/**
+ * Turns decoded events into the input_events of one output frame. Kept
+ * apart from the uinput device so it can run without /dev/uinput.
+ */
+class RemapEngine {
+public:
+  // Enough for a frame of buttons plus MAX_TAPS taps on both axes
+  static constexpr size_t MAX_FRAME_EVENTS = 320;
+  static constexpr int MAX_TAPS = 32;
+
+  explicit RemapEngine(const RemapConfig &config);
+
+  /**
+   * Add one decoded event to the current frame
+   */
+  void process(const EventRecord &record);
+
+  /**
+   * Close the current frame: appends rotation output and SYN_REPORT and
+   * returns the number of events in events() (0: nothing to write)
+   */
+  size_t finishFrame();
+
+  const struct input_event *events() const { return frame_; }
+
+  /**
+   * Kernel timestamp of the earliest event in the frame just finished
+   */
+  uint64_t frameTimestamp() const { return frame_start_ns_; }
+
+  /**
+   * Key codes the engine can emit, for the uinput device setup
+   */
+  std::vector<uint16_t> keyCodes() const;
+
+  const std::string &name() const { return config_.name; }
+
+private:
+  struct AxisState {
+    uint64_t last_ns = 0; // Previous frame with rotation, for speed
+    double residual = 0;  // Scaled high-res movement not emitted yet
+    int64_t low_res = 0;  // High-res units towards the next low-res step
+  };
+
+  void append(uint16_t type, uint16_t code, int32_t value);
+  void emitRotation(const RotationMapping &mapping, AxisState &state,
+                    int64_t delta, uint64_t timestamp);
+  static bool passesThrough(uint32_t button_code);
+
+  RemapConfig config_;
+  RotationFrame rotation_;
+  AxisState axes_[2]; // Indexed by RotationType
+
+  struct input_event frame_[MAX_FRAME_EVENTS];
+  size_t count_;
+  bool finished_; // events() holds a finished frame
+  uint64_t frame_start_ns_;
+  uint64_t frame_end_ns_;
+};
+
+class UinputRemapper {
+public:
+  explicit UinputRemapper(const RemapConfig &config);
+  ~UinputRemapper();
+
+  UinputRemapper(const UinputRemapper &) = delete;
+  UinputRemapper &operator=(const UinputRemapper &) = delete;
+
+  /**
+   * Create the virtual device; false if /dev/uinput isn't usable
+   */
+  bool open();
+
+  /**
+   * Write frames to fd instead of a virtual device, taking it over; lets
+   * benchmarks check the output without /dev/uinput
+   */
+  void attach(int fd) { fd_ = fd; }
+
+  /**
+   * Same as RemapEngine; called from the thread decoding the device
+   */
+  void process(const EventRecord &record) { engine_.process(record); }
+
+  /**
+   * Write the frame's output in a single write()
+   */
+  void endFrame();
+
+  RemapStats stats() const;
+
+private:
+  RemapEngine engine_;
+  int fd_;
+
+  std::atomic<uint64_t> frames_;
+  std::atomic<uint64_t> events_;
+  std::atomic<uint64_t> write_errors_;
+  LatencyRecorder latency_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_UINPUT_REMAPPER_H
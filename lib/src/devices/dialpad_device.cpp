@@ -5,14 +5,20 @@
 namespace LogiLinux {
 
 DialpadDevice::DialpadDevice(const DeviceInfo &info)
-    : info_(info), monitor_(std::make_unique<InputMonitor>(info.device_path)) {
+    : info_(info),
+      monitor_(std::make_unique<InputMonitor>(info.device_path, dispatcher_,
+                                              &capture_)) {
 
   capabilities_.push_back(DeviceCapability::ROTATION);
   capabilities_.push_back(DeviceCapability::BUTTONS);
   capabilities_.push_back(DeviceCapability::HIGH_RES_SCROLL);
 }
 
-DialpadDevice::~DialpadDevice() { stopMonitoring(); }
+DialpadDevice::~DialpadDevice() {
+  // No final flush: callbacks shouldn't run from the destructor
+  dispatcher_.interruptQueue();
+  monitor_->stop();
+}
 
 bool DialpadDevice::hasCapability(DeviceCapability cap) const {
   return std::find(capabilities_.begin(), capabilities_.end(), cap) !=
@@ -20,16 +26,95 @@ bool DialpadDevice::hasCapability(DeviceCapability cap) const {
 }
 
 void DialpadDevice::setEventCallback(EventCallback callback) {
-  event_callback_ = callback;
+  dispatcher_.setEventCallback(callback);
 }
 
-void DialpadDevice::startMonitoring() {
-  if (event_callback_) {
-    monitor_->start(event_callback_);
+void DialpadDevice::setFrameCallback(FrameCallback callback) {
+  dispatcher_.setFrameCallback(callback);
+}
+
+void DialpadDevice::setEventRecordCallback(EventRecordCallback callback) {
+  dispatcher_.setRecordCallback(callback);
+}
+
+bool DialpadDevice::enableEventQueue(size_t capacity, OverflowPolicy policy) {
+  if (isMonitoring()) {
+    return false;
   }
+  return dispatcher_.enableQueue(capacity, policy);
+}
+
+size_t DialpadDevice::pollEvents(EventRecord *events, size_t max_events) {
+  return dispatcher_.pollQueue(events, max_events);
 }
 
-void DialpadDevice::stopMonitoring() { monitor_->stop(); }
+int DialpadDevice::getEventFd() const { return dispatcher_.queueFd(); }
+
+EventQueueStats DialpadDevice::getEventQueueStats() const {
+  return dispatcher_.queueStats();
+}
+
+LatencyHistogram DialpadDevice::getLatencyHistogram() const {
+  return dispatcher_.latencyHistogram();
+}
+
+void DialpadDevice::resetLatencyHistogram() {
+  dispatcher_.resetLatencyHistogram();
+}
+
+DeviceState DialpadDevice::getState() const { return dispatcher_.state(); }
+
+bool DialpadDevice::startCapture(const std::string &path) {
+  return capture_.open(path, info_);
+}
+
+void DialpadDevice::stopCapture() { capture_.close(); }
+
+bool DialpadDevice::enableRemapping(const RemapConfig &config) {
+  if (isMonitoring()) {
+    return false;
+  }
+  return dispatcher_.enableRemapping(config);
+}
+
+void DialpadDevice::disableRemapping() {
+  if (!isMonitoring()) {
+    dispatcher_.disableRemapping();
+  }
+}
+
+RemapStats DialpadDevice::getRemapStats() const {
+  return dispatcher_.remapStats();
+}
+
+void DialpadDevice::setEventStreamSink(DeviceHandle handle,
+                                       EventRecordCallback sink) {
+  dispatcher_.setStreamSink(handle, sink);
+}
+
+bool DialpadDevice::setRotationCoalescing(const RotationCoalescing &options) {
+  if (isMonitoring()) {
+    return false;
+  }
+  return monitor_->setRotationCoalescing(options);
+}
+
+void DialpadDevice::startMonitoring() {
+  dispatcher_.resumeQueue();
+  monitor_->start();
+}
+
+void DialpadDevice::stopMonitoring() {
+  dispatcher_.interruptQueue();
+  monitor_->stop();
+
+  // Rotations still in the coalescing window would be lost (start() clears
+  // them). Flushed once the reactor is done with the monitor, so nothing
+  // races with its handlers. The frame is ended even with nothing to flush:
+  // a callback may have stopped the monitor halfway through one.
+  monitor_->flushCoalesced();
+  dispatcher_.endFrame();
+}
 
 bool DialpadDevice::isMonitoring() const { return monitor_->isRunning(); }
 
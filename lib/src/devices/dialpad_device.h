@@ -2,7 +2,9 @@
 #ifndef LOGILINUX_DIALPAD_DEVICE_H
 #define LOGILINUX_DIALPAD_DEVICE_H
 
+#include "../core/event_dispatcher.h"
 #include "../core/input_monitor.h"
+#include "../util/capture.h"
 #include "logilinux/device.h"
 #include <memory>
 
@@ -13,11 +15,29 @@ public:
   explicit DialpadDevice(const DeviceInfo &info);
   ~DialpadDevice() override;
 
-  const DeviceInfo &getInfo() const override { return info_; }
+  DeviceInfo getInfo() const override { return info_; }
   DeviceType getType() const override { return info_.type; }
   bool hasCapability(DeviceCapability cap) const override;
 
   void setEventCallback(EventCallback callback) override;
+  void setFrameCallback(FrameCallback callback) override;
+  void setEventRecordCallback(EventRecordCallback callback) override;
+  bool enableEventQueue(size_t capacity, OverflowPolicy policy) override;
+  using Device::pollEvents;
+  size_t pollEvents(EventRecord *events, size_t max_events) override;
+  int getEventFd() const override;
+  EventQueueStats getEventQueueStats() const override;
+  bool setRotationCoalescing(const RotationCoalescing &options) override;
+  LatencyHistogram getLatencyHistogram() const override;
+  void resetLatencyHistogram() override;
+  DeviceState getState() const override;
+  bool startCapture(const std::string &path) override;
+  void stopCapture() override;
+  bool enableRemapping(const RemapConfig &config) override;
+  void disableRemapping() override;
+  RemapStats getRemapStats() const override;
+  void setEventStreamSink(DeviceHandle handle,
+                          EventRecordCallback sink) override;
   void startMonitoring() override;
   void stopMonitoring() override;
   bool isMonitoring() const override;
@@ -27,7 +47,8 @@ public:
 private:
   DeviceInfo info_;
   std::vector<DeviceCapability> capabilities_;
-  EventCallback event_callback_;
+  EventDispatcher dispatcher_;
+  CaptureWriter capture_;
   std::unique_ptr<InputMonitor> monitor_;
 };
 
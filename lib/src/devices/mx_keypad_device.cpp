@@ -1,4 +1,9 @@
 #include "mx_keypad_device.h"
+#include "mx_keypad_lcd_writer.h"
+#include "mx_keypad_packetizer.h"
+#include "mx_keypad_report_parser.h"
+#include "../core/event_reactor.h"
+#include "../util/capture.h"
 #include "../util/gif_decoder.h"
 #include <algorithm>
 #include <atomic>
@@ -8,43 +13,18 @@
 #include <iostream>
 #include <linux/hidraw.h>
 #include <map>
-#include <poll.h>
-#include <set>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
-#include <sys/uio.h>
 #include <thread>
 #include <unistd.h>
 
 namespace LogiLinux {
 
-constexpr size_t MAX_PACKET_SIZE = 4095;
-constexpr size_t LCD_SIZE = 118;
-
-// Uber-optimization: Pre-computed packet headers for zero-copy assembly
-alignas(64) static const uint8_t PACKET_BASE_HEADER[4] = {0x14, 0xff, 0x02, 0x2b};
-alignas(64) static const uint8_t PACKET1_GEOMETRY[6] = {0x01, 0x00, 0x01, 0x00, 0x00, 0x00};
-
-// Memory pool for packet buffers to avoid allocations
-class PacketBufferPool {
-private:
-  static constexpr size_t POOL_SIZE = 16;
-  std::array<std::vector<uint8_t>, POOL_SIZE> pool;
-  std::atomic<size_t> next_free{0};
-
-public:
-  PacketBufferPool() {
-    for (auto& buffer : pool) {
-      buffer.resize(MAX_PACKET_SIZE);
-    }
-  }
-
-  std::vector<uint8_t>& acquire() {
-    size_t idx = next_free.fetch_add(1) % POOL_SIZE;
-    return pool[idx];
-  }
-};
+static_assert(MXKeypadDevice::MAX_JPEG_SIZE ==
+                  MXKeypadPacketizer::MAX_JPEG_SIZE,
+              "JPEG size limit out of sync with the packetizer");
 
-static PacketBufferPool packet_pool;
+constexpr size_t LCD_SIZE = 118;
 
 struct KeyAnimation {
   GifAnimation animation;
@@ -58,11 +38,18 @@ struct KeyAnimation {
 struct MXKeypadDevice::Impl {
   int hidraw_fd = -1;
   std::string hidraw_path;
+  // Node hidraw_fd was opened on, cleared once that node goes away
+  std::string lcd_path;
   bool initialized = false;
   std::atomic<bool> monitoring = false;
-  std::thread monitor_thread;
-  std::set<uint8_t> pressed_buttons; // Track all currently pressed buttons
-  uint8_t last_p_button = 0; // Track last pressed P1/P2 button (0xa1 or 0xa2)
+  int monitor_fd = -1;
+  std::atomic<uint64_t> monitor_source{0};
+  std::vector<uint8_t> report = std::vector<uint8_t>(256);
+  MXKeypadReportParser parser;
+  CaptureWriter capture;
+
+  // Sends every image, created once hidraw_fd is open
+  std::unique_ptr<MXKeypadLcdWriter> lcd_writer;
 
   // GIF animation tracking (per-key)
   std::map<int, std::unique_ptr<KeyAnimation>> animations;
@@ -77,207 +64,29 @@ struct MXKeypadDevice::Impl {
        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
   };
 
-  std::vector<std::vector<uint8_t>>
-  generateImagePackets(int keyIndex, const std::vector<uint8_t> &jpegData) {
-    // Uber-optimized: Pre-calculate everything for zero-copy assembly
-    const size_t PACKET1_HEADER = 20;
-    const size_t SUBSEQUENT_HEADER = 5;
-
-    // Calculate total packets upfront
-    size_t totalPackets = 1; // At least first packet
-    size_t remainingAfterFirst = jpegData.size() > (MAX_PACKET_SIZE - PACKET1_HEADER)
-                                ? jpegData.size() - (MAX_PACKET_SIZE - PACKET1_HEADER)
-                                : 0;
-    if (remainingAfterFirst > 0) {
-      totalPackets += (remainingAfterFirst + (MAX_PACKET_SIZE - SUBSEQUENT_HEADER) - 1) /
-                     (MAX_PACKET_SIZE - SUBSEQUENT_HEADER);
-    }
-
-    // Pre-allocate result with exact size to avoid reallocations
-    std::vector<std::vector<uint8_t>> result;
-    result.reserve(totalPackets);
-
-    // Pre-calculate key position
-    int row = keyIndex / 3;
-    int col = keyIndex % 3;
-    const uint16_t x = 23 + col * (118 + 40);
-    const uint16_t y = 6 + row * (118 + 40);
-
-    // Uber-optimization: Pre-compute first packet header for memcpy
-    uint8_t packet1_header[PACKET1_HEADER] = {0};
-    memcpy(packet1_header, PACKET_BASE_HEADER, 4); // 0x14, 0xff, 0x02, 0x2b
-    packet1_header[4] = generateWritePacketByte(1, true,
-                          jpegData.size() <= (MAX_PACKET_SIZE - PACKET1_HEADER));
-    memcpy(packet1_header + 5, PACKET1_GEOMETRY, 6); // 0x01, 0x00, 0x01, 0x00, 0x00, 0x00
-    packet1_header[9] = (x >> 8) & 0xff;
-    packet1_header[10] = x & 0xff;
-    packet1_header[11] = (y >> 8) & 0xff;
-    packet1_header[12] = y & 0xff;
-    packet1_header[13] = (LCD_SIZE >> 8) & 0xff;
-    packet1_header[14] = LCD_SIZE & 0xff;
-    packet1_header[15] = (LCD_SIZE >> 8) & 0xff;
-    packet1_header[16] = LCD_SIZE & 0xff;
-    packet1_header[18] = (jpegData.size() >> 8) & 0xff;
-    packet1_header[19] = jpegData.size() & 0xff;
-
-    // First packet - use memory pool buffer
-    auto& packet1 = packet_pool.acquire();
-    memset(packet1.data(), 0, MAX_PACKET_SIZE);
-    memcpy(packet1.data(), packet1_header, PACKET1_HEADER);
-
-    const size_t byteCount1 = std::min(jpegData.size(), MAX_PACKET_SIZE - PACKET1_HEADER);
-    if (byteCount1 > 0) {
-      memcpy(packet1.data() + PACKET1_HEADER, jpegData.data(), byteCount1);
-    }
-    result.push_back(packet1);
-
-    // Subsequent packets - pre-compute base header
-    uint8_t packet_header[SUBSEQUENT_HEADER] = {0};
-    memcpy(packet_header, PACKET_BASE_HEADER, 4);
-
-    // Process remaining data with zero-copy assembly
-    size_t remainingBytes = jpegData.size() - byteCount1;
-    size_t currentOffset = byteCount1;
-    int part = 2;
-
-    while (remainingBytes > 0) {
-      const size_t byteCount = std::min(remainingBytes, MAX_PACKET_SIZE - SUBSEQUENT_HEADER);
-
-      auto& packet = packet_pool.acquire();
-      memset(packet.data(), 0, MAX_PACKET_SIZE);
-
-      // Pre-assemble header
-      packet_header[4] = generateWritePacketByte(part, false, remainingBytes - byteCount == 0);
-      memcpy(packet.data(), packet_header, SUBSEQUENT_HEADER);
-
-      // Zero-copy data placement
-      if (byteCount > 0) {
-        memcpy(packet.data() + SUBSEQUENT_HEADER, jpegData.data() + currentOffset, byteCount);
-      }
-
-      result.push_back(packet);
-
-      remainingBytes -= byteCount;
-      currentOffset += byteCount;
-      part++;
-    }
-
-    return result;
-  }
-
-  uint8_t generateWritePacketByte(int index, bool isFirst, bool isLast) {
-    uint8_t value = index | 0b00100000;
-    if (isFirst)
-      value |= 0b10000000;
-    if (isLast)
-      value |= 0b01000000;
-    return value;
-  }
-
-  // Generate image packets for arbitrary screen region
-  std::vector<std::vector<uint8_t>>
-  generateRawImagePackets(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
-                          const std::vector<uint8_t> &jpegData) {
-    const size_t PACKET1_HEADER = 20;
-    const size_t SUBSEQUENT_HEADER = 5;
-
-    // Calculate total packets upfront
-    size_t totalPackets = 1;
-    size_t remainingAfterFirst = jpegData.size() > (MAX_PACKET_SIZE - PACKET1_HEADER)
-                                ? jpegData.size() - (MAX_PACKET_SIZE - PACKET1_HEADER)
-                                : 0;
-    if (remainingAfterFirst > 0) {
-      totalPackets += (remainingAfterFirst + (MAX_PACKET_SIZE - SUBSEQUENT_HEADER) - 1) /
-                     (MAX_PACKET_SIZE - SUBSEQUENT_HEADER);
-    }
-
-    std::vector<std::vector<uint8_t>> result;
-    result.reserve(totalPackets);
-
-    // Build first packet header
-    uint8_t packet1_header[PACKET1_HEADER] = {0};
-    memcpy(packet1_header, PACKET_BASE_HEADER, 4); // 0x14, 0xff, 0x02, 0x2b
-    packet1_header[4] = generateWritePacketByte(1, true,
-                          jpegData.size() <= (MAX_PACKET_SIZE - PACKET1_HEADER));
-    memcpy(packet1_header + 5, PACKET1_GEOMETRY, 6); // 0x01, 0x00, 0x01, 0x00, 0x00, 0x00
-    packet1_header[9] = (x >> 8) & 0xff;
-    packet1_header[10] = x & 0xff;
-    packet1_header[11] = (y >> 8) & 0xff;
-    packet1_header[12] = y & 0xff;
-    packet1_header[13] = (width >> 8) & 0xff;
-    packet1_header[14] = width & 0xff;
-    packet1_header[15] = (height >> 8) & 0xff;
-    packet1_header[16] = height & 0xff;
-    packet1_header[18] = (jpegData.size() >> 8) & 0xff;
-    packet1_header[19] = jpegData.size() & 0xff;
-
-    // First packet
-    auto& packet1 = packet_pool.acquire();
-    memset(packet1.data(), 0, MAX_PACKET_SIZE);
-    memcpy(packet1.data(), packet1_header, PACKET1_HEADER);
-
-    const size_t byteCount1 = std::min(jpegData.size(), MAX_PACKET_SIZE - PACKET1_HEADER);
-    if (byteCount1 > 0) {
-      memcpy(packet1.data() + PACKET1_HEADER, jpegData.data(), byteCount1);
-    }
-    result.push_back(packet1);
-
-    // Subsequent packets
-    uint8_t packet_header[SUBSEQUENT_HEADER] = {0};
-    memcpy(packet_header, PACKET_BASE_HEADER, 4);
-
-    size_t remainingBytes = jpegData.size() - byteCount1;
-    size_t currentOffset = byteCount1;
-    int part = 2;
-
-    while (remainingBytes > 0) {
-      const size_t byteCount = std::min(remainingBytes, MAX_PACKET_SIZE - SUBSEQUENT_HEADER);
-
-      auto& packet = packet_pool.acquire();
-      memset(packet.data(), 0, MAX_PACKET_SIZE);
-
-      packet_header[4] = generateWritePacketByte(part, false, remainingBytes - byteCount == 0);
-      memcpy(packet.data(), packet_header, SUBSEQUENT_HEADER);
-
-      if (byteCount > 0) {
-        memcpy(packet.data() + SUBSEQUENT_HEADER, jpegData.data() + currentOffset, byteCount);
-      }
-
-      result.push_back(packet);
-
-      remainingBytes -= byteCount;
-      currentOffset += byteCount;
-      part++;
+  bool writeImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                  const std::vector<uint8_t> &jpegData,
+                  LcdPriority priority) {
+    if (jpegData.size() > MAX_JPEG_SIZE) {
+      return false;
     }
-
-    return result;
+    return lcd_writer->write(priority, x, y, width, height, jpegData);
   }
 
-  std::string findHidrawPath(const std::string &event_path) {
-    // Extract event number from path like /dev/input/event5
-    std::string event_name =
-        event_path.substr(event_path.find_last_of('/') + 1);
-    if (event_name.find("event") != 0) {
-      return "";
+  bool postImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                 const std::vector<uint8_t> &jpegData, LcdPriority priority) {
+    if (jpegData.size() > MAX_JPEG_SIZE) {
+      return false;
     }
+    return lcd_writer->post(priority, x, y, width, height, jpegData);
+  }
 
-    // Try to find corresponding hidraw device
-    // This is a simplified approach - in production would use udev
-    for (int i = 0; i < 20; i++) {
-      std::string hidraw = "/dev/hidraw" + std::to_string(i);
-      int fd = open(hidraw.c_str(), O_RDWR | O_NONBLOCK);
-      if (fd >= 0) {
-        struct hidraw_devinfo info;
-        if (ioctl(fd, HIDIOCGRAWINFO, &info) >= 0) {
-          if (info.vendor == 0x046d && info.product == 0xc354) {
-            close(fd);
-            return hidraw;
-          }
-        }
-        close(fd);
-      }
-    }
-    return "";
+  // Top left corner of a key on the screen
+  static uint16_t keyX(int keyIndex) {
+    return 23 + keyIndex % 3 * (LCD_SIZE + 40);
+  }
+  static uint16_t keyY(int keyIndex) {
+    return 6 + keyIndex / 3 * (LCD_SIZE + 40);
   }
 };
 
@@ -290,8 +99,8 @@ MXKeypadDevice::MXKeypadDevice(const DeviceInfo &info)
   if (info.device_path.find("/dev/hidraw") == 0) {
     impl_->hidraw_path = info.device_path;
   } else {
-    // Find the hidraw device for LCD control from event path
-    impl_->hidraw_path = impl_->findHidrawPath(info.device_path);
+    // hidraw node of this keypad for LCD control, paired during discovery
+    impl_->hidraw_path = info.hidraw_path;
   }
 
   if (!impl_->hidraw_path.empty()) {
@@ -301,198 +110,221 @@ MXKeypadDevice::MXKeypadDevice(const DeviceInfo &info)
 }
 
 MXKeypadDevice::~MXKeypadDevice() {
-  stopAllAnimations();
   stopMonitoring();
+  closeLcd();
+}
+
+void MXKeypadDevice::closeLcd() {
+  stopAllAnimations();
+  impl_->lcd_writer.reset();
   if (impl_->hidraw_fd >= 0) {
     close(impl_->hidraw_fd);
+    impl_->hidraw_fd = -1;
+  }
+  impl_->initialized = false;
+}
+
+bool MXKeypadDevice::attachHidraw(const std::string &hidrawPath) {
+  std::lock_guard<std::mutex> lock(info_mutex_);
+  if (hidrawPath.empty() || !impl_->hidraw_path.empty()) {
+    return false;
+  }
+
+  impl_->hidraw_path = hidrawPath;
+  info_.hidraw_path = hidrawPath;
+  capabilities_.push_back(DeviceCapability::LCD_DISPLAY);
+  capabilities_.push_back(DeviceCapability::IMAGE_UPLOAD);
+  return true;
+}
+
+bool MXKeypadDevice::detachHidraw(const std::string &hidrawPath) {
+  std::lock_guard<std::mutex> lock(info_mutex_);
+  if (hidrawPath.empty() || impl_->hidraw_path != hidrawPath ||
+      info_.device_path == hidrawPath) {
+    return false;
   }
+
+  // The open fds still refer to the old node, so they can't reach a new
+  // device that reuses its number; they just fail until initialize()
+  impl_->hidraw_path.clear();
+  impl_->lcd_path.clear();
+  info_.hidraw_path.clear();
+  capabilities_.erase(
+      std::remove_if(capabilities_.begin(), capabilities_.end(),
+                     [](DeviceCapability cap) {
+                       return cap == DeviceCapability::LCD_DISPLAY ||
+                              cap == DeviceCapability::IMAGE_UPLOAD;
+                     }),
+      capabilities_.end());
+  return true;
+}
+
+DeviceInfo MXKeypadDevice::getInfo() const {
+  std::lock_guard<std::mutex> lock(info_mutex_);
+  return info_;
+}
+
+std::string MXKeypadDevice::hidrawPath() const {
+  std::lock_guard<std::mutex> lock(info_mutex_);
+  return impl_->hidraw_path;
 }
 
 bool MXKeypadDevice::hasCapability(DeviceCapability cap) const {
+  std::lock_guard<std::mutex> lock(info_mutex_);
   return std::find(capabilities_.begin(), capabilities_.end(), cap) !=
          capabilities_.end();
 }
 
 void MXKeypadDevice::setEventCallback(EventCallback callback) {
-  event_callback_ = callback;
+  dispatcher_.setEventCallback(callback);
 }
 
-void MXKeypadDevice::startMonitoring() {
-  if (impl_->monitoring || !event_callback_) {
-    return;
+void MXKeypadDevice::setFrameCallback(FrameCallback callback) {
+  dispatcher_.setFrameCallback(callback);
+}
+
+void MXKeypadDevice::setEventRecordCallback(EventRecordCallback callback) {
+  dispatcher_.setRecordCallback(callback);
+}
+
+bool MXKeypadDevice::enableEventQueue(size_t capacity, OverflowPolicy policy) {
+  if (isMonitoring()) {
+    return false;
   }
+  return dispatcher_.enableQueue(capacity, policy);
+}
 
-  impl_->monitoring = true;
-  impl_->monitor_thread = std::thread([this]() {
-    // Use hidraw path for reading button events
-    std::string monitor_path =
-        impl_->hidraw_path.empty() ? info_.device_path : impl_->hidraw_path;
+size_t MXKeypadDevice::pollEvents(EventRecord *events, size_t max_events) {
+  return dispatcher_.pollQueue(events, max_events);
+}
 
-    int fd = open(monitor_path.c_str(), O_RDONLY | O_NONBLOCK);
-    if (fd < 0) {
-      impl_->monitoring = false;
-      return;
-    }
+int MXKeypadDevice::getEventFd() const { return dispatcher_.queueFd(); }
 
-    constexpr size_t REPORT_SIZE = 256;
-    std::vector<uint8_t> report(REPORT_SIZE);
+EventQueueStats MXKeypadDevice::getEventQueueStats() const {
+  return dispatcher_.queueStats();
+}
 
-    // Set up poll for event-driven reading
-    struct pollfd pfd;
-    pfd.fd = fd;
-    pfd.events = POLLIN;
+LatencyHistogram MXKeypadDevice::getLatencyHistogram() const {
+  return dispatcher_.latencyHistogram();
+}
 
-    while (impl_->monitoring) {
-      // Wait for data with 100ms timeout (same as dialpad)
-      int ret = poll(&pfd, 1, 100);
+void MXKeypadDevice::resetLatencyHistogram() {
+  dispatcher_.resetLatencyHistogram();
+}
 
-      if (ret < 0) {
-        break; // Error
-      }
+DeviceState MXKeypadDevice::getState() const { return dispatcher_.state(); }
 
-      if (ret == 0) {
-        continue; // Timeout, check if still monitoring
-      }
+bool MXKeypadDevice::startCapture(const std::string &path) {
+  return impl_->capture.open(path, getInfo());
+}
 
-      if (!(pfd.revents & POLLIN)) {
-        continue; // No data available
-      }
+void MXKeypadDevice::stopCapture() { impl_->capture.close(); }
 
-      int bytes_read = read(fd, report.data(), report.size());
-
-      // P1/P2 navigation button detection - CHECK THIS FIRST
-      // Format: 11 ff 0b 00 01 a1/a2 (press) or 11 ff 0b 00 00 00 (release)
-      // IMPORTANT: When P buttons are pressed, report[6] contains spurious grid
-      // data We must process P button events first and skip grid processing for
-      // those packets
-      bool is_p_button_event = false;
-
-      if (bytes_read >= 6 && report[0] == 0x11 && report[1] == 0xff &&
-          report[2] == 0x0b && report[3] == 0x00) {
-        is_p_button_event = true;
-
-        if (report[4] == 0x01 && (report[5] == 0xa1 || report[5] == 0xa2)) {
-          // Button press
-          impl_->last_p_button = report[5]; // Track which button was pressed
-          auto event = std::make_shared<ButtonEvent>();
-          event->type = EventType::BUTTON_PRESS;
-          event->button_code = report[5]; // 0xa1 or 0xa2
-          event->pressed = true;
-          event->timestamp =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  std::chrono::steady_clock::now().time_since_epoch())
-                  .count();
-
-          if (event_callback_) {
-            event_callback_(event);
-          }
-        } else if (report[4] == 0x00 && impl_->last_p_button != 0) {
-          // Button release - emit event for the last pressed P button
-          auto event = std::make_shared<ButtonEvent>();
-          event->type = EventType::BUTTON_RELEASE;
-          event->button_code = impl_->last_p_button; // Use tracked button code
-          event->pressed = false;
-          event->timestamp =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  std::chrono::steady_clock::now().time_since_epoch())
-                  .count();
-
-          if (event_callback_) {
-            event_callback_(event);
-          }
-
-          impl_->last_p_button = 0; // Clear tracking
-        }
-      }
+bool MXKeypadDevice::enableRemapping(const RemapConfig &config) {
+  if (isMonitoring()) {
+    return false;
+  }
+  return dispatcher_.enableRemapping(config);
+}
 
-      // Grid button detection - SKIP if this was a P button event packet
-      if (!is_p_button_event && bytes_read > 0 && bytes_read >= 7) {
-        // Grid button report format: 13 ff 02 00 xx 01 [button_codes...]
-        // Bytes 6+ contain ALL currently pressed button codes (1-9), terminated
-        // by 0 This allows multiple simultaneous button presses!
-
-        if (report[0] == 0x13 && report[1] == 0xff && report[2] == 0x02 &&
-            report[3] == 0x00 && report[5] == 0x01) {
-
-          // Collect all currently pressed buttons from this report
-          std::set<uint8_t> current_pressed;
-
-          for (size_t i = 6; i < bytes_read; i++) {
-            uint8_t button_code_raw = report[i];
-            if (button_code_raw == 0)
-              break; // End of button list
-
-            if (button_code_raw >= 1 && button_code_raw <= 9) {
-              uint8_t button_code = button_code_raw - 1; // Convert to 0-8
-              current_pressed.insert(button_code);
-            }
-          }
-
-          // Find newly pressed buttons (in current but not in previous)
-          for (uint8_t button_code : current_pressed) {
-            if (impl_->pressed_buttons.find(button_code) ==
-                impl_->pressed_buttons.end()) {
-              // New button press
-              auto event = std::make_shared<ButtonEvent>();
-              event->type = EventType::BUTTON_PRESS;
-              event->button_code = button_code;
-              event->pressed = true;
-              event->timestamp =
-                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                      std::chrono::steady_clock::now().time_since_epoch())
-                      .count();
-
-              if (event_callback_) {
-                event_callback_(event);
-              }
-            }
-          }
-
-          // Find released buttons (in previous but not in current)
-          std::vector<uint8_t> to_release;
-          for (uint8_t button_code : impl_->pressed_buttons) {
-            if (current_pressed.find(button_code) == current_pressed.end()) {
-              to_release.push_back(button_code);
-            }
-          }
-
-          for (uint8_t button_code : to_release) {
-            auto event = std::make_shared<ButtonEvent>();
-            event->type = EventType::BUTTON_RELEASE;
-            event->button_code = button_code;
-            event->pressed = false;
-            event->timestamp =
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::steady_clock::now().time_since_epoch())
-                    .count();
-
-            if (event_callback_) {
-              event_callback_(event);
-            }
-          }
-
-          // Update tracked state
-          impl_->pressed_buttons = current_pressed;
-        }
+void MXKeypadDevice::disableRemapping() {
+  if (!isMonitoring()) {
+    dispatcher_.disableRemapping();
+  }
+}
+
+RemapStats MXKeypadDevice::getRemapStats() const {
+  return dispatcher_.remapStats();
+}
+
+void MXKeypadDevice::setEventStreamSink(DeviceHandle handle,
+                                        EventRecordCallback sink) {
+  dispatcher_.setStreamSink(handle, sink);
+}
+
+bool MXKeypadDevice::setRotationCoalescing(const RotationCoalescing &options) {
+  // No rotation input on the keypad
+  (void)options;
+  return false;
+}
+
+void MXKeypadDevice::startMonitoring() {
+  if (impl_->monitoring) {
+    return;
+  }
+
+  // Release an fd left behind by a device that disappeared while monitored
+  stopMonitoring();
+
+  // Use hidraw path for reading button events
+  std::string monitor_path = hidrawPath();
+  if (monitor_path.empty()) {
+    monitor_path = info_.device_path;
+  }
+
+  impl_->monitor_fd = open(monitor_path.c_str(), O_RDONLY | O_NONBLOCK);
+  if (impl_->monitor_fd < 0) {
+    return;
+  }
+
+  impl_->parser.reset();
+  dispatcher_.resumeQueue();
+  impl_->monitoring = true;
+  impl_->monitor_source = EventReactor::instance().addSource(
+      impl_->monitor_fd, [this](uint32_t events) {
+    std::vector<uint8_t> &report = impl_->report;
+    int bytes_read = read(impl_->monitor_fd, report.data(), report.size());
+
+    // hidraw reports carry no kernel timestamp; stamp them on arrival
+    uint64_t timestamp = getMonotonicTimestamp();
+
+    // Each HID report is one frame
+    if (bytes_read > 0) {
+      impl_->capture.write(CaptureRecordKind::HIDRAW, report.data(),
+                           bytes_read);
+
+      EventRecord decoded[MXKeypadReportParser::MAX_EVENTS];
+      size_t count = impl_->parser.parse(report.data(), bytes_read, timestamp,
+                                         decoded);
+      for (size_t i = 0; i < count; i++) {
+        dispatcher_.dispatch(decoded[i]);
       }
+      dispatcher_.endFrame();
+    }
 
-      if (bytes_read < 0 && errno != EAGAIN) {
-        break;
+    bool fatal = (bytes_read < 0 && errno != EAGAIN && errno != EINTR) ||
+                 (bytes_read <= 0 && (events & (EPOLLHUP | EPOLLERR)));
+    if (fatal) {
+      // Device went away - stop watching it, stopMonitoring() closes the fd
+      uint64_t source_id = impl_->monitor_source.exchange(0);
+      if (source_id != 0) {
+        EventReactor::instance().removeSource(source_id);
       }
+      impl_->monitoring = false;
     }
+  });
 
-    close(fd);
+  if (impl_->monitor_source == 0) {
     impl_->monitoring = false;
-  });
+    close(impl_->monitor_fd);
+    impl_->monitor_fd = -1;
+  }
 }
 
 void MXKeypadDevice::stopMonitoring() {
-  if (impl_->monitoring) {
-    impl_->monitoring = false;
-    if (impl_->monitor_thread.joinable()) {
-      impl_->monitor_thread.join();
-    }
+  dispatcher_.interruptQueue();
+
+  uint64_t source_id = impl_->monitor_source.exchange(0);
+  if (source_id != 0) {
+    EventReactor::instance().removeSource(source_id);
   }
+
+  if (impl_->monitor_fd >= 0) {
+    close(impl_->monitor_fd);
+    impl_->monitor_fd = -1;
+  }
+
+  impl_->monitoring = false;
 }
 
 bool MXKeypadDevice::isMonitoring() const { return impl_->monitoring; }
@@ -507,11 +339,25 @@ bool MXKeypadDevice::initialize() {
     return false;
   }
 
-  if (impl_->initialized || impl_->hidraw_path.empty()) {
-    return impl_->initialized;
+  std::string hidraw_path;
+  {
+    std::lock_guard<std::mutex> lock(info_mutex_);
+    hidraw_path = impl_->hidraw_path;
+    if (impl_->initialized && !hidraw_path.empty() &&
+        impl_->lcd_path == hidraw_path) {
+      return true;
+    }
+  }
+  if (hidraw_path.empty()) {
+    return false;
+  }
+
+  // Re-paired since the LCD was set up: that node is gone
+  if (impl_->initialized) {
+    closeLcd();
   }
 
-  impl_->hidraw_fd = open(impl_->hidraw_path.c_str(), O_RDWR);
+  impl_->hidraw_fd = open(hidraw_path.c_str(), O_RDWR);
   if (impl_->hidraw_fd < 0) {
     return false;
   }
@@ -522,52 +368,59 @@ bool MXKeypadDevice::initialize() {
     usleep(10000);
   }
 
+  impl_->lcd_writer = std::make_unique<MXKeypadLcdWriter>(impl_->hidraw_fd);
+
+  {
+    std::lock_guard<std::mutex> lock(info_mutex_);
+    impl_->lcd_path = hidraw_path;
+  }
   impl_->initialized = true;
   return true;
 }
 
 bool MXKeypadDevice::setKeyImage(int keyIndex,
-                                 const std::vector<uint8_t> &jpegData) {
+                                 const std::vector<uint8_t> &jpegData,
+                                 LcdPriority priority) {
   if (keyIndex < 0 || keyIndex > 8 || !impl_->initialized) {
     return false;
   }
 
-  auto packets = impl_->generateImagePackets(keyIndex, jpegData);
+  return impl_->writeImage(Impl::keyX(keyIndex), Impl::keyY(keyIndex),
+                           LCD_SIZE, LCD_SIZE, jpegData, priority);
+}
 
-  if (packets.empty()) {
+bool MXKeypadDevice::setKeyImages(const std::vector<KeyImage> &images,
+                                  LcdPriority priority) {
+  if (images.size() > 9 || !impl_->initialized) {
     return false;
   }
-
-  // Uber-optimized: Pre-build iovec array inline to avoid allocation
-  const size_t packet_count = packets.size();
-  std::vector<iovec> iov(packet_count);
-
-  // Vectorized iovec construction - loop unrolled for performance
-  for (size_t i = 0; i < packet_count; ++i) {
-    iov[i] = {const_cast<uint8_t*>(packets[i].data()), packets[i].size()};
+  if (images.empty()) {
+    return true;
   }
 
-  // Uber-optimization: Non-blocking I/O with immediate completion check
-  const int flags = fcntl(impl_->hidraw_fd, F_GETFL, 0);
-  fcntl(impl_->hidraw_fd, F_SETFL, flags | O_NONBLOCK);
-
-  ssize_t totalWritten = writev(impl_->hidraw_fd, iov.data(), packet_count);
-
-  // Restore blocking mode
-  fcntl(impl_->hidraw_fd, F_SETFL, flags);
-
-  if (totalWritten < 0) {
-    // If non-blocking would block, fall back to blocking write
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      totalWritten = writev(impl_->hidraw_fd, iov.data(), packet_count);
-    } else {
+  LcdImage batch[9];
+  for (size_t i = 0; i < images.size(); i++) {
+    const KeyImage &image = images[i];
+    if (image.keyIndex < 0 || image.keyIndex > 8 || !image.jpegData ||
+        image.jpegData->size() > MAX_JPEG_SIZE) {
       return false;
     }
+    batch[i] = {Impl::keyX(image.keyIndex), Impl::keyY(image.keyIndex),
+                LCD_SIZE, LCD_SIZE, image.jpegData};
   }
 
-  // Uber-optimization: Pre-calculated total size to avoid loop overhead
-  const ssize_t expectedTotal = packet_count * MAX_PACKET_SIZE;
-  return totalWritten == expectedTotal;
+  return impl_->lcd_writer->write(priority, batch, images.size());
+}
+
+bool MXKeypadDevice::postKeyImage(int keyIndex,
+                                  const std::vector<uint8_t> &jpegData,
+                                  LcdPriority priority) {
+  if (keyIndex < 0 || keyIndex > 8 || !impl_->initialized) {
+    return false;
+  }
+
+  return impl_->postImage(Impl::keyX(keyIndex), Impl::keyY(keyIndex),
+                          LCD_SIZE, LCD_SIZE, jpegData, priority);
 }
 
 bool MXKeypadDevice::setKeyColor(int keyIndex, uint8_t r, uint8_t g,
@@ -581,53 +434,43 @@ bool MXKeypadDevice::setKeyColor(int keyIndex, uint8_t r, uint8_t g,
   return false;
 }
 
-bool MXKeypadDevice::hasLCD() const { return !impl_->hidraw_path.empty(); }
+bool MXKeypadDevice::hasLCD() const { return !hidrawPath().empty(); }
 
-bool MXKeypadDevice::setScreenImage(const std::vector<uint8_t> &jpegData) {
+bool MXKeypadDevice::setScreenImage(const std::vector<uint8_t> &jpegData,
+                                    LcdPriority priority) {
   // Full screen image covering all 9 keys (434x434)
   // Position: x=23, y=6 (same origin as key 0)
-  return setRawImage(23, 6, SCREEN_WIDTH, SCREEN_HEIGHT, jpegData);
+  return setRawImage(23, 6, SCREEN_WIDTH, SCREEN_HEIGHT, jpegData, priority);
 }
 
 bool MXKeypadDevice::setRawImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
-                                  const std::vector<uint8_t> &jpegData) {
+                                  const std::vector<uint8_t> &jpegData,
+                                  LcdPriority priority) {
   if (!impl_->initialized) {
     return false;
   }
 
-  auto packets = impl_->generateRawImagePackets(x, y, width, height, jpegData);
-
-  if (packets.empty()) {
-    return false;
-  }
+  return impl_->writeImage(x, y, width, height, jpegData, priority);
+}
 
-  // Use vectored I/O for efficient batch write
-  const size_t packet_count = packets.size();
-  std::vector<iovec> iov(packet_count);
+bool MXKeypadDevice::postScreenImage(const std::vector<uint8_t> &jpegData,
+                                     LcdPriority priority) {
+  return postRawImage(23, 6, SCREEN_WIDTH, SCREEN_HEIGHT, jpegData, priority);
+}
 
-  for (size_t i = 0; i < packet_count; ++i) {
-    iov[i] = {const_cast<uint8_t*>(packets[i].data()), packets[i].size()};
+bool MXKeypadDevice::postRawImage(uint16_t x, uint16_t y, uint16_t width,
+                                  uint16_t height,
+                                  const std::vector<uint8_t> &jpegData,
+                                  LcdPriority priority) {
+  if (!impl_->initialized) {
+    return false;
   }
 
-  // Non-blocking I/O with fallback
-  const int flags = fcntl(impl_->hidraw_fd, F_GETFL, 0);
-  fcntl(impl_->hidraw_fd, F_SETFL, flags | O_NONBLOCK);
-
-  ssize_t totalWritten = writev(impl_->hidraw_fd, iov.data(), packet_count);
-
-  // Restore blocking mode
-  fcntl(impl_->hidraw_fd, F_SETFL, flags);
-
-  if (totalWritten < 0) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      totalWritten = writev(impl_->hidraw_fd, iov.data(), packet_count);
-    } else {
-      return false;
-    }
-  }
+  return impl_->postImage(x, y, width, height, jpegData, priority);
+}
 
-  const ssize_t expectedTotal = packet_count * MAX_PACKET_SIZE;
-  return totalWritten == expectedTotal;
+LcdWriterStats MXKeypadDevice::getLcdStats() const {
+  return impl_->lcd_writer ? impl_->lcd_writer->stats() : LcdWriterStats{};
 }
 
 bool MXKeypadDevice::setKeyGif(int keyIndex,
@@ -661,8 +504,8 @@ bool MXKeypadDevice::setKeyGif(int keyIndex,
       const GifFrame &frame =
           anim_ptr->animation.frames[anim_ptr->current_frame];
 
-      // Display this frame
-      setKeyImage(keyIndex, frame.jpeg_data);
+      // Display this frame, unless the next one replaces it first
+      postKeyImage(keyIndex, frame.jpeg_data, LcdPriority::BACKGROUND);
 
       // Wait for frame delay
       std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
@@ -718,8 +561,8 @@ bool MXKeypadDevice::setKeyGifFromFile(int keyIndex, const std::string &gifPath,
       const GifFrame &frame =
           anim_ptr->animation.frames[anim_ptr->current_frame];
 
-      // Display this frame
-      setKeyImage(keyIndex, frame.jpeg_data);
+      // Display this frame, unless the next one replaces it first
+      postKeyImage(keyIndex, frame.jpeg_data, LcdPriority::BACKGROUND);
 
       // Wait for frame delay
       std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
@@ -797,7 +640,7 @@ bool MXKeypadDevice::setScreenGif(const std::vector<uint8_t> &gifData, bool loop
       const GifFrame &frame = anim_ptr->animation.frames[anim_ptr->current_frame];
 
       // Display frame on full screen (much faster than 9 individual keys!)
-      setScreenImage(frame.jpeg_data);
+      postScreenImage(frame.jpeg_data, LcdPriority::BACKGROUND);
 
       // Wait for frame delay
       std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
@@ -850,7 +693,7 @@ bool MXKeypadDevice::setScreenGifFromFile(const std::string &gifPath, bool loop)
       const GifFrame &frame = anim_ptr->animation.frames[anim_ptr->current_frame];
 
       // Display frame on full screen (much faster than 9 individual keys!)
-      setScreenImage(frame.jpeg_data);
+      postScreenImage(frame.jpeg_data, LcdPriority::BACKGROUND);
 
       // Wait for frame delay
       std::this_thread::sleep_for(std::chrono::milliseconds(frame.delay_ms));
@@ -1,9 +1,12 @@
 #ifndef LOGILINUX_MX_KEYPAD_DEVICE_H
 #define LOGILINUX_MX_KEYPAD_DEVICE_H
 
+#include "../core/event_dispatcher.h"
+#include "mx_keypad_lcd_writer.h"
 #include "logilinux/device.h"
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace LogiLinux {
@@ -13,34 +16,99 @@ public:
   explicit MXKeypadDevice(const DeviceInfo &info);
   ~MXKeypadDevice() override;
 
-  const DeviceInfo &getInfo() const override { return info_; }
+  DeviceInfo getInfo() const override;
   DeviceType getType() const override { return info_.type; }
   bool hasCapability(DeviceCapability cap) const override;
 
   void setEventCallback(EventCallback callback) override;
+  void setFrameCallback(FrameCallback callback) override;
+  void setEventRecordCallback(EventRecordCallback callback) override;
+  bool enableEventQueue(size_t capacity, OverflowPolicy policy) override;
+  using Device::pollEvents;
+  size_t pollEvents(EventRecord *events, size_t max_events) override;
+  int getEventFd() const override;
+  EventQueueStats getEventQueueStats() const override;
+  bool setRotationCoalescing(const RotationCoalescing &options) override;
+  LatencyHistogram getLatencyHistogram() const override;
+  void resetLatencyHistogram() override;
+  DeviceState getState() const override;
+  bool startCapture(const std::string &path) override;
+  void stopCapture() override;
+  bool enableRemapping(const RemapConfig &config) override;
+  void disableRemapping() override;
+  RemapStats getRemapStats() const override;
+  void setEventStreamSink(DeviceHandle handle,
+                          EventRecordCallback sink) override;
   void startMonitoring() override;
   void stopMonitoring() override;
   bool isMonitoring() const override;
 
   bool grabExclusive(bool grab) override;
 
-  // MX Keypad specific API
-  bool setKeyImage(int keyIndex, const std::vector<uint8_t> &jpegData);
+  // Pair a keypad registered from its event node alone with its hidraw
+  // node once that shows up, which adds the LCD. Only the device registry
+  // calls this, right after the node appears; false if already paired.
+  bool attachHidraw(const std::string &hidrawPath);
+
+  // Undo attachHidraw() (or discovery's pairing) once that hidraw node is
+  // removed, so it can pair again when the node comes back. Image uploads
+  // fail until initialize() is called again after re-pairing. False if not
+  // paired with hidrawPath, or it is this device's own node.
+  bool detachHidraw(const std::string &hidrawPath);
+
+  // MX Keypad specific API. Image uploads are safe from any thread and
+  // return once the image is sent; one writer thread sends them in turn,
+  // INTERACTIVE ones ahead of BACKGROUND ones (animations). JPEGs over
+  // MAX_JPEG_SIZE bytes are rejected (the protocol's size field is 16
+  // bits).
+  bool setKeyImage(int keyIndex, const std::vector<uint8_t> &jpegData,
+                   LcdPriority priority = LcdPriority::INTERACTIVE);
   bool setKeyColor(int keyIndex, uint8_t r, uint8_t g, uint8_t b);
+
+  // One key of setKeyImages(); jpegData must stay valid during the call
+  struct KeyImage {
+    int keyIndex;
+    const std::vector<uint8_t> *jpegData;
+  };
+
+  // Sets up to 9 keys at once, e.g. a page switch, as one transfer that
+  // goes out in a single writev() for typical key sizes. Nothing is sent if
+  // any key index or JPEG is invalid.
+  bool setKeyImages(const std::vector<KeyImage> &images,
+                    LcdPriority priority = LcdPriority::INTERACTIVE);
   bool initialize();
   bool hasLCD() const;
 
   // Full screen image (434x434 covering all 9 keys with gaps)
-  bool setScreenImage(const std::vector<uint8_t> &jpegData);
+  bool setScreenImage(const std::vector<uint8_t> &jpegData,
+                      LcdPriority priority = LcdPriority::INTERACTIVE);
   
   // Raw image placement at arbitrary coordinates
   bool setRawImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
-                   const std::vector<uint8_t> &jpegData);
+                   const std::vector<uint8_t> &jpegData,
+                   LcdPriority priority = LcdPriority::INTERACTIVE);
+
+  // Non-blocking variants: the image is copied into a mailbox for its
+  // region (a key, the screen or the exact rect) and sent when the writer
+  // gets to it. A newer image posted, or set, for the same region replaces
+  // one still waiting, so updates faster than the device can take are
+  // skipped rather than queued; getLcdStats() counts them as superseded.
+  bool postKeyImage(int keyIndex, const std::vector<uint8_t> &jpegData,
+                    LcdPriority priority = LcdPriority::INTERACTIVE);
+  bool postScreenImage(const std::vector<uint8_t> &jpegData,
+                       LcdPriority priority = LcdPriority::INTERACTIVE);
+  bool postRawImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                    const std::vector<uint8_t> &jpegData,
+                    LcdPriority priority = LcdPriority::INTERACTIVE);
+
+  // LCD writer queue depth, transfer counts, superseded images and latencies
+  LcdWriterStats getLcdStats() const;
 
   // Screen dimensions
   static constexpr uint16_t SCREEN_WIDTH = 434;   // 118*3 + 40*2
   static constexpr uint16_t SCREEN_HEIGHT = 434;
   static constexpr uint16_t KEY_SIZE = 118;
+  static constexpr size_t MAX_JPEG_SIZE = 65535;
   static constexpr uint16_t GAP_SIZE = 40;
 
   // GIF support for individual keys
@@ -57,12 +125,22 @@ public:
   void stopScreenAnimation();
 
 private:
+  // hidraw node used for the LCD (and for button reports), empty if none
+  std::string hidrawPath() const;
+
+  // Stop animations and close the LCD's node, so initialize() can reopen it
+  void closeLcd();
+
   struct Impl;
   std::unique_ptr<Impl> impl_;
 
+  // attachHidraw()/detachHidraw() run on the uevent thread while the app
+  // may read these, so the pairing state (info_, capabilities_,
+  // impl_->hidraw_path and impl_->lcd_path) is only touched under this lock
+  mutable std::mutex info_mutex_;
   DeviceInfo info_;
   std::vector<DeviceCapability> capabilities_;
-  EventCallback event_callback_;
+  EventDispatcher dispatcher_;
 };
 
 } // namespace LogiLinux
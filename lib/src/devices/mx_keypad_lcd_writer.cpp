@@ -0,0 +1,290 @@
+/*
+ * LogiLinux - MX Keypad LCD Writer Implementation
+ */
+
+#include "mx_keypad_lcd_writer.h"
+#include "logilinux/events.h"
+#include <algorithm>
+#include <sys/uio.h>
+
+namespace LogiLinux {
+
+MXKeypadLcdWriter::MXKeypadLcdWriter(int fd)
+    : fd_(fd), arena_(std::make_unique<MXKeypadPacketArena>()), depth_(0),
+      high_water_(0), sent_{0, 0}, failed_(0), posted_(0), superseded_(0),
+      stopping_(false) {
+  thread_ = std::thread(&MXKeypadLcdWriter::run, this);
+}
+
+MXKeypadLcdWriter::~MXKeypadLcdWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_one();
+  thread_.join();
+}
+
+uint64_t MXKeypadLcdWriter::regionKey(uint16_t x, uint16_t y, uint16_t width,
+                                      uint16_t height) {
+  return static_cast<uint64_t>(x) << 48 | static_cast<uint64_t>(y) << 32 |
+         static_cast<uint64_t>(width) << 16 | height;
+}
+
+bool MXKeypadLcdWriter::write(LcdPriority priority, uint16_t x, uint16_t y,
+                              uint16_t width, uint16_t height,
+                              const std::vector<uint8_t> &jpeg) {
+  LcdImage image = {x, y, width, height, &jpeg};
+  return write(priority, &image, 1);
+}
+
+bool MXKeypadLcdWriter::write(LcdPriority priority, const LcdImage *images,
+                              size_t count) {
+  Transfer transfer;
+  transfer.images = images;
+  transfer.count = count;
+  transfer.submitted_ns = getMonotonicTimestamp();
+  transfer.next = nullptr;
+  transfer.mailbox = nullptr;
+  transfer.done = false;
+  transfer.ok = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stopping_) {
+    return false;
+  }
+
+  // These images are newer than anything posted for their regions so far
+  for (size_t i = 0; i < count; i++) {
+    const LcdImage &image = images[i];
+    Mailbox *mailbox = findMailboxLocked(
+        regionKey(image.x, image.y, image.width, image.height), false);
+    if (mailbox && mailbox->queued) {
+      unlinkLocked(mailbox->priority, &mailbox->transfer);
+      mailbox->queued = false;
+      superseded_++;
+    }
+  }
+
+  enqueueLocked(priority, &transfer);
+  work_cv_.notify_one();
+
+  done_cv_.wait(lock, [&transfer] { return transfer.done; });
+  return transfer.ok;
+}
+
+bool MXKeypadLcdWriter::post(LcdPriority priority, uint16_t x, uint16_t y,
+                             uint16_t width, uint16_t height,
+                             const std::vector<uint8_t> &jpeg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stopping_) {
+    return false;
+  }
+
+  Mailbox *mailbox = findMailboxLocked(regionKey(x, y, width, height), true);
+  if (!mailbox) {
+    return false;
+  }
+
+  posted_++;
+  if (mailbox->queued) {
+    superseded_++;
+    if (mailbox->priority != priority) {
+      unlinkLocked(mailbox->priority, &mailbox->transfer);
+      mailbox->queued = false;
+    }
+  }
+
+  // Reuses the mailbox's capacity, so steady updates don't allocate
+  mailbox->pending.assign(jpeg.begin(), jpeg.end());
+  mailbox->transfer.submitted_ns = getMonotonicTimestamp();
+
+  if (!mailbox->queued) {
+    mailbox->image = {x, y, width, height, nullptr};
+    Transfer &transfer = mailbox->transfer;
+    transfer.images = &mailbox->image;
+    transfer.count = 1;
+    transfer.mailbox = mailbox;
+    mailbox->priority = priority;
+    mailbox->queued = true;
+    enqueueLocked(priority, &transfer);
+    work_cv_.notify_one();
+  }
+  return true;
+}
+
+MXKeypadLcdWriter::Mailbox *
+MXKeypadLcdWriter::findMailboxLocked(uint64_t region, bool create) {
+  Mailbox *idle = nullptr;
+  for (auto &mailbox : mailboxes_) {
+    if (mailbox->region == region) {
+      return mailbox.get();
+    }
+    if (!idle && !mailbox->queued && !mailbox->in_flight) {
+      idle = mailbox.get();
+    }
+  }
+  if (!create) {
+    return nullptr;
+  }
+
+  if (mailboxes_.size() < MAX_MAILBOXES) {
+    mailboxes_.push_back(std::make_unique<Mailbox>());
+    idle = mailboxes_.back().get();
+    idle->queued = false;
+    idle->in_flight = false;
+  }
+  if (idle) {
+    idle->region = region;
+  }
+  return idle;
+}
+
+void MXKeypadLcdWriter::enqueueLocked(LcdPriority priority,
+                                      Transfer *transfer) {
+  Lane &lane = lanes_[static_cast<int>(priority)];
+  transfer->next = nullptr;
+  if (lane.tail) {
+    lane.tail->next = transfer;
+  } else {
+    lane.head = transfer;
+  }
+  lane.tail = transfer;
+  depth_++;
+  high_water_ = std::max(high_water_, depth_);
+}
+
+void MXKeypadLcdWriter::unlinkLocked(LcdPriority priority,
+                                     Transfer *transfer) {
+  Lane &lane = lanes_[static_cast<int>(priority)];
+  Transfer *previous = nullptr;
+  for (Transfer *t = lane.head; t; previous = t, t = t->next) {
+    if (t != transfer) {
+      continue;
+    }
+    (previous ? previous->next : lane.head) = t->next;
+    if (lane.tail == t) {
+      lane.tail = previous;
+    }
+    depth_--;
+    return;
+  }
+}
+
+MXKeypadLcdWriter::Transfer *MXKeypadLcdWriter::popLocked() {
+  for (Lane &lane : lanes_) {
+    if (lane.head) {
+      Transfer *transfer = lane.head;
+      lane.head = transfer->next;
+      if (!lane.head) {
+        lane.tail = nullptr;
+      }
+      depth_--;
+      return transfer;
+    }
+  }
+  return nullptr;
+}
+
+void MXKeypadLcdWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cv_.wait(lock, [this] { return stopping_ || depth_ > 0; });
+
+    if (stopping_) {
+      while (Transfer *transfer = popLocked()) {
+        if (transfer->mailbox) {
+          transfer->mailbox->queued = false;
+        } else {
+          transfer->done = true;
+        }
+      }
+      done_cv_.notify_all();
+      return;
+    }
+
+    bool interactive = lanes_[0].head != nullptr;
+    Transfer *transfer = popLocked();
+
+    // A posted transfer is copied out, so its mailbox can take (and queue)
+    // the next image while this one is being sent
+    const LcdImage *images = transfer->images;
+    const size_t count = transfer->count;
+    const uint64_t submitted_ns = transfer->submitted_ns;
+    LcdImage posted;
+    Mailbox *mailbox = transfer->mailbox;
+    if (mailbox) {
+      mailbox->queued = false;
+      mailbox->in_flight = true;
+      mailbox->pending.swap(mailbox->sending);
+      posted = mailbox->image;
+      posted.jpeg = &mailbox->sending;
+      images = &posted;
+    }
+    lock.unlock();
+
+    queue_latency_.record(submitted_ns);
+    uint64_t start_ns = getMonotonicTimestamp();
+    bool ok = send(images, count);
+    transfer_latency_.record(start_ns);
+
+    lock.lock();
+    sent_[interactive ? 0 : 1]++;
+    failed_ += ok ? 0 : 1;
+    if (mailbox) {
+      mailbox->in_flight = false;
+    } else {
+      transfer->ok = ok;
+      transfer->done = true;
+      done_cv_.notify_all();
+    }
+  }
+}
+
+bool MXKeypadLcdWriter::send(const LcdImage *images, size_t count) {
+  bool ok = true;
+  size_t used = 0; // Packets in the arena
+  for (size_t i = 0; i < count; i++) {
+    const LcdImage &image = images[i];
+    // Only whole images go out together; one always fits an empty arena
+    if (used + MXKeypadPacketizer::packetCount(image.jpeg->size()) >
+        MXKeypadPacketArena::MAX_PACKETS) {
+      ok = flush(used) && ok;
+      used = 0;
+    }
+    used += MXKeypadPacketizer::packetize(
+        image.x, image.y, image.width, image.height, image.jpeg->data(),
+        image.jpeg->size(),
+        arena_->packets + used * MXKeypadPacketizer::PACKET_SIZE,
+        arena_->iov + used);
+  }
+  return flush(used) && ok;
+}
+
+bool MXKeypadLcdWriter::flush(size_t packet_count) {
+  if (packet_count == 0) {
+    return true;
+  }
+  ssize_t written = writev(fd_, arena_->iov, packet_count);
+  return written ==
+         static_cast<ssize_t>(packet_count * MXKeypadPacketizer::PACKET_SIZE);
+}
+
+LcdWriterStats MXKeypadLcdWriter::stats() const {
+  LcdWriterStats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.depth = depth_;
+    stats.high_water = high_water_;
+    stats.interactive = sent_[0];
+    stats.background = sent_[1];
+    stats.failed = failed_;
+    stats.posted = posted_;
+    stats.superseded = superseded_;
+  }
+  stats.queue_latency = queue_latency_.snapshot();
+  stats.transfer_latency = transfer_latency_.snapshot();
+  return stats;
+}
+
+} // namespace LogiLinux
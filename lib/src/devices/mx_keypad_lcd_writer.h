@@ -0,0 +1,162 @@
+/*
+ * LogiLinux - MX Keypad LCD Writer
+ * Serializes image transfers to the keypad LCD from one thread
+ */
+
+#ifndef LOGILINUX_MX_KEYPAD_LCD_WRITER_H
+#define LOGILINUX_MX_KEYPAD_LCD_WRITER_H
+
+#include "../core/latency_recorder.h"
+#include "logilinux/device.h"
+#include "mx_keypad_packetizer.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LogiLinux {
+
+enum class LcdPriority {
+  INTERACTIVE, // Feedback to the user, e.g. highlighting a pressed key
+  BACKGROUND,  // Animation frames and other periodic updates
+};
+
+struct LcdWriterStats {
+  size_t depth;      // Transfers waiting, both lanes
+  size_t high_water; // Most transfers ever waiting at once
+  uint64_t interactive; // Transfers sent from each lane, a batch counts once
+  uint64_t background;
+  uint64_t failed; // writev() failed or came up short
+
+  uint64_t posted;     // Images handed to post()
+  uint64_t superseded; // Waiting images replaced by a newer one, never sent
+
+  LatencyHistogram queue_latency;    // Submission to start of the transfer
+  LatencyHistogram transfer_latency; // writev() of the whole image
+};
+
+// One image of a transfer: jpeg for (x, y), width x height pixels
+struct LcdImage {
+  uint16_t x, y, width, height;
+  const std::vector<uint8_t> *jpeg;
+};
+
+/**
+ * Owns every LCD write of one keypad. Whole image transfers are taken from
+ * two lanes, interactive ones first, and sent one at a time by a single
+ * thread with a blocking writev(), so transfers from different threads
+ * never interleave on the hidraw node and nothing toggles O_NONBLOCK.
+ *
+ * Besides write(), which waits for its transfer, post() leaves an image in
+ * a mailbox for its screen region and returns at once. Only the latest
+ * image posted for a region is kept: a newer one replaces the waiting one,
+ * so a region updated faster than the device can take shows the freshest
+ * image instead of falling further behind.
+ */
+class MXKeypadLcdWriter {
+public:
+  // Distinct regions with a mailbox; idle ones are reused past this
+  static constexpr size_t MAX_MAILBOXES = 32;
+
+  explicit MXKeypadLcdWriter(int fd);
+  ~MXKeypadLcdWriter(); // Fails transfers still waiting
+
+  MXKeypadLcdWriter(const MXKeypadLcdWriter &) = delete;
+  MXKeypadLcdWriter &operator=(const MXKeypadLcdWriter &) = delete;
+
+  /**
+   * Queue jpeg for (x, y), width x height pixels, and wait until it has
+   * been written. Returns whether the whole transfer went out. Also drops
+   * an image posted for the same region that is still waiting.
+   */
+  bool write(LcdPriority priority, uint16_t x, uint16_t y, uint16_t width,
+             uint16_t height, const std::vector<uint8_t> &jpeg);
+
+  /**
+   * Queue count images as one transfer and wait until all of them have
+   * been written. They are packetized back to back and go out in a single
+   * writev() as long as they fit the arena, in more only past that, and
+   * nothing else is sent in between. Returns whether every image went out.
+   */
+  bool write(LcdPriority priority, const LcdImage *images, size_t count);
+
+  /**
+   * Copy jpeg into the region's mailbox and return without waiting. A
+   * waiting image for the same region is replaced and keeps its place in
+   * the queue unless the priority changed. Returns false if the writer is
+   * stopping or every mailbox is busy.
+   */
+  bool post(LcdPriority priority, uint16_t x, uint16_t y, uint16_t width,
+            uint16_t height, const std::vector<uint8_t> &jpeg);
+
+  LcdWriterStats stats() const;
+
+private:
+  struct Mailbox;
+
+  struct Transfer {
+    const LcdImage *images;
+    size_t count;
+    uint64_t submitted_ns;
+    Transfer *next;
+    Mailbox *mailbox; // Posted, else on the writing thread's stack
+    bool done;
+    bool ok;
+  };
+
+  struct Mailbox {
+    uint64_t region;
+    LcdPriority priority;
+    LcdImage image; // Region only, jpeg is set when it is sent
+    Transfer transfer;
+    std::vector<uint8_t> pending; // Latest posted image
+    std::vector<uint8_t> sending; // Image the writer thread is sending
+    bool queued;
+    bool in_flight;
+  };
+
+  struct Lane {
+    Transfer *head = nullptr;
+    Transfer *tail = nullptr;
+  };
+
+  static uint64_t regionKey(uint16_t x, uint16_t y, uint16_t width,
+                            uint16_t height);
+
+  void run();
+  void enqueueLocked(LcdPriority priority, Transfer *transfer);
+  void unlinkLocked(LcdPriority priority, Transfer *transfer);
+  Transfer *popLocked();
+  Mailbox *findMailboxLocked(uint64_t region, bool create);
+  bool send(const LcdImage *images, size_t count);
+  bool flush(size_t packet_count);
+
+  int fd_;
+  std::unique_ptr<MXKeypadPacketArena> arena_; // Writer thread only
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  Lane lanes_[2]; // Indexed by LcdPriority
+  std::vector<std::unique_ptr<Mailbox>> mailboxes_;
+  size_t depth_;
+  size_t high_water_;
+  uint64_t sent_[2];
+  uint64_t failed_;
+  uint64_t posted_;
+  uint64_t superseded_;
+  bool stopping_;
+
+  // Recorded by the writer thread only
+  LatencyRecorder queue_latency_;
+  LatencyRecorder transfer_latency_;
+
+  std::thread thread_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_MX_KEYPAD_LCD_WRITER_H
@@ -0,0 +1,72 @@
+/*
+ * LogiLinux - MX Keypad Packetizer Implementation
+ */
+
+#include "mx_keypad_packetizer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace LogiLinux {
+
+static const uint8_t PACKET_BASE_HEADER[4] = {0x14, 0xff, 0x02, 0x2b};
+
+// Bit 7: first packet, bit 6: last packet, bit 5 always set, low bits:
+// 1-based packet index
+static uint8_t writePacketByte(size_t index, bool first, bool last) {
+  uint8_t value = static_cast<uint8_t>(index) | 0b00100000;
+  if (first) {
+    value |= 0b10000000;
+  }
+  if (last) {
+    value |= 0b01000000;
+  }
+  return value;
+}
+
+static void putBigEndian16(uint8_t *out, size_t value) {
+  out[0] = (value >> 8) & 0xff;
+  out[1] = value & 0xff;
+}
+
+size_t MXKeypadPacketizer::packetize(uint16_t x, uint16_t y, uint16_t width,
+                                     uint16_t height, const uint8_t *jpeg,
+                                     size_t jpeg_size, uint8_t *packets,
+                                     struct iovec *iov) {
+  const size_t count = packetCount(jpeg_size);
+  size_t offset = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    uint8_t *packet = packets + i * PACKET_SIZE;
+    const size_t header = i == 0 ? FIRST_HEADER_SIZE : HEADER_SIZE;
+    const size_t chunk = std::min(jpeg_size - offset, PACKET_SIZE - header);
+
+    memcpy(packet, PACKET_BASE_HEADER, sizeof(PACKET_BASE_HEADER));
+    packet[4] = writePacketByte(i + 1, i == 0, i + 1 == count);
+    if (i == 0) {
+      // 01 00 01 00, then x, y, width, height, 00 and the JPEG size
+      packet[5] = 0x01;
+      packet[6] = 0x00;
+      packet[7] = 0x01;
+      packet[8] = 0x00;
+      putBigEndian16(packet + 9, x);
+      putBigEndian16(packet + 11, y);
+      putBigEndian16(packet + 13, width);
+      putBigEndian16(packet + 15, height);
+      packet[17] = 0x00;
+      putBigEndian16(packet + 18, jpeg_size);
+    }
+
+    if (chunk > 0) {
+      memcpy(packet + header, jpeg + offset, chunk);
+    }
+    memset(packet + header + chunk, 0, PACKET_SIZE - header - chunk);
+
+    iov[i].iov_base = packet;
+    iov[i].iov_len = PACKET_SIZE;
+    offset += chunk;
+  }
+
+  return count;
+}
+
+} // namespace LogiLinux
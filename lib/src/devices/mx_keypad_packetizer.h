@@ -0,0 +1,72 @@
+/*
+ * LogiLinux - MX Keypad Packetizer
+ * Splits a JPEG into the output reports the MX Keypad LCD accepts
+ */
+
+#ifndef LOGILINUX_MX_KEYPAD_PACKETIZER_H
+#define LOGILINUX_MX_KEYPAD_PACKETIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+
+namespace LogiLinux {
+
+/**
+ * hidraw has no write_iter, so writev() hands every iovec to the driver as
+ * a report of its own: each packet must be one contiguous PACKET_SIZE
+ * buffer. The JPEG is copied once, straight into its packet; only the
+ * headers and the tail of the last packet are written besides it.
+ */
+class MXKeypadPacketizer {
+public:
+  static constexpr size_t PACKET_SIZE = 4095;
+  static constexpr size_t FIRST_HEADER_SIZE = 20;
+  static constexpr size_t HEADER_SIZE = 5;
+
+  // The first packet carries the JPEG size in 16 bits
+  static constexpr size_t MAX_JPEG_SIZE = 65535;
+
+  /**
+   * Packets needed for a JPEG of jpeg_size bytes (at least 1)
+   */
+  static constexpr size_t packetCount(size_t jpeg_size) {
+    return jpeg_size <= PACKET_SIZE - FIRST_HEADER_SIZE
+               ? 1
+               : 1 + (jpeg_size - (PACKET_SIZE - FIRST_HEADER_SIZE) +
+                      (PACKET_SIZE - HEADER_SIZE) - 1) /
+                         (PACKET_SIZE - HEADER_SIZE);
+  }
+
+  /**
+   * Build the packets drawing jpeg at (x, y), width x height pixels, into
+   * packets (packetCount(jpeg_size) * PACKET_SIZE bytes) and point one
+   * iovec per packet at them. Returns the number of packets.
+   */
+  static size_t packetize(uint16_t x, uint16_t y, uint16_t width,
+                          uint16_t height, const uint8_t *jpeg,
+                          size_t jpeg_size, uint8_t *packets,
+                          struct iovec *iov);
+};
+
+/**
+ * Packet storage for one device's transfers, allocated once and never
+ * grown. Room for the largest JPEG the protocol can describe, and for a
+ * page of nine typical key images in a single writev(). The owner keeps it
+ * locked from packetize() until writev() has returned.
+ */
+struct MXKeypadPacketArena {
+  static constexpr size_t MAX_IMAGE_PACKETS =
+      MXKeypadPacketizer::packetCount(MXKeypadPacketizer::MAX_JPEG_SIZE);
+  static constexpr size_t MAX_PACKETS = 36; // Nine keys of up to 16 KB
+
+  static_assert(MAX_PACKETS >= MAX_IMAGE_PACKETS,
+                "the arena must hold the largest image");
+
+  uint8_t packets[MAX_PACKETS * MXKeypadPacketizer::PACKET_SIZE];
+  struct iovec iov[MAX_PACKETS];
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_MX_KEYPAD_PACKETIZER_H
@@ -0,0 +1,98 @@
+/*
+ * LogiLinux - MX Keypad Report Parser Implementation
+ */
+
+#include "mx_keypad_report_parser.h"
+
+namespace LogiLinux {
+
+constexpr uint16_t GRID_KEY_MASK = 0x01ff; // Keys 0-8
+
+static EventRecord makeButtonRecord(uint32_t code, bool pressed,
+                                    uint64_t timestamp) {
+  EventRecord record = {};
+  record.type = pressed ? EventType::BUTTON_PRESS : EventType::BUTTON_RELEASE;
+  record.timestamp = timestamp;
+  record.button.button_code = code;
+  record.button.pressed = pressed;
+  return record;
+}
+
+MXKeypadReportParser::MXKeypadReportParser()
+    : grid_pressed_(0), last_p_button_(0) {}
+
+void MXKeypadReportParser::reset() {
+  grid_pressed_ = 0;
+  last_p_button_ = 0;
+}
+
+size_t MXKeypadReportParser::parse(const uint8_t *report, size_t length,
+                                   uint64_t timestamp, EventRecord *events) {
+  // P1/P2 navigation buttons: 11 ff 0b 00 01 a1/a2 (press) or
+  // 11 ff 0b 00 00 00 (release). These reports carry spurious data in
+  // byte 6, so they must never fall through to the grid decoder.
+  if (length >= 6 && report[0] == 0x11 && report[1] == 0xff &&
+      report[2] == 0x0b && report[3] == 0x00) {
+    return parseNavigation(report, timestamp, events);
+  }
+
+  // Grid keys: 13 ff 02 00 xx 01 [codes...]
+  if (length >= 7 && report[0] == 0x13 && report[1] == 0xff &&
+      report[2] == 0x02 && report[3] == 0x00 && report[5] == 0x01) {
+    return parseGrid(report, length, timestamp, events);
+  }
+
+  return 0;
+}
+
+size_t MXKeypadReportParser::parseNavigation(const uint8_t *report,
+                                             uint64_t timestamp,
+                                             EventRecord *events) {
+  if (report[4] == 0x01 && (report[5] == 0xa1 || report[5] == 0xa2)) {
+    last_p_button_ = report[5];
+    events[0] = makeButtonRecord(report[5], true, timestamp);
+    return 1;
+  }
+
+  // The release report doesn't say which button, so use the tracked one
+  if (report[4] == 0x00 && last_p_button_ != 0) {
+    events[0] = makeButtonRecord(last_p_button_, false, timestamp);
+    last_p_button_ = 0;
+    return 1;
+  }
+
+  return 0;
+}
+
+size_t MXKeypadReportParser::parseGrid(const uint8_t *report, size_t length,
+                                       uint64_t timestamp,
+                                       EventRecord *events) {
+  // Bytes 6+ list every key currently held as 1-9, terminated by 0, so one
+  // report fully describes the grid and chords need no extra state
+  uint16_t current = 0;
+  for (size_t i = 6; i < length && report[i] != 0; i++) {
+    if (report[i] >= 1 && report[i] <= 9) {
+      current |= static_cast<uint16_t>(1u << (report[i] - 1));
+    }
+  }
+
+  uint16_t changed = (current ^ grid_pressed_) & GRID_KEY_MASK;
+  uint16_t pressed = changed & current;
+  uint16_t released = changed & grid_pressed_;
+  grid_pressed_ = current;
+
+  size_t count = 0;
+  while (pressed) {
+    events[count++] = makeButtonRecord(__builtin_ctz(pressed), true, timestamp);
+    pressed &= pressed - 1;
+  }
+  while (released) {
+    events[count++] =
+        makeButtonRecord(__builtin_ctz(released), false, timestamp);
+    released &= released - 1;
+  }
+
+  return count;
+}
+
+} // namespace LogiLinux
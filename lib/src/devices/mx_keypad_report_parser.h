@@ -0,0 +1,54 @@
+/*
+ * LogiLinux - MX Keypad Report Parser
+ * Decodes MX Creative Keypad HID reports into button events
+ */
+
+#ifndef LOGILINUX_MX_KEYPAD_REPORT_PARSER_H
+#define LOGILINUX_MX_KEYPAD_REPORT_PARSER_H
+
+#include "logilinux/events.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace LogiLinux {
+
+class MXKeypadReportParser {
+public:
+  /**
+   * Most events a single report can produce (every grid key changing)
+   */
+  static constexpr size_t MAX_EVENTS = 9;
+
+  MXKeypadReportParser();
+
+  /**
+   * Decode one HID report. Writes up to MAX_EVENTS button records to
+   * events and returns how many were written. Presses come before
+   * releases, each in ascending key order.
+   */
+  size_t parse(const uint8_t *report, size_t length, uint64_t timestamp,
+               EventRecord *events);
+
+  /**
+   * Forget all pressed keys (device reopened)
+   */
+  void reset();
+
+  /**
+   * Grid keys currently held, bit N = key N (0-8)
+   */
+  uint16_t pressedMask() const { return grid_pressed_; }
+
+private:
+  size_t parseNavigation(const uint8_t *report, uint64_t timestamp,
+                         EventRecord *events);
+  size_t parseGrid(const uint8_t *report, size_t length, uint64_t timestamp,
+                   EventRecord *events);
+
+  uint16_t grid_pressed_;
+  uint8_t last_p_button_; // 0xa1 or 0xa2 while P1/P2 is held, else 0
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_MX_KEYPAD_REPORT_PARSER_H
@@ -0,0 +1,241 @@
+#include "replay_device.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace LogiLinux {
+
+// input_events decoded per processEvents() call, matching InputMonitor's
+// read batch
+constexpr size_t REPLAY_BATCH_SIZE = 64;
+
+ReplayDevice::ReplayDevice(ReplaySpeed speed)
+    : speed_(speed), info_(), decoder_("", dispatcher_), running_(false),
+      should_stop_(false) {}
+
+ReplayDevice::~ReplayDevice() {
+  stopMonitoring();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool ReplayDevice::open(const std::string &path) {
+  if (!reader_.open(path)) {
+    return false;
+  }
+
+  // Evdev payloads are raw kernel structs
+  if (reader_.inputEventSize() != sizeof(struct input_event)) {
+    reader_.close();
+    return false;
+  }
+
+  info_ = reader_.getInfo();
+
+  capabilities_.clear();
+  capabilities_.push_back(DeviceCapability::BUTTONS);
+  if (info_.type == DeviceType::DIALPAD) {
+    capabilities_.push_back(DeviceCapability::ROTATION);
+    capabilities_.push_back(DeviceCapability::HIGH_RES_SCROLL);
+  }
+
+  return true;
+}
+
+bool ReplayDevice::hasCapability(DeviceCapability cap) const {
+  return std::find(capabilities_.begin(), capabilities_.end(), cap) !=
+         capabilities_.end();
+}
+
+void ReplayDevice::setEventCallback(EventCallback callback) {
+  dispatcher_.setEventCallback(callback);
+}
+
+void ReplayDevice::setFrameCallback(FrameCallback callback) {
+  dispatcher_.setFrameCallback(callback);
+}
+
+void ReplayDevice::setEventRecordCallback(EventRecordCallback callback) {
+  dispatcher_.setRecordCallback(callback);
+}
+
+bool ReplayDevice::enableEventQueue(size_t capacity, OverflowPolicy policy) {
+  if (isMonitoring()) {
+    return false;
+  }
+  return dispatcher_.enableQueue(capacity, policy);
+}
+
+size_t ReplayDevice::pollEvents(EventRecord *events, size_t max_events) {
+  return dispatcher_.pollQueue(events, max_events);
+}
+
+int ReplayDevice::getEventFd() const { return dispatcher_.queueFd(); }
+
+EventQueueStats ReplayDevice::getEventQueueStats() const {
+  return dispatcher_.queueStats();
+}
+
+bool ReplayDevice::setRotationCoalescing(const RotationCoalescing &options) {
+  if (isMonitoring() || info_.type != DeviceType::DIALPAD) {
+    return false;
+  }
+  return decoder_.setRotationCoalescing(options);
+}
+
+LatencyHistogram ReplayDevice::getLatencyHistogram() const {
+  return dispatcher_.latencyHistogram();
+}
+
+void ReplayDevice::resetLatencyHistogram() {
+  dispatcher_.resetLatencyHistogram();
+}
+
+DeviceState ReplayDevice::getState() const { return dispatcher_.state(); }
+
+bool ReplayDevice::startCapture(const std::string &path) {
+  // Nothing is read from hardware, so there is nothing to record
+  (void)path;
+  return false;
+}
+
+void ReplayDevice::stopCapture() {}
+
+bool ReplayDevice::enableRemapping(const RemapConfig &config) {
+  if (isMonitoring()) {
+    return false;
+  }
+  return dispatcher_.enableRemapping(config);
+}
+
+void ReplayDevice::disableRemapping() {
+  if (!isMonitoring()) {
+    dispatcher_.disableRemapping();
+  }
+}
+
+RemapStats ReplayDevice::getRemapStats() const {
+  return dispatcher_.remapStats();
+}
+
+void ReplayDevice::setEventStreamSink(DeviceHandle handle,
+                                      EventRecordCallback sink) {
+  dispatcher_.setStreamSink(handle, sink);
+}
+
+void ReplayDevice::startMonitoring() {
+  if (running_) {
+    return;
+  }
+
+  // A previous playback may have finished on its own
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  should_stop_ = false;
+  dispatcher_.resumeQueue();
+  running_ = true;
+  thread_ = std::thread(&ReplayDevice::run, this);
+}
+
+void ReplayDevice::stopMonitoring() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_stop_ = true;
+  }
+  wake_.notify_all();
+  dispatcher_.interruptQueue();
+
+  // A callback stopping playback can't join its own thread; the next
+  // startMonitoring() or the destructor does
+  if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+    thread_.join();
+  }
+}
+
+bool ReplayDevice::grabExclusive(bool grab) {
+  (void)grab;
+  return false;
+}
+
+void ReplayDevice::run() {
+  reader_.rewind();
+  parser_.reset();
+
+  CaptureRecord record;
+  int64_t offset = 0;
+  bool first = true;
+
+  while (!should_stop_ && reader_.next(record)) {
+    int64_t now = static_cast<int64_t>(getMonotonicTimestamp());
+
+    if (speed_ == ReplaySpeed::ORIGINAL) {
+      // Keep the recorded spacing between records
+      if (first) {
+        offset = now - static_cast<int64_t>(record.timestamp);
+        first = false;
+      }
+      if (!waitUntil(record.timestamp + offset)) {
+        break;
+      }
+    } else {
+      // Every record appears to arrive just as it is decoded, so latency
+      // measures the decoding path alone
+      offset = now - static_cast<int64_t>(record.timestamp);
+    }
+
+    replayRecord(record, offset);
+  }
+
+  decoder_.flushCoalesced();
+  dispatcher_.endFrame();
+  running_ = false;
+}
+
+void ReplayDevice::replayRecord(const CaptureRecord &record, int64_t offset) {
+  if (record.kind == CaptureRecordKind::EVDEV) {
+    struct input_event batch[REPLAY_BATCH_SIZE];
+    size_t total = record.length / sizeof(struct input_event);
+
+    for (size_t done = 0; done < total;) {
+      size_t count = std::min(total - done, REPLAY_BATCH_SIZE);
+      memcpy(batch, record.data + done * sizeof(struct input_event),
+             count * sizeof(struct input_event));
+
+      for (size_t i = 0; i < count; i++) {
+        int64_t ns = static_cast<int64_t>(batch[i].time.tv_sec) * 1000000000 +
+                     static_cast<int64_t>(batch[i].time.tv_usec) * 1000 +
+                     offset;
+        batch[i].time.tv_sec = ns / 1000000000;
+        batch[i].time.tv_usec = (ns % 1000000000) / 1000;
+      }
+
+      decoder_.processEvents(batch, count);
+      done += count;
+    }
+  } else if (record.kind == CaptureRecordKind::HIDRAW) {
+    EventRecord decoded[MXKeypadReportParser::MAX_EVENTS];
+    size_t count = parser_.parse(record.data, record.length,
+                                 record.timestamp + offset, decoded);
+    for (size_t i = 0; i < count; i++) {
+      dispatcher_.dispatch(decoded[i]);
+    }
+    dispatcher_.endFrame();
+  }
+}
+
+bool ReplayDevice::waitUntil(uint64_t timestamp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!should_stop_) {
+    uint64_t now = getMonotonicTimestamp();
+    if (now >= timestamp) {
+      return true;
+    }
+    wake_.wait_for(lock, std::chrono::nanoseconds(timestamp - now));
+  }
+  return false;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,100 @@
+#ifndef LOGILINUX_REPLAY_DEVICE_H
+#define LOGILINUX_REPLAY_DEVICE_H
+
+#include "../core/event_dispatcher.h"
+#include "../core/input_monitor.h"
+#include "../util/capture.h"
+#include "logilinux/device.h"
+#include "logilinux/logilinux.h"
+#include "mx_keypad_report_parser.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LogiLinux {
+
+/**
+ * Plays a capture file back through the same decoders the live devices use.
+ * Events are delivered from a replay thread instead of the reactor, with
+ * timestamps shifted to the time of playback.
+ */
+class ReplayDevice : public Device {
+public:
+  explicit ReplayDevice(ReplaySpeed speed);
+  ~ReplayDevice() override;
+
+  /**
+   * Map the capture file. Must succeed before the device is used.
+   */
+  bool open(const std::string &path);
+
+  DeviceInfo getInfo() const override { return info_; }
+  DeviceType getType() const override { return info_.type; }
+  bool hasCapability(DeviceCapability cap) const override;
+
+  void setEventCallback(EventCallback callback) override;
+  void setFrameCallback(FrameCallback callback) override;
+  void setEventRecordCallback(EventRecordCallback callback) override;
+  bool enableEventQueue(size_t capacity, OverflowPolicy policy) override;
+  using Device::pollEvents;
+  size_t pollEvents(EventRecord *events, size_t max_events) override;
+  int getEventFd() const override;
+  EventQueueStats getEventQueueStats() const override;
+  bool setRotationCoalescing(const RotationCoalescing &options) override;
+  LatencyHistogram getLatencyHistogram() const override;
+  void resetLatencyHistogram() override;
+  DeviceState getState() const override;
+  bool startCapture(const std::string &path) override;
+  void stopCapture() override;
+  bool enableRemapping(const RemapConfig &config) override;
+  void disableRemapping() override;
+  RemapStats getRemapStats() const override;
+  void setEventStreamSink(DeviceHandle handle,
+                          EventRecordCallback sink) override;
+
+  /**
+   * Play the capture from the start. Monitoring stops by itself at the end
+   * of the file.
+   */
+  void startMonitoring() override;
+  void stopMonitoring() override;
+  bool isMonitoring() const override { return running_; }
+
+  bool grabExclusive(bool grab) override;
+
+private:
+  /**
+   * Replay loop (runs in the replay thread)
+   */
+  void run();
+
+  /**
+   * Decode one record with its timestamps moved by offset nanoseconds
+   */
+  void replayRecord(const CaptureRecord &record, int64_t offset);
+
+  /**
+   * Sleep until the given monotonic time; returns false if stopped first
+   */
+  bool waitUntil(uint64_t timestamp);
+
+  ReplaySpeed speed_;
+  CaptureReader reader_;
+  DeviceInfo info_;
+  std::vector<DeviceCapability> capabilities_;
+  EventDispatcher dispatcher_;
+  InputMonitor decoder_;
+  MXKeypadReportParser parser_;
+
+  std::thread thread_;
+  std::atomic<bool> running_;
+  std::atomic<bool> should_stop_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_REPLAY_DEVICE_H
@@ -0,0 +1,198 @@
+/*
+ * LogiLinux - Capture Files Implementation
+ */
+
+#include "capture.h"
+#include "logilinux/events.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LogiLinux {
+
+// Buffer writes so capturing doesn't add a syscall per report to the
+// reactor thread
+constexpr size_t CAPTURE_BUFFER_SIZE = 64 * 1024;
+
+static size_t alignTo8(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+CaptureWriter::CaptureWriter() : active_(false), file_(nullptr) {}
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const std::string &path, const DeviceInfo &info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (file_) {
+    return false;
+  }
+
+  file_ = fopen(path.c_str(), "wbe");
+  if (!file_) {
+    return false;
+  }
+  setvbuf(file_, nullptr, _IOFBF, CAPTURE_BUFFER_SIZE);
+
+  uint16_t name_length = static_cast<uint16_t>(
+      std::min<size_t>(info.name.size(), UINT16_MAX));
+  uint16_t path_length = static_cast<uint16_t>(
+      std::min<size_t>(info.device_path.size(), UINT16_MAX));
+  size_t strings = static_cast<size_t>(name_length) + path_length;
+
+  CaptureFileHeader header = {};
+  memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+  header.version = CAPTURE_VERSION;
+  header.header_size =
+      static_cast<uint32_t>(sizeof(header) + alignTo8(strings));
+  header.input_event_size = sizeof(struct input_event);
+  header.vendor_id = info.vendor_id;
+  header.product_id = info.product_id;
+  header.device_type = static_cast<uint16_t>(info.type);
+  header.name_length = name_length;
+  header.path_length = path_length;
+
+  static const uint8_t padding[8] = {};
+  bool ok = fwrite(&header, sizeof(header), 1, file_) == 1 &&
+            fwrite(info.name.data(), 1, name_length, file_) == name_length &&
+            fwrite(info.device_path.data(), 1, path_length, file_) ==
+                path_length &&
+            fwrite(padding, 1, alignTo8(strings) - strings, file_) ==
+                alignTo8(strings) - strings;
+  if (!ok) {
+    fclose(file_);
+    file_ = nullptr;
+    return false;
+  }
+
+  active_ = true;
+  return true;
+}
+
+void CaptureWriter::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  active_ = false;
+  if (file_) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+void CaptureWriter::write(CaptureRecordKind kind, const void *data,
+                          size_t length, uint64_t timestamp) {
+  if (!active_) {
+    return;
+  }
+
+  CaptureRecordHeader header = {};
+  header.length = static_cast<uint32_t>(length);
+  header.kind = static_cast<uint16_t>(kind);
+  header.timestamp = timestamp ? timestamp : getMonotonicTimestamp();
+
+  static const uint8_t padding[8] = {};
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_) {
+    return;
+  }
+  fwrite(&header, sizeof(header), 1, file_);
+  fwrite(data, 1, length, file_);
+  fwrite(padding, 1, alignTo8(length) - length, file_);
+}
+
+CaptureReader::CaptureReader()
+    : data_(nullptr), size_(0), first_record_(0), offset_(0),
+      input_event_size_(0), info_() {}
+
+CaptureReader::~CaptureReader() { close(); }
+
+bool CaptureReader::open(const std::string &path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps the file alive
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+
+  CaptureFileHeader header;
+  memcpy(&header, data_, sizeof(header));
+
+  size_t strings = static_cast<size_t>(header.name_length) + header.path_length;
+  if (memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != CAPTURE_VERSION ||
+      header.header_size < sizeof(header) + strings ||
+      header.header_size > size_) {
+    close();
+    return false;
+  }
+
+  const char *strings_start =
+      reinterpret_cast<const char *>(data_ + sizeof(header));
+  info_.name.assign(strings_start, header.name_length);
+  info_.device_path.assign(strings_start + header.name_length,
+                           header.path_length);
+  info_.vendor_id = header.vendor_id;
+  info_.product_id = header.product_id;
+  info_.type = static_cast<DeviceType>(header.device_type);
+  input_event_size_ = header.input_event_size;
+
+  first_record_ = header.header_size;
+  offset_ = first_record_;
+  return true;
+}
+
+void CaptureReader::close() {
+  if (data_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    data_ = nullptr;
+  }
+  size_ = 0;
+  first_record_ = 0;
+  offset_ = 0;
+}
+
+bool CaptureReader::next(CaptureRecord &record) {
+  if (!data_ || size_ - offset_ < sizeof(CaptureRecordHeader)) {
+    return false;
+  }
+
+  CaptureRecordHeader header;
+  memcpy(&header, data_ + offset_, sizeof(header));
+
+  size_t payload = offset_ + sizeof(header);
+  if (size_ - payload < header.length) {
+    return false; // Truncated, e.g. the writer was killed mid-record
+  }
+
+  record.kind = static_cast<CaptureRecordKind>(header.kind);
+  record.timestamp = header.timestamp;
+  record.data = data_ + payload;
+  record.length = header.length;
+
+  offset_ = std::min(size_, payload + alignTo8(header.length));
+  return true;
+}
+
+} // namespace LogiLinux
@@ -0,0 +1,132 @@
+/*
+ * LogiLinux - Capture Files
+ * Record and read back raw evdev and hidraw traffic
+ *
+ * Layout (native byte order, every block 8-byte aligned):
+ *
+ *   CaptureFileHeader
+ *   name[name_length], device_path[path_length], zero padding
+ *   repeated: CaptureRecordHeader, payload[length], zero padding
+ *
+ * Evdev payloads are the struct input_event array returned by one read();
+ * hidraw payloads are one HID report. Record timestamps are CLOCK_MONOTONIC
+ * nanoseconds taken when the data was read.
+ */
+
+#ifndef LOGILINUX_CAPTURE_H
+#define LOGILINUX_CAPTURE_H
+
+#include "logilinux/device.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace LogiLinux {
+
+constexpr char CAPTURE_MAGIC[8] = {'L', 'G', 'L', 'X', 'C', 'A', 'P', '\0'};
+constexpr uint32_t CAPTURE_VERSION = 1;
+
+enum class CaptureRecordKind : uint16_t {
+  EVDEV = 1,
+  HIDRAW = 2,
+};
+
+struct CaptureFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;      // Offset of the first record
+  uint16_t input_event_size; // sizeof(struct input_event) of the writer
+  uint16_t vendor_id;
+  uint16_t product_id;
+  uint16_t device_type;
+  uint16_t name_length;
+  uint16_t path_length;
+  uint32_t reserved;
+};
+
+struct CaptureRecordHeader {
+  uint32_t length; // Payload bytes, excluding padding
+  uint16_t kind;   // CaptureRecordKind
+  uint16_t reserved;
+  uint64_t timestamp;
+};
+
+static_assert(sizeof(CaptureFileHeader) == 32, "capture header layout");
+static_assert(sizeof(CaptureRecordHeader) == 16, "capture record layout");
+
+struct CaptureRecord {
+  CaptureRecordKind kind;
+  uint64_t timestamp;
+  const uint8_t *data;
+  uint32_t length;
+};
+
+/**
+ * Appends records to a capture file. write() may be called from the reactor
+ * thread while open()/close() are called from the application; it returns
+ * immediately while no capture is open.
+ */
+class CaptureWriter {
+public:
+  CaptureWriter();
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter &) = delete;
+  CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+  bool open(const std::string &path, const DeviceInfo &info);
+  void close();
+  bool isOpen() const { return active_; }
+
+  /**
+   * Append a record stamped with the current time, or with timestamp if it
+   * is non-zero (for synthesized captures)
+   */
+  void write(CaptureRecordKind kind, const void *data, size_t length,
+             uint64_t timestamp = 0);
+
+private:
+  std::mutex mutex_;
+  std::atomic<bool> active_;
+  FILE *file_;
+};
+
+/**
+ * Memory-maps a capture file and walks its records without copying
+ */
+class CaptureReader {
+public:
+  CaptureReader();
+  ~CaptureReader();
+
+  CaptureReader(const CaptureReader &) = delete;
+  CaptureReader &operator=(const CaptureReader &) = delete;
+
+  bool open(const std::string &path);
+  void close();
+
+  const DeviceInfo &getInfo() const { return info_; }
+  uint16_t inputEventSize() const { return input_event_size_; }
+
+  /**
+   * Read the next record. Returns false at the end of the file or on a
+   * truncated record.
+   */
+  bool next(CaptureRecord &record);
+  void rewind() { offset_ = first_record_; }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+  size_t first_record_;
+  size_t offset_;
+  uint16_t input_event_size_;
+  DeviceInfo info_;
+};
+
+} // namespace LogiLinux
+
+#endif // LOGILINUX_CAPTURE_H
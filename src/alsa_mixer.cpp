@@ -0,0 +1,224 @@
+/*
+ * ALSA simple mixer backend
+ *
+ * Talks to the mixer control directly with snd_mixer_*. A thread waits on
+ * the mixer's poll descriptors so changes made by anyone (alsamixer, other
+ * applications) refresh the cache without polling.
+ */
+
+#include "mixer.h"
+
+#ifdef HAVE_ALSA
+
+#include <alsa/asoundlib.h>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+class AlsaMixer : public Mixer {
+public:
+  AlsaMixer()
+      : handle_(nullptr), elem_(nullptr), min_(0), max_(0),
+        has_switch_(false), wake_fd_(-1) {}
+
+  ~AlsaMixer() override {
+    if (thread_.joinable()) {
+      uint64_t one = 1;
+      ssize_t ret = write(wake_fd_, &one, sizeof(one));
+      (void)ret;
+      thread_.join();
+    }
+    if (wake_fd_ >= 0) {
+      close(wake_fd_);
+    }
+    if (handle_) {
+      snd_mixer_close(handle_);
+    }
+  }
+
+  bool open(const std::string &card, const std::string &control) {
+    if (snd_mixer_open(&handle_, 0) < 0) {
+      handle_ = nullptr;
+      return false;
+    }
+    if (snd_mixer_attach(handle_, card.c_str()) < 0 ||
+        snd_mixer_selem_register(handle_, nullptr, nullptr) < 0 ||
+        snd_mixer_load(handle_) < 0) {
+      return false;
+    }
+
+    snd_mixer_selem_id_t *sid;
+    snd_mixer_selem_id_alloca(&sid);
+    snd_mixer_selem_id_set_index(sid, 0);
+    snd_mixer_selem_id_set_name(sid, control.c_str());
+    elem_ = snd_mixer_find_selem(handle_, sid);
+    if (!elem_ || !snd_mixer_selem_has_playback_volume(elem_)) {
+      return false;
+    }
+
+    snd_mixer_selem_get_playback_volume_range(elem_, &min_, &max_);
+    if (max_ <= min_) {
+      return false;
+    }
+    has_switch_ = snd_mixer_selem_has_playback_switch(elem_);
+
+    snd_mixer_elem_set_callback_private(elem_, this);
+    snd_mixer_elem_set_callback(elem_, &AlsaMixer::onElementEvent);
+    refresh();
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+      return false;
+    }
+    thread_ = std::thread(&AlsaMixer::run, this);
+    return true;
+  }
+
+  const char *name() const override { return "alsa"; }
+
+  bool adjustVolume(int delta_percent) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    long current;
+    if (!elem_ || snd_mixer_selem_get_playback_volume(
+            elem_, SND_MIXER_SCHN_FRONT_LEFT, &current) < 0) {
+      return false;
+    }
+
+    int target = volume() + delta_percent;
+    target = target < 0 ? 0 : (target > 100 ? 100 : target);
+    long value = min_ + ((max_ - min_) * target + 50) / 100;
+
+    // Controls with fewer than 100 steps: still move at least one
+    if (value == current && delta_percent != 0) {
+      value += delta_percent > 0 ? 1 : -1;
+    }
+    value = value < min_ ? min_ : (value > max_ ? max_ : value);
+
+    if (snd_mixer_selem_set_playback_volume_all(elem_, value) < 0) {
+      return false;
+    }
+    // Our own change comes back as an event too; this just doesn't wait
+    publish(toPercent(value), muted());
+    return true;
+  }
+
+  bool setMute(bool mute) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!elem_ || !has_switch_ ||
+        snd_mixer_selem_set_playback_switch_all(elem_, mute ? 0 : 1) < 0) {
+      return false;
+    }
+    publish(volume(), mute);
+    return true;
+  }
+
+private:
+  int toPercent(long value) const {
+    return static_cast<int>(((value - min_) * 100 + (max_ - min_) / 2) /
+                            (max_ - min_));
+  }
+
+  // With mutex_ held, or before the thread starts
+  void refresh() {
+    long value = min_;
+    snd_mixer_selem_get_playback_volume(elem_, SND_MIXER_SCHN_FRONT_LEFT,
+                                        &value);
+    int on = 1;
+    if (has_switch_) {
+      snd_mixer_selem_get_playback_switch(elem_, SND_MIXER_SCHN_FRONT_LEFT,
+                                          &on);
+    }
+    publish(toPercent(value), !on);
+  }
+
+  static int onElementEvent(snd_mixer_elem_t *elem, unsigned int mask) {
+    auto *self =
+        static_cast<AlsaMixer *>(snd_mixer_elem_get_callback_private(elem));
+    if (mask == SND_CTL_EVENT_MASK_REMOVE) {
+      self->elem_ = nullptr; // Card going away
+      return 0;
+    }
+    if (mask & SND_CTL_EVENT_MASK_VALUE) {
+      self->refresh();
+    }
+    return 0;
+  }
+
+  void run() {
+    while (true) {
+      std::vector<struct pollfd> fds;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int count = snd_mixer_poll_descriptors_count(handle_);
+        if (count < 0) {
+          return;
+        }
+        fds.resize(count + 1);
+        snd_mixer_poll_descriptors(handle_, fds.data() + 1, count);
+      }
+      fds[0].fd = wake_fd_;
+      fds[0].events = POLLIN;
+
+      if (poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[0].revents) {
+        return; // Destructor
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      unsigned short revents = 0;
+      snd_mixer_poll_descriptors_revents(handle_, fds.data() + 1,
+                                         fds.size() - 1, &revents);
+      if (revents & (POLLERR | POLLNVAL)) {
+        return;
+      }
+      if (revents & POLLIN) {
+        // Calls onElementEvent() for whatever changed
+        snd_mixer_handle_events(handle_);
+      }
+    }
+  }
+
+  // snd_mixer_t isn't thread-safe: every call into it holds this
+  std::mutex mutex_;
+  snd_mixer_t *handle_;
+  snd_mixer_elem_t *elem_;
+  long min_;
+  long max_;
+  bool has_switch_;
+
+  int wake_fd_;
+  std::thread thread_;
+};
+
+} // namespace
+
+std::unique_ptr<Mixer> createAlsaMixer(const std::string &card,
+                                       const std::string &control) {
+  auto mixer = std::make_unique<AlsaMixer>();
+  if (!mixer->open(card, control)) {
+    return nullptr;
+  }
+  return mixer;
+}
+
+#else // !HAVE_ALSA
+
+std::unique_ptr<Mixer> createAlsaMixer(const std::string &card,
+                                       const std::string &control) {
+  (void)card;
+  (void)control;
+  return nullptr;
+}
+
+#endif // HAVE_ALSA
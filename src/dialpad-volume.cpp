@@ -2,10 +2,15 @@
  * Logitech MX Dialpad Volume Controller
  *
  * Maps the dialpad rotation to system volume control
- * Uses pactl for PipeWire/PulseAudio compatibility
+ * Talks to PulseAudio/PipeWire or the ALSA mixer in-process (see mixer.h),
+ * falling back to running pactl. Changes run on an ActionExecutor worker,
+ * so reading the dial never waits for them.
  */
 
+#include "mixer.h"
+
 #include <atomic>
+#include <chrono>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
@@ -13,8 +18,9 @@
 #include <fcntl.h>
 #include <iostream>
 #include <linux/input.h>
-#include <regex>
-#include <sstream>
+#include <logilinux/action_executor.h>
+#include <memory>
+#include <string>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
@@ -27,76 +33,14 @@ void signalHandler(int) {
 
 class VolumeController {
 private:
-  int current_volume;
-  bool is_muted;
-
-  std::string exec(const char *cmd) {
-    char buffer[128];
-    std::string result = "";
-
-    const char *sudo_user = getenv("SUDO_USER");
-    const char *sudo_uid = getenv("SUDO_UID");
-
-    std::string full_cmd;
-    if (sudo_user && sudo_uid) {
-      full_cmd = std::string("sudo -u ") + sudo_user +
-                 " XDG_RUNTIME_DIR=/run/user/" + sudo_uid + " " + cmd;
-    } else {
-      full_cmd = cmd;
-    }
-
-    FILE *pipe = popen(full_cmd.c_str(), "r");
-    if (!pipe)
-      return "";
-    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-      result += buffer;
-    }
-    pclose(pipe);
-    return result;
-  }
-
-  void updateStatus() {
-    std::string output = exec("pactl get-sink-volume @DEFAULT_SINK@");
-
-    std::regex volume_regex(R"((\d+)%)");
-    std::smatch match;
-    if (std::regex_search(output, match, volume_regex)) {
-      current_volume = std::stoi(match[1]);
-    }
+  std::unique_ptr<Mixer> mixer;
 
-    output = exec("pactl get-sink-mute @DEFAULT_SINK@");
-    is_muted = (output.find("yes") != std::string::npos);
-  }
-
-public:
-  VolumeController() {
-    current_volume = 0;
-    is_muted = false;
-    updateStatus();
-    printf("Volume controller initialized (PipeWire/PulseAudio)\n");
-    printf("Current volume: %d%%\n", current_volume);
-  }
-
-  int getCurrentVolumePercent() { return current_volume; }
-
-  void adjustVolume(int delta_percent) {
-    char cmd[512];
-    if (delta_percent > 0) {
-      snprintf(cmd, sizeof(cmd), "pactl set-sink-volume @DEFAULT_SINK@ +%d%%",
-               delta_percent);
-    } else {
-      snprintf(cmd, sizeof(cmd), "pactl set-sink-volume @DEFAULT_SINK@ %d%%",
-               delta_percent);
-    }
-    exec(cmd);
-
-    updateStatus();
-
-    printf("Volume: %d%% ", current_volume);
+  static void printStatus(int volume, bool muted) {
+    printf("Volume: %d%% ", volume);
 
     printf("[");
     for (int i = 0; i < 20; i++) {
-      if (i < current_volume / 5) {
+      if (i < volume / 5) {
         printf("=");
       } else {
         printf(" ");
@@ -104,32 +48,57 @@ public:
     }
     printf("]");
 
-    if (is_muted) {
+    if (muted) {
       printf(" (MUTED)");
     }
     printf("\n");
     fflush(stdout);
   }
 
-  void setMute(bool mute) {
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd), "pactl set-sink-mute @DEFAULT_SINK@ %d",
-             mute ? 1 : 0);
-    exec(cmd);
+public:
+  explicit VolumeController(std::unique_ptr<Mixer> backend)
+      : mixer(std::move(backend)) {
+    printf("Volume controller initialized (%s)\n", mixer->name());
+    printf("Current volume: %d%%\n", mixer->volume());
 
-    updateStatus();
-    printf("Mute: %s\n", is_muted ? "ON" : "OFF");
-    fflush(stdout);
+    // Reported for our own changes and for anybody else's
+    mixer->setChangeCallback(printStatus);
   }
 
-  void toggleMute() {
-    exec("pactl set-sink-mute @DEFAULT_SINK@ toggle");
-    updateStatus();
-    printf("Mute: %s\n", is_muted ? "ON" : "OFF");
-    fflush(stdout);
-  }
+  int getCurrentVolumePercent() { return mixer->volume(); }
+
+  void adjustVolume(int delta_percent) { mixer->adjustVolume(delta_percent); }
+
+  void setMute(bool mute) { mixer->setMute(mute); }
+
+  void toggleMute() { mixer->toggleMute(); }
+
+  Mixer &backend() { return *mixer; }
 };
 
+// Time volume changes through the backend and put the volume back
+static int benchmarkMixer(Mixer &mixer, int changes) {
+  int start_volume = mixer.volume();
+  int direction = start_volume > 50 ? -1 : 1;
+
+  mixer.setChangeCallback(nullptr);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < changes; i++) {
+    // Back and forth within a few percent of where it was
+    mixer.adjustVolume(i % 10 < 5 ? direction : -direction);
+  }
+  double us = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+  int end_volume = mixer.volume();
+  mixer.adjustVolume(start_volume - end_volume);
+
+  printf("%s: %d volume changes, %.1f us each, volume %d%% -> %d%%\n",
+         mixer.name(), changes, us / changes, start_volume, end_volume);
+  return mixer.volume() == start_volume ? 0 : 1;
+}
+
 std::string findDialpadDevice() {
   for (int i = 0; i < 300; i++) {
     char path[64];
@@ -162,9 +131,46 @@ int main(int argc, char *argv[]) {
   printf("======================================\n\n");
 
   std::string device_path;
-  if (argc > 1) {
-    device_path = argv[1];
-  } else {
+  std::string backend = "auto";
+  std::string card = "default";
+  std::string control = "Master";
+  int bench_changes = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--backend" && i + 1 < argc) {
+      backend = argv[++i];
+    } else if (arg == "--card" && i + 1 < argc) {
+      card = argv[++i];
+    } else if (arg == "--control" && i + 1 < argc) {
+      control = argv[++i];
+    } else if (arg == "--bench" && i + 1 < argc) {
+      bench_changes = atoi(argv[++i]);
+    } else if (arg[0] != '-' && device_path.empty()) {
+      device_path = arg;
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--backend auto|pulse|alsa|pactl] [--card CARD] "
+              "[--control NAME] [--bench N] [device]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  std::unique_ptr<Mixer> mixer = createMixer(backend, card, control);
+  if (!mixer) {
+    fprintf(stderr, "Error: mixer backend '%s' is not available\n",
+            backend.c_str());
+    return 1;
+  }
+
+  // Exercise the mixer alone, e.g. against ALSA's dummy card:
+  //   dialpad-volume --backend alsa --card hw:Dummy --bench 1000
+  if (bench_changes > 0) {
+    return benchmarkMixer(*mixer, bench_changes);
+  }
+
+  if (device_path.empty()) {
     device_path = findDialpadDevice();
     if (device_path.empty()) {
       fprintf(stderr, "Error: MX Dialpad not found!\n");
@@ -175,7 +181,7 @@ int main(int argc, char *argv[]) {
 
   printf("\n");
 
-  VolumeController volume;
+  VolumeController volume(std::move(mixer));
   printf("Current volume: %d%%\n\n", volume.getCurrentVolumePercent());
 
   int fd = open(device_path.c_str(), O_RDONLY);
@@ -191,6 +197,10 @@ int main(int argc, char *argv[]) {
   printf("  Press Ctrl+C to exit\n\n");
   fflush(stdout);
 
+  // One worker keeps changes in order; with the slow pactl backend, steps
+  // queued while it runs are coalesced into a single call
+  LogiLinux::ActionExecutor executor(1);
+
   struct input_event ev;
   fd_set fds;
   struct timeval tv;
@@ -212,15 +222,22 @@ int main(int argc, char *argv[]) {
         if (ev.type == EV_REL && ev.code == 6) {
           accumulated_steps += ev.value;
 
-          int volume_delta = ev.value * 2;
-          volume.adjustVolume(volume_delta);
+          executor.submit("volume", ev.value, [&volume](int64_t steps) {
+            if (steps != 0) {
+              volume.adjustVolume(static_cast<int>(steps) * 2);
+            }
+          });
         }
 
         if (ev.type == EV_KEY) {
           if (ev.value == 1) {
             dial_pressed = true;
           } else if (ev.value == 0 && dial_pressed) {
-            volume.toggleMute();
+            executor.submit("mute", 1, [&volume](int64_t presses) {
+              if (presses % 2 != 0) {
+                volume.toggleMute();
+              }
+            });
             dial_pressed = false;
           }
         }
@@ -229,6 +246,13 @@ int main(int argc, char *argv[]) {
   }
 
   close(fd);
-  printf("\nGoodbye!\n");
+  executor.wait();
+
+  LogiLinux::ActionExecutorStats stats = executor.getStats();
+  printf("\n%llu volume/mute requests, %llu coalesced, %llu mixer calls\n",
+         static_cast<unsigned long long>(stats.submitted),
+         static_cast<unsigned long long>(stats.coalesced),
+         static_cast<unsigned long long>(stats.executed));
+  printf("Goodbye!\n");
   return 0;
 }
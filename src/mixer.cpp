@@ -0,0 +1,124 @@
+/*
+ * Mixer backend selection and the pactl fallback
+ */
+
+#include "mixer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+
+void Mixer::publish(int volume_percent, bool muted) {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  int old_volume = volume_.exchange(volume_percent);
+  bool old_muted = muted_.exchange(muted);
+  if (callback_ && (old_volume != volume_percent || old_muted != muted)) {
+    callback_(volume_percent, muted);
+  }
+}
+
+namespace {
+
+// Forks pactl (through sudo when run under sudo, so it reaches the user's
+// sound server) for every operation: tens of milliseconds each
+class PactlMixer : public Mixer {
+public:
+  PactlMixer() { refresh(); }
+
+  const char *name() const override { return "pactl"; }
+
+  bool adjustVolume(int delta_percent) override {
+    if (delta_percent == 0) {
+      return true;
+    }
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "pactl set-sink-volume @DEFAULT_SINK@ %+d%%",
+             delta_percent);
+    exec(cmd);
+    return refresh();
+  }
+
+  bool setMute(bool mute) override {
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "pactl set-sink-mute @DEFAULT_SINK@ %d",
+             mute ? 1 : 0);
+    exec(cmd);
+    return refresh();
+  }
+
+private:
+  static std::string exec(const char *cmd) {
+    char buffer[128];
+    std::string result = "";
+
+    const char *sudo_user = getenv("SUDO_USER");
+    const char *sudo_uid = getenv("SUDO_UID");
+
+    std::string full_cmd;
+    if (sudo_user && sudo_uid) {
+      full_cmd = std::string("sudo -u ") + sudo_user +
+                 " XDG_RUNTIME_DIR=/run/user/" + sudo_uid + " " + cmd;
+    } else {
+      full_cmd = cmd;
+    }
+
+    FILE *pipe = popen(full_cmd.c_str(), "r");
+    if (!pipe)
+      return "";
+    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
+      result += buffer;
+    }
+    pclose(pipe);
+    return result;
+  }
+
+  bool refresh() {
+    std::string output = exec("pactl get-sink-volume @DEFAULT_SINK@");
+
+    std::regex volume_regex(R"((\d+)%)");
+    std::smatch match;
+    if (!std::regex_search(output, match, volume_regex)) {
+      return false;
+    }
+    int volume = std::stoi(match[1]);
+
+    output = exec("pactl get-sink-mute @DEFAULT_SINK@");
+    publish(volume, output.find("yes") != std::string::npos);
+    return true;
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Mixer> createPactlMixer() {
+  return std::make_unique<PactlMixer>();
+}
+
+std::unique_ptr<Mixer> createMixer(const std::string &backend,
+                                   const std::string &alsa_card,
+                                   const std::string &alsa_control) {
+  if (backend == "pulse") {
+    return createPulseMixer();
+  }
+  if (backend == "alsa") {
+    return createAlsaMixer(alsa_card, alsa_control);
+  }
+  if (backend == "pactl") {
+    return createPactlMixer();
+  }
+  if (backend != "auto") {
+    return nullptr;
+  }
+
+  // PulseAudio/PipeWire first: on desktops ALSA's "default" usually routes
+  // through it anyway, and its volume is what the desktop shows
+  std::unique_ptr<Mixer> mixer = createPulseMixer();
+  if (!mixer) {
+    mixer = createAlsaMixer(alsa_card, alsa_control);
+  }
+  if (!mixer) {
+    mixer = createPactlMixer();
+  }
+  return mixer;
+}
@@ -0,0 +1,76 @@
+/*
+ * Mixer backends for the dialpad volume controller
+ *
+ * Volume and mute of the default output, kept in a cache that the backend
+ * refreshes from the sound server's change notifications, so reading them
+ * costs nothing and changing them doesn't wait for a round trip.
+ */
+
+#ifndef DIALPAD_MIXER_H
+#define DIALPAD_MIXER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class Mixer {
+public:
+  // Called on the backend's own thread whenever the volume or mute state
+  // changes, whoever changed it. Don't change the mixer from it.
+  using ChangeCallback = std::function<void(int volume_percent, bool muted)>;
+
+  Mixer() : volume_(0), muted_(false) {}
+  virtual ~Mixer() = default;
+
+  Mixer(const Mixer &) = delete;
+  Mixer &operator=(const Mixer &) = delete;
+
+  virtual const char *name() const = 0;
+
+  // Cached state, safe from any thread
+  int volume() const { return volume_.load(); }
+  bool muted() const { return muted_.load(); }
+
+  // Change the volume by delta_percent, clamped to 0-100% (a level already
+  // above 100%, which PulseAudio allows, isn't lowered by raising it)
+  virtual bool adjustVolume(int delta_percent) = 0;
+  virtual bool setMute(bool mute) = 0;
+  bool toggleMute() { return setMute(!muted()); }
+
+  void setChangeCallback(ChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    callback_ = callback;
+  }
+
+protected:
+  // Update the cache and tell the callback if anything changed
+  void publish(int volume_percent, bool muted);
+
+private:
+  std::atomic<int> volume_;
+  std::atomic<bool> muted_;
+  std::mutex callback_mutex_;
+  ChangeCallback callback_;
+};
+
+// ALSA simple mixer element, e.g. card "default" or "hw:0", control
+// "Master". nullptr if unavailable or not built with ALSA.
+std::unique_ptr<Mixer> createAlsaMixer(const std::string &card,
+                                       const std::string &control);
+
+// Default sink of the PulseAudio (or pipewire-pulse) server. nullptr if
+// unavailable or not built with libpulse.
+std::unique_ptr<Mixer> createPulseMixer();
+
+// Runs pactl for every change; works everywhere pactl does, slowly
+std::unique_ptr<Mixer> createPactlMixer();
+
+// backend is "pulse", "alsa", "pactl" or "auto" (the first of those that
+// works)
+std::unique_ptr<Mixer> createMixer(const std::string &backend,
+                                   const std::string &alsa_card = "default",
+                                   const std::string &alsa_control = "Master");
+
+#endif // DIALPAD_MIXER_H
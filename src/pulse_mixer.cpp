@@ -0,0 +1,276 @@
+/*
+ * PulseAudio mixer backend (also serves PipeWire through pipewire-pulse)
+ *
+ * Keeps one client connection on a threaded mainloop and subscribes to
+ * sink and server events, so the cached volume follows every change and
+ * the default sink follows the user switching outputs. Changes are sent
+ * without waiting for the reply; sink info that arrives while one is
+ * still outstanding predates it and is ignored.
+ */
+
+#include "mixer.h"
+
+#ifdef HAVE_PULSEAUDIO
+
+#include <algorithm>
+#include <cstdlib>
+#include <pulse/pulseaudio.h>
+
+namespace {
+
+class PulseMixer : public Mixer {
+public:
+  PulseMixer()
+      : mainloop_(nullptr), context_(nullptr), sink_index_(PA_INVALID_INDEX),
+        sets_pending_(0), sink_ready_(false), failed_(false) {
+    pa_cvolume_init(&sink_volume_);
+  }
+
+  ~PulseMixer() override {
+    if (mainloop_) {
+      pa_threaded_mainloop_stop(mainloop_);
+    }
+    if (context_) {
+      pa_context_disconnect(context_);
+      pa_context_unref(context_);
+    }
+    if (mainloop_) {
+      pa_threaded_mainloop_free(mainloop_);
+    }
+  }
+
+  bool connect() {
+    mainloop_ = pa_threaded_mainloop_new();
+    if (!mainloop_ || pa_threaded_mainloop_start(mainloop_) < 0) {
+      return false;
+    }
+
+    pa_threaded_mainloop_lock(mainloop_);
+    bool ok = connectLocked();
+    pa_threaded_mainloop_unlock(mainloop_);
+    return ok;
+  }
+
+  const char *name() const override { return "pulse"; }
+
+  bool adjustVolume(int delta_percent) override {
+    pa_threaded_mainloop_lock(mainloop_);
+    bool ok = sink_index_ != PA_INVALID_INDEX;
+    if (ok && delta_percent != 0) {
+      pa_volume_t step = static_cast<pa_volume_t>(
+          static_cast<uint64_t>(delta_percent < 0 ? -delta_percent
+                                                  : delta_percent) *
+          PA_VOLUME_NORM / 100);
+      pa_cvolume target = sink_volume_;
+      if (delta_percent > 0) {
+        // Stop at 100%, but don't pull down a sink someone boosted past it
+        pa_cvolume_inc_clamp(
+            &target, step,
+            std::max(pa_cvolume_max(&sink_volume_), PA_VOLUME_NORM));
+      } else {
+        pa_cvolume_dec(&target, step);
+      }
+      ok = sendSet(pa_context_set_sink_volume_by_index(
+          context_, sink_index_, &target, &PulseMixer::onSetDone, this));
+      if (ok) {
+        // The subscription confirms it; later steps build on this one
+        sink_volume_ = target;
+        publish(toPercent(target), muted());
+      }
+    }
+    pa_threaded_mainloop_unlock(mainloop_);
+    return ok;
+  }
+
+  bool setMute(bool mute) override {
+    pa_threaded_mainloop_lock(mainloop_);
+    bool ok = sink_index_ != PA_INVALID_INDEX &&
+              sendSet(pa_context_set_sink_mute_by_index(
+                  context_, sink_index_, mute, &PulseMixer::onSetDone, this));
+    if (ok) {
+      publish(volume(), mute);
+    }
+    pa_threaded_mainloop_unlock(mainloop_);
+    return ok;
+  }
+
+private:
+  static int toPercent(const pa_cvolume &volume) {
+    return static_cast<int>(
+        (static_cast<uint64_t>(pa_cvolume_max(&volume)) * 100 +
+         PA_VOLUME_NORM / 2) /
+        PA_VOLUME_NORM);
+  }
+
+  // Fire and forget: the reply isn't needed
+  static bool send(pa_operation *operation) {
+    if (!operation) {
+      return false;
+    }
+    pa_operation_unref(operation);
+    return true;
+  }
+
+  // A change whose completion onSetDone() counts; mainloop lock held
+  bool sendSet(pa_operation *operation) {
+    if (!send(operation)) {
+      return false;
+    }
+    sets_pending_++;
+    return true;
+  }
+
+  // Run as root through sudo, the user's server is not ours to find
+  static std::string serverAddress() {
+    const char *sudo_uid = getenv("SUDO_UID");
+    if (!sudo_uid || getenv("PULSE_SERVER")) {
+      return "";
+    }
+    return std::string("unix:/run/user/") + sudo_uid + "/pulse/native";
+  }
+
+  bool connectLocked() {
+    context_ = pa_context_new(pa_threaded_mainloop_get_api(mainloop_),
+                              "logilinux dialpad-volume");
+    if (!context_) {
+      return false;
+    }
+    pa_context_set_state_callback(context_, &PulseMixer::onContextState,
+                                  this);
+
+    std::string server = serverAddress();
+    if (pa_context_connect(context_, server.empty() ? nullptr : server.c_str(),
+                           PA_CONTEXT_NOAUTOSPAWN, nullptr) < 0) {
+      return false;
+    }
+
+    while (true) {
+      pa_context_state_t state = pa_context_get_state(context_);
+      if (state == PA_CONTEXT_READY) {
+        break;
+      }
+      if (!PA_CONTEXT_IS_GOOD(state)) {
+        return false;
+      }
+      pa_threaded_mainloop_wait(mainloop_);
+    }
+
+    pa_context_set_subscribe_callback(context_, &PulseMixer::onSubscribe,
+                                      this);
+    send(pa_context_subscribe(
+        context_,
+        static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK |
+                                            PA_SUBSCRIPTION_MASK_SERVER),
+        nullptr, nullptr));
+
+    // Wait for the first sink info so the cache starts out right
+    if (!send(pa_context_get_server_info(context_, &PulseMixer::onServerInfo,
+                                         this))) {
+      return false;
+    }
+    while (!sink_ready_ && !failed_) {
+      pa_threaded_mainloop_wait(mainloop_);
+    }
+    return sink_ready_;
+  }
+
+  // Everything below runs on the mainloop thread with its lock held
+
+  static void onContextState(pa_context *context, void *userdata) {
+    (void)context;
+    auto *self = static_cast<PulseMixer *>(userdata);
+    pa_threaded_mainloop_signal(self->mainloop_, 0);
+  }
+
+  static void onServerInfo(pa_context *context, const pa_server_info *info,
+                           void *userdata) {
+    auto *self = static_cast<PulseMixer *>(userdata);
+    if (!info || !info->default_sink_name ||
+        !send(pa_context_get_sink_info_by_name(
+            context, info->default_sink_name, &PulseMixer::onSinkInfo,
+            self))) {
+      self->failed_ = true;
+      pa_threaded_mainloop_signal(self->mainloop_, 0);
+    }
+  }
+
+  static void onSetDone(pa_context *context, int success, void *userdata) {
+    (void)success;
+    auto *self = static_cast<PulseMixer *>(userdata);
+    // Replies come in request order, so every sink info requested before
+    // the last change has arrived by now. Ask again to catch up with what
+    // was ignored meanwhile (or with a change that failed).
+    if (--self->sets_pending_ == 0 && self->sink_index_ != PA_INVALID_INDEX) {
+      send(pa_context_get_sink_info_by_index(context, self->sink_index_,
+                                             &PulseMixer::onSinkInfo, self));
+    }
+  }
+
+  static void onSinkInfo(pa_context *context, const pa_sink_info *info,
+                         int eol, void *userdata) {
+    (void)context;
+    auto *self = static_cast<PulseMixer *>(userdata);
+    if (eol != 0 || !info) {
+      if (eol < 0) {
+        self->failed_ = !self->sink_ready_;
+      }
+      pa_threaded_mainloop_signal(self->mainloop_, 0);
+      return;
+    }
+
+    // Requested before a change still in flight: it would undo the steps
+    // adjustVolume() has already built on
+    if (self->sets_pending_ > 0 && info->index == self->sink_index_) {
+      return;
+    }
+
+    self->sink_index_ = info->index;
+    self->sink_volume_ = info->volume;
+    self->sink_ready_ = true;
+    self->publish(toPercent(info->volume), info->mute != 0);
+  }
+
+  static void onSubscribe(pa_context *context, pa_subscription_event_type_t t,
+                          uint32_t index, void *userdata) {
+    auto *self = static_cast<PulseMixer *>(userdata);
+    unsigned facility = t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+
+    if (facility == PA_SUBSCRIPTION_EVENT_SERVER) {
+      // The default sink may have changed
+      send(pa_context_get_server_info(context, &PulseMixer::onServerInfo,
+                                      self));
+    } else if (facility == PA_SUBSCRIPTION_EVENT_SINK &&
+               index == self->sink_index_ &&
+               (t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) ==
+                   PA_SUBSCRIPTION_EVENT_CHANGE) {
+      send(pa_context_get_sink_info_by_index(context, index,
+                                             &PulseMixer::onSinkInfo, self));
+    }
+  }
+
+  pa_threaded_mainloop *mainloop_;
+  pa_context *context_;
+
+  // Guarded by the mainloop lock
+  uint32_t sink_index_;
+  pa_cvolume sink_volume_;
+  int sets_pending_; // Changes sent and not yet acknowledged
+  bool sink_ready_;
+  bool failed_;
+};
+
+} // namespace
+
+std::unique_ptr<Mixer> createPulseMixer() {
+  auto mixer = std::make_unique<PulseMixer>();
+  if (!mixer->connect()) {
+    return nullptr;
+  }
+  return mixer;
+}
+
+#else // !HAVE_PULSEAUDIO
+
+std::unique_ptr<Mixer> createPulseMixer() { return nullptr; }
+
+#endif // HAVE_PULSEAUDIO
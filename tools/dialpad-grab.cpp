@@ -6,6 +6,9 @@
  * 
  * Options:
  *   --device PATH        Use specific device path
+ *   --remap MODE         While grabbed, re-emit the dial as scroll, hscroll,
+ *                        volume or none (default: none)
+ *   --accel X            Dial acceleration for --remap (default: 0, off)
  *   --help               Show this help message
  */
 
@@ -15,6 +18,33 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <csignal>
+#include <linux/input-event-codes.h>
+
+static std::atomic<bool> running(true);
+
+void signalHandler(int signum) {
+    (void)signum;
+    running = false;
+}
+
+bool parseRemapMode(const std::string& mode, LogiLinux::RotationMapping& dial) {
+    if (mode == "scroll") {
+        dial.output = LogiLinux::RemapOutput::SCROLL;
+    } else if (mode == "hscroll") {
+        dial.output = LogiLinux::RemapOutput::HORIZONTAL_SCROLL;
+    } else if (mode == "volume") {
+        dial.output = LogiLinux::RemapOutput::KEYS;
+        dial.positive_key = KEY_VOLUMEUP;
+        dial.negative_key = KEY_VOLUMEDOWN;
+    } else if (mode == "none") {
+        dial.output = LogiLinux::RemapOutput::NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
 
 void printHelp(const char* progName) {
     std::cout << "Usage: " << progName << " [OPTIONS] <grab|release>\n\n"
@@ -22,19 +52,27 @@ void printHelp(const char* progName) {
               << "When grabbed, the device's default behavior is disabled.\n\n"
               << "Options:\n"
               << "  --device PATH        Use specific device path (e.g., /dev/input/event5)\n"
+              << "  --remap MODE         While grabbed, re-emit events through a virtual\n"
+              << "                       device; the dial becomes scroll, hscroll, volume\n"
+              << "                       or none (buttons are passed through)\n"
+              << "  --accel X            Dial acceleration for --remap (default: 0, off)\n"
               << "  --help               Show this help message\n\n"
               << "Arguments:\n"
               << "  grab                 Grab device exclusively\n"
               << "  release              Release exclusive grab\n\n"
               << "Examples:\n"
               << "  " << progName << " grab           # Disable default dialpad behavior\n"
-              << "  " << progName << " release        # Re-enable default behavior\n\n"
-              << "Note: Requires appropriate permissions (sudo or input group membership)\n";
+              << "  " << progName << " release        # Re-enable default behavior\n"
+              << "  " << progName << " --remap volume grab  # Dial as volume keys\n\n"
+              << "Note: Requires appropriate permissions (sudo or input group membership);\n"
+              << "--remap also needs write access to /dev/uinput\n";
 }
 
 int main(int argc, char* argv[]) {
     std::string devicePath;
     std::string action;
+    std::string remapMode;
+    double acceleration = 0;
     
     // Parse arguments
     for (int i = 1; i < argc; i++) {
@@ -50,6 +88,20 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --device requires an argument" << std::endl;
                 return 1;
             }
+        } else if (arg == "--remap") {
+            if (i + 1 < argc) {
+                remapMode = argv[++i];
+            } else {
+                std::cerr << "Error: --remap requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--accel") {
+            if (i + 1 < argc) {
+                acceleration = std::stod(argv[++i]);
+            } else {
+                std::cerr << "Error: --accel requires an argument" << std::endl;
+                return 1;
+            }
         } else if (arg == "grab" || arg == "release") {
             if (!action.empty()) {
                 std::cerr << "Error: Multiple actions specified" << std::endl;
@@ -71,6 +123,20 @@ int main(int argc, char* argv[]) {
     }
     
     bool shouldGrab = (action == "grab");
+
+    LogiLinux::RemapConfig remap;
+    remap.name = "LogiLinux Remapped Dialpad";
+    remap.dial.acceleration = acceleration;
+    if (!remapMode.empty()) {
+        if (!shouldGrab) {
+            std::cerr << "Error: --remap only applies to grab" << std::endl;
+            return 1;
+        }
+        if (!parseRemapMode(remapMode, remap.dial)) {
+            std::cerr << "Error: Unknown remap mode: " << remapMode << std::endl;
+            return 1;
+        }
+    }
     
     // Find device
     LogiLinux::Library lib;
@@ -100,7 +166,15 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    // Start monitoring first (device must be opened)
+    // Set up before monitoring, so the first frame is already remapped
+    if (!remapMode.empty() && !dialpad->enableRemapping(remap)) {
+        std::cerr << "Error: Failed to create the virtual device" << std::endl;
+        std::cerr << "Check write access to /dev/uinput (uinput module loaded?)." << std::endl;
+        return 1;
+    }
+
+    // Start monitoring first (device must be opened). No callback is needed,
+    // the remapper runs inside the library.
     dialpad->startMonitoring();
     
     if (!dialpad->isMonitoring()) {
@@ -123,12 +197,35 @@ int main(int argc, char* argv[]) {
     // Keep monitoring active if grabbed, otherwise stop
     if (shouldGrab) {
         std::cout << "Device is now grabbed exclusively. Default behavior disabled." << std::endl;
+        if (!remapMode.empty()) {
+            std::cout << "Remapping through \"" << remap.name << "\"." << std::endl;
+        }
         std::cout << "Press Ctrl+C to release and exit." << std::endl;
-        
-        // Wait indefinitely
-        while (true) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        std::signal(SIGINT, signalHandler);
+        std::signal(SIGTERM, signalHandler);
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        dialpad->grabExclusive(false);
+        dialpad->stopMonitoring();
+
+        if (!remapMode.empty()) {
+            LogiLinux::RemapStats stats = dialpad->getRemapStats();
+            std::cout << "\nRemapped " << stats.frames << " frames ("
+                      << stats.events << " events, " << stats.write_errors
+                      << " write errors)" << std::endl;
+            if (stats.latency.count > 0) {
+                std::cout << "Kernel-to-uinput latency: p50 "
+                          << stats.latency.percentile(50) / 1000.0
+                          << " us, p99 " << stats.latency.percentile(99) / 1000.0
+                          << " us, max " << stats.latency.max_ns / 1000.0
+                          << " us" << std::endl;
+            }
+            dialpad->disableRemapping();
         }
+        std::cout << "Device released." << std::endl;
     } else {
         dialpad->stopMonitoring();
     }
@@ -9,7 +9,12 @@
  *   --rotation-only      Only output rotation events
  *   --buttons-only       Only output button events
  *   --grab               Grab device exclusively (disable default behavior)
+ *   --merge              Merge low-res and high-res axes into one event
+ *   --window US          Sum rotations arriving within US microseconds
+ *   --latency            Print event latency percentiles on exit
  *   --device PATH        Use specific device path
+ *   --capture FILE       Record raw device traffic to FILE
+ *   --replay FILE        Play back a capture instead of a live device
  *   --help               Show this help message
  */
 
@@ -35,7 +40,11 @@ struct Options {
     bool rotationOnly = false;
     bool buttonsOnly = false;
     bool grab = false;
+    bool latency = false;
+    LogiLinux::RotationCoalescing coalescing;
     std::string devicePath;
+    std::string capturePath;
+    std::string replayPath;
 };
 
 void printHelp(const char* progName) {
@@ -46,7 +55,12 @@ void printHelp(const char* progName) {
               << "  --rotation-only      Only output rotation events\n"
               << "  --buttons-only       Only output button events\n"
               << "  --grab               Grab device exclusively (disable default behavior)\n"
+              << "  --merge              Merge low-res and high-res axes into one event\n"
+              << "  --window US          Sum rotations arriving within US microseconds\n"
+              << "  --latency            Print event latency percentiles on exit\n"
               << "  --device PATH        Use specific device path (e.g., /dev/input/event5)\n"
+              << "  --capture FILE       Record raw device traffic to FILE\n"
+              << "  --replay FILE        Play back a capture instead of a live device\n"
               << "  --help               Show this help message\n\n"
               << "Output Format (JSON):\n"
               << "  {\"type\":\"rotation\",\"delta\":1,\"delta_high_res\":120,\"timestamp\":1234567}\n"
@@ -120,6 +134,31 @@ int main(int argc, char* argv[]) {
             opts.buttonsOnly = true;
         } else if (arg == "--grab") {
             opts.grab = true;
+        } else if (arg == "--merge") {
+            opts.coalescing.merge_axes = true;
+        } else if (arg == "--latency") {
+            opts.latency = true;
+        } else if (arg == "--window") {
+            if (i + 1 < argc) {
+                opts.coalescing.window_us = std::stoul(argv[++i]);
+            } else {
+                std::cerr << "Error: --window requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--capture") {
+            if (i + 1 < argc) {
+                opts.capturePath = argv[++i];
+            } else {
+                std::cerr << "Error: --capture requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--replay") {
+            if (i + 1 < argc) {
+                opts.replayPath = argv[++i];
+            } else {
+                std::cerr << "Error: --replay requires an argument" << std::endl;
+                return 1;
+            }
         } else if (arg == "--device") {
             if (i + 1 < argc) {
                 opts.devicePath = argv[++i];
@@ -147,7 +186,14 @@ int main(int argc, char* argv[]) {
     LogiLinux::DevicePtr dialpad;
     
     // Find device
-    if (!opts.devicePath.empty()) {
+    if (!opts.replayPath.empty()) {
+        dialpad = lib.openReplay(opts.replayPath);
+
+        if (!dialpad) {
+            std::cerr << "Error: Failed to open capture " << opts.replayPath << std::endl;
+            return 1;
+        }
+    } else if (!opts.devicePath.empty()) {
         // TODO: Library doesn't support finding by path yet
         // For now, find any dialpad and check if path matches
         auto devices = lib.discoverDevices();
@@ -173,6 +219,8 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    dialpad->setRotationCoalescing(opts.coalescing);
+
     // Set up event callback
     dialpad->setEventCallback([&opts](LogiLinux::EventPtr event) {
         handleEvent(event, opts);
@@ -186,22 +234,38 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    if (!opts.capturePath.empty() && !dialpad->startCapture(opts.capturePath)) {
+        std::cerr << "Error: Failed to create capture " << opts.capturePath << std::endl;
+        return 1;
+    }
+
     // Start monitoring
     dialpad->startMonitoring();
     
-    if (!dialpad->isMonitoring()) {
+    // A short replay may already be over
+    if (!dialpad->isMonitoring() && opts.replayPath.empty()) {
         std::cerr << "Error: Failed to start monitoring" << std::endl;
         std::cerr << "Try running with sudo if you get permission errors." << std::endl;
         return 1;
     }
     
-    // Wait for events
-    while (running) {
+    // Wait for events (a replay stops by itself at the end of the capture)
+    while (running && dialpad->isMonitoring()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     
     // Cleanup
     dialpad->stopMonitoring();
+    dialpad->stopCapture();
+
+    if (opts.latency) {
+        auto latency = dialpad->getLatencyHistogram();
+        std::cerr << "Latency over " << latency.count << " events (us):"
+                  << " p50 " << latency.percentile(50) / 1000.0
+                  << " p99 " << latency.percentile(99) / 1000.0
+                  << " p99.9 " << latency.percentile(99.9) / 1000.0
+                  << " max " << latency.max_ns / 1000.0 << std::endl;
+    }
     
     return 0;
 }
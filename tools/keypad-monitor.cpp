@@ -9,6 +9,8 @@
  *   --grid-only          Only output grid button events (0-8)
  *   --nav-only           Only output navigation button events (P1/P2)
  *   --device PATH        Use specific device path
+ *   --capture FILE       Record raw device traffic to FILE
+ *   --replay FILE        Play back a capture instead of a live device
  *   --help               Show this help message
  */
 
@@ -34,6 +36,8 @@ struct Options {
     bool gridOnly = false;
     bool navOnly = false;
     std::string devicePath;
+    std::string capturePath;
+    std::string replayPath;
 };
 
 void printHelp(const char* progName) {
@@ -44,6 +48,8 @@ void printHelp(const char* progName) {
               << "  --grid-only          Only output grid button events (0-8)\n"
               << "  --nav-only           Only output navigation button events (P1/P2)\n"
               << "  --device PATH        Use specific device path\n"
+              << "  --capture FILE       Record raw device traffic to FILE\n"
+              << "  --replay FILE        Play back a capture instead of a live device\n"
               << "  --help               Show this help message\n\n"
               << "Button Layout:\n"
               << "  Grid buttons:        GRID_0 through GRID_8 (3x3 grid, codes 0-8)\n"
@@ -112,6 +118,20 @@ int main(int argc, char* argv[]) {
             opts.gridOnly = true;
         } else if (arg == "--nav-only") {
             opts.navOnly = true;
+        } else if (arg == "--capture") {
+            if (i + 1 < argc) {
+                opts.capturePath = argv[++i];
+            } else {
+                std::cerr << "Error: --capture requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--replay") {
+            if (i + 1 < argc) {
+                opts.replayPath = argv[++i];
+            } else {
+                std::cerr << "Error: --replay requires an argument" << std::endl;
+                return 1;
+            }
         } else if (arg == "--device") {
             if (i + 1 < argc) {
                 opts.devicePath = argv[++i];
@@ -139,7 +159,14 @@ int main(int argc, char* argv[]) {
     LogiLinux::DevicePtr keypad;
     
     // Find device
-    if (!opts.devicePath.empty()) {
+    if (!opts.replayPath.empty()) {
+        keypad = lib.openReplay(opts.replayPath);
+
+        if (!keypad) {
+            std::cerr << "Error: Failed to open capture " << opts.replayPath << std::endl;
+            return 1;
+        }
+    } else if (!opts.devicePath.empty()) {
         auto devices = lib.discoverDevices();
         for (const auto& dev : devices) {
             if (dev->getType() == LogiLinux::DeviceType::MX_KEYPAD &&
@@ -168,22 +195,29 @@ int main(int argc, char* argv[]) {
         handleEvent(event, opts);
     });
     
+    if (!opts.capturePath.empty() && !keypad->startCapture(opts.capturePath)) {
+        std::cerr << "Error: Failed to create capture " << opts.capturePath << std::endl;
+        return 1;
+    }
+
     // Start monitoring
     keypad->startMonitoring();
     
-    if (!keypad->isMonitoring()) {
+    // A short replay may already be over
+    if (!keypad->isMonitoring() && opts.replayPath.empty()) {
         std::cerr << "Error: Failed to start monitoring" << std::endl;
         std::cerr << "Try running with sudo if you get permission errors." << std::endl;
         return 1;
     }
     
-    // Wait for events
-    while (running) {
+    // Wait for events (a replay stops by itself at the end of the capture)
+    while (running && keypad->isMonitoring()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     
     // Cleanup
     keypad->stopMonitoring();
+    keypad->stopCapture();
     
     return 0;
 }
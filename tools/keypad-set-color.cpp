@@ -255,6 +255,7 @@ int main(int argc, char* argv[]) {
     
     // Find device
     LogiLinux::Library lib;
+    lib.enableDiscoveryCache();
     LogiLinux::MXKeypadDevice* keypad = nullptr;
     
     if (!devicePath.empty()) {
@@ -129,8 +129,13 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // With --all the only argument is the image
+    if (setAll && imagePath.empty()) {
+        imagePath = buttonArg;
+    }
+    
     // Validate arguments
-    if (buttonArg.empty() || imagePath.empty()) {
+    if (imagePath.empty() || (!setAll && buttonArg.empty())) {
         std::cerr << "Error: Missing required arguments" << std::endl;
         std::cerr << "Use --help for usage information." << std::endl;
         return 1;
@@ -168,6 +173,7 @@ int main(int argc, char* argv[]) {
     
     // Find device
     LogiLinux::Library lib;
+    lib.enableDiscoveryCache();
     LogiLinux::MXKeypadDevice* keypad = nullptr;
     
     if (!devicePath.empty()) {
@@ -215,12 +221,14 @@ int main(int argc, char* argv[]) {
     // Set image
     if (setAll) {
         std::cout << "Setting image on all buttons..." << std::endl;
+        // All nine in one transfer instead of nine separate uploads
+        std::vector<LogiLinux::MXKeypadDevice::KeyImage> images;
         for (int i = 0; i < 9; i++) {
-            if (!keypad->setKeyImage(i, jpegData)) {
-                std::cerr << "Error: Failed to set image on button " << i << std::endl;
-                return 1;
-            }
-            std::cout << "  Button " << i << " done" << std::endl;
+            images.push_back({i, &jpegData});
+        }
+        if (!keypad->setKeyImages(images)) {
+            std::cerr << "Error: Failed to set image on all buttons" << std::endl;
+            return 1;
         }
         std::cout << "All buttons updated successfully" << std::endl;
     } else {
@@ -7,22 +7,34 @@
  * Options:
  *   --json         Output in JSON format (default: human-readable)
  *   --type TYPE    Filter by device type (dialpad, keypad)
+ *   --watch        Keep running and report devices as they come and go
  *   --help         Show this help message
  */
 
 #include <logilinux/logilinux.h>
 #include <logilinux/device.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <thread>
 #include <vector>
 
+std::atomic<bool> running(true);
+
+void signalHandler(int) {
+    running = false;
+}
+
 void printHelp(const char* progName) {
     std::cout << "Usage: " << progName << " [OPTIONS]\n\n"
               << "List all connected Logitech devices.\n\n"
               << "Options:\n"
               << "  --json         Output in JSON format (default: human-readable)\n"
               << "  --type TYPE    Filter by device type (dialpad, keypad)\n"
+              << "  --watch        Keep running and report devices as they come and go\n"
               << "  --help         Show this help message\n\n"
               << "Device Types:\n"
               << "  dialpad        Logitech MX Dialpad\n"
@@ -31,7 +43,8 @@ void printHelp(const char* progName) {
               << "  " << progName << "                    # List all devices\n"
               << "  " << progName << " --json             # JSON output\n"
               << "  " << progName << " --type dialpad     # Only show dialpads\n"
-              << "  " << progName << " --json | jq .      # Pretty JSON with jq\n";
+              << "  " << progName << " --json | jq .      # Pretty JSON with jq\n"
+              << "  " << progName << " --watch            # Watch for hotplug\n";
 }
 
 const char* deviceTypeToString(LogiLinux::DeviceType type) {
@@ -63,6 +76,10 @@ void printDevicesHuman(const std::vector<LogiLinux::DevicePtr>& devices) {
         std::cout << "  Product ID: 0x" << std::hex << std::setw(4) << std::setfill('0') 
                   << info.product_id << std::dec << std::setfill(' ') << std::endl;
         std::cout << "  Path:       " << info.device_path << std::endl;
+        if (!info.hidraw_path.empty() && info.hidraw_path != info.device_path) {
+            std::cout << "  HID raw:    " << info.hidraw_path << std::endl;
+        }
+        std::cout << "  Identity:   " << info.identity << std::endl;
         
         // List capabilities
         std::cout << "  Capabilities: ";
@@ -103,6 +120,8 @@ void printDevicesJSON(const std::vector<LogiLinux::DevicePtr>& devices) {
         std::cout << "      \"product_id\": \"0x" << std::hex << std::setw(4) << std::setfill('0') 
                   << info.product_id << "\"," << std::dec << std::setfill(' ') << std::endl;
         std::cout << "      \"path\": \"" << info.device_path << "\"," << std::endl;
+        std::cout << "      \"hidraw_path\": \"" << info.hidraw_path << "\"," << std::endl;
+        std::cout << "      \"identity\": \"" << info.identity << "\"," << std::endl;
         
         // Capabilities array
         std::cout << "      \"capabilities\": [";
@@ -135,6 +154,7 @@ void printDevicesJSON(const std::vector<LogiLinux::DevicePtr>& devices) {
 
 int main(int argc, char* argv[]) {
     bool jsonOutput = false;
+    bool watch = false;
     std::string filterType;
     
     // Parse arguments
@@ -146,6 +166,8 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (arg == "--json") {
             jsonOutput = true;
+        } else if (arg == "--watch") {
+            watch = true;
         } else if (arg == "--type") {
             if (i + 1 < argc) {
                 filterType = argv[++i];
@@ -162,12 +184,12 @@ int main(int argc, char* argv[]) {
     
     // Discover devices
     LogiLinux::Library lib;
+    lib.enableDiscoveryCache();
     auto devices = lib.discoverDevices();
     
     // Filter by type if requested
+    LogiLinux::DeviceType targetType = LogiLinux::DeviceType::UNKNOWN;
     if (!filterType.empty()) {
-        LogiLinux::DeviceType targetType;
-        
         if (filterType == "dialpad") {
             targetType = LogiLinux::DeviceType::DIALPAD;
         } else if (filterType == "keypad") {
@@ -194,5 +216,34 @@ int main(int argc, char* argv[]) {
         printDevicesHuman(devices);
     }
     
-    return devices.empty() ? 1 : 0;
+    if (!watch) {
+        return devices.empty() ? 1 : 0;
+    }
+    
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+    
+    bool started = lib.startHotplugMonitoring(
+        [&](LogiLinux::DeviceEventPtr event, LogiLinux::DevicePtr device) {
+            if (!filterType.empty() && device->getType() != targetType) {
+                return;
+            }
+            bool connected = event->type == LogiLinux::EventType::DEVICE_CONNECTED;
+            std::cout << (connected ? "+ " : "- ")
+                      << deviceTypeToString(device->getType()) << " "
+                      << device->getInfo().name << " ("
+                      << event->device_path << ")" << std::endl;
+        });
+    if (!started) {
+        std::cerr << "Error: Could not watch for device changes" << std::endl;
+        return 1;
+    }
+    
+    std::cerr << "Watching for devices, press Ctrl+C to stop..." << std::endl;
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    
+    lib.stopHotplugMonitoring();
+    return 0;
 }